@@ -0,0 +1,138 @@
+#Copyright (c) Microsoft. All rights reserved.
+#Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#run by ctest for the tests of build_exe when use_test_result_cache is ON, as
+#   cmake -D CTRS_CACHE_ARGS_FILE=... -P ctrs_cached_test.cmake -- <test exe> [arguments...]
+#it runs the test exe unless a passing run with the same key is in the cache, in which case the test passes without running.
+#The key is a hash of the test exe, of the shared libraries it loads, of the CTRS_CACHE_INPUTS files, of the arguments, of CTRS_CACHE_ENVIRONMENT and
+#of every CTRS_* variable of the environment of the run.
+#A run that writes files (--report, --profile, --duration-history or their CTRS_* variables, CTRS_PERF_BASELINE_UPDATE) always runs and is not
+#recorded, a cached pass would not write them.
+#CTRS_CACHE_ARGS_FILE sets:
+#   CTRS_CACHE_DIR                              the directory of the cache, one file per passing run named after its key
+#   CTRS_CACHE_INPUTS                           files the tests read (DATA_FILES, CACHE_INPUTS, PERF_BASELINE of build_exe)
+#   CTRS_CACHE_ENVIRONMENT                      ENVIRONMENT entries of the tests
+#   CMAKE_GET_RUNTIME_DEPENDENCIES_PLATFORM     how to find the shared libraries of the exe, not set when they cannot be found (only the exe is hashed)
+#
+#run as cmake -D CTRS_CACHE_DIR=... -D CTRS_PRUNE_DAYS=n -P ctrs_cached_test.cmake it removes the entries not used for n days instead
+
+if(DEFINED CTRS_PRUNE_DAYS)
+    string(TIMESTAMP ctrs_now "%s" UTC)
+    math(EXPR ctrs_oldest "${ctrs_now} - (${CTRS_PRUNE_DAYS} * 24 * 60 * 60)")
+    file(GLOB ctrs_entries "${CTRS_CACHE_DIR}/*.passed")
+    set(ctrs_pruned_count 0)
+    foreach(ctrs_entry IN LISTS ctrs_entries)
+        file(TIMESTAMP ${ctrs_entry} ctrs_entry_time "%s" UTC)
+        if(ctrs_entry_time LESS ctrs_oldest)
+            file(REMOVE ${ctrs_entry})
+            math(EXPR ctrs_pruned_count "${ctrs_pruned_count} + 1")
+        endif()
+    endforeach()
+    message(STATUS "removed ${ctrs_pruned_count} test results not used for ${CTRS_PRUNE_DAYS} days from ${CTRS_CACHE_DIR}")
+    return()
+endif()
+
+include(${CTRS_CACHE_ARGS_FILE})
+
+#the test command is what follows --
+set(ctrs_command)
+set(ctrs_in_command OFF)
+math(EXPR ctrs_last_argument "${CMAKE_ARGC} - 1")
+foreach(ctrs_index RANGE ${ctrs_last_argument})
+    if(ctrs_in_command)
+        list(APPEND ctrs_command "${CMAKE_ARGV${ctrs_index}}")
+    elseif("${CMAKE_ARGV${ctrs_index}}" STREQUAL "--")
+        set(ctrs_in_command ON)
+    endif()
+endforeach()
+
+if(NOT ctrs_command)
+    message(FATAL_ERROR "no test command after -- (cmake -D CTRS_CACHE_ARGS_FILE=... -P ctrs_cached_test.cmake -- <test exe> [arguments...])")
+endif()
+
+list(GET ctrs_command 0 ctrs_executable)
+string(JOIN " " ctrs_command_line ${ctrs_command})
+
+#the CTRS_* variables of the environment, sorted, including the ones given by the caller of ctest and not only the ENVIRONMENT of the test
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E environment
+    OUTPUT_VARIABLE ctrs_environment_text
+)
+#a ; of a value would split its line, it is written as %3B in the key
+string(REPLACE ";" "%3B" ctrs_environment_text "${ctrs_environment_text}")
+string(REPLACE "\n" ";" ctrs_environment_lines "${ctrs_environment_text}")
+set(ctrs_environment)
+foreach(ctrs_environment_line IN LISTS ctrs_environment_lines)
+    if(ctrs_environment_line MATCHES "^CTRS_")
+        list(APPEND ctrs_environment "${ctrs_environment_line}")
+    endif()
+endforeach()
+list(SORT ctrs_environment)
+
+#the runs that write files are not cached
+set(ctrs_writes_files OFF)
+foreach(ctrs_argument IN LISTS ctrs_command)
+    if(ctrs_argument MATCHES "^--(report|profile|duration-history)(=|$)")
+        set(ctrs_writes_files ON)
+    endif()
+endforeach()
+foreach(ctrs_variable IN ITEMS CTRS_REPORT_FILE CTRS_PROFILE_DIR CTRS_PERF_BASELINE_UPDATE)
+    if(NOT "$ENV{${ctrs_variable}}" STREQUAL "")
+        set(ctrs_writes_files ON)
+    endif()
+endforeach()
+if((NOT "$ENV{CTRS_DURATION_HISTORY}" STREQUAL "") AND (NOT "$ENV{CTRS_DURATION_HISTORY}" STREQUAL "off"))
+    set(ctrs_writes_files ON)
+endif()
+
+if(ctrs_writes_files)
+    message("NOT CACHED: ${ctrs_command_line} writes a report, a profile, a duration history or a baseline, run without the cache")
+    execute_process(
+        COMMAND ${ctrs_command}
+        RESULT_VARIABLE ctrs_result
+    )
+    if(NOT ctrs_result EQUAL 0)
+        message(FATAL_ERROR "${ctrs_command_line} returned ${ctrs_result}")
+    endif()
+    return()
+endif()
+
+set(ctrs_libraries)
+if(DEFINED CMAKE_GET_RUNTIME_DEPENDENCIES_PLATFORM)
+    file(GET_RUNTIME_DEPENDENCIES
+        EXECUTABLES ${ctrs_executable}
+        RESOLVED_DEPENDENCIES_VAR ctrs_libraries
+        UNRESOLVED_DEPENDENCIES_VAR ctrs_unresolved_libraries
+    )
+endif()
+
+#paths are part of the key as well as contents, so that the same exe of two build trees gets two entries
+string(JOIN "\n" ctrs_key_text ${ctrs_command} ${CTRS_CACHE_ENVIRONMENT} ${ctrs_environment})
+foreach(ctrs_input IN LISTS ctrs_executable ctrs_libraries CTRS_CACHE_INPUTS)
+    if(EXISTS ${ctrs_input})
+        file(SHA256 ${ctrs_input} ctrs_input_hash)
+    else()
+        set(ctrs_input_hash "missing")
+    endif()
+    string(APPEND ctrs_key_text "\n${ctrs_input} ${ctrs_input_hash}")
+endforeach()
+string(SHA256 ctrs_key "${ctrs_key_text}")
+
+set(ctrs_entry "${CTRS_CACHE_DIR}/${ctrs_key}.passed")
+
+if(EXISTS ${ctrs_entry})
+    #the time of the entry is when it was last used, see CTRS_PRUNE_DAYS
+    file(TOUCH ${ctrs_entry})
+    message("CACHED: ${ctrs_command_line} passed with the same exe, libraries and inputs (${ctrs_entry}), not run again")
+else()
+    execute_process(
+        COMMAND ${ctrs_command}
+        RESULT_VARIABLE ctrs_result
+    )
+
+    if(NOT ctrs_result EQUAL 0)
+        message(FATAL_ERROR "${ctrs_command_line} returned ${ctrs_result}")
+    endif()
+
+    file(WRITE ${ctrs_entry} "${ctrs_key_text}\n")
+endif()
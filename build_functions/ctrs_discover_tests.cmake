@@ -0,0 +1,133 @@
+#Copyright (c) Microsoft. All rights reserved.
+#Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#run by build_exe (DISCOVER_TESTS) after the test exe is linked, as cmake -D CTRS_DISCOVER_ARGS_FILE=... -P ctrs_discover_tests.cmake
+#CTRS_DISCOVER_ARGS_FILE sets:
+#   CTRS_SUITE                 name of the suite, the ctest tests are named <suite>.<test function>
+#   CTRS_EXECUTABLE            the test exe (stock main, it knows --list-properties)
+#   CTRS_WORKING_DIRECTORY     where the tests run
+#   CTRS_TEST_PROPERTIES       properties given to every discovered test (name value pairs for set_tests_properties), what the
+#                              --list-properties of a test say wins over them (a RESOURCE_LOCK of a test is added to them)
+#   CTRS_TEST_ENVIRONMENT      ENVIRONMENT entries given to every discovered test
+#   CTRS_CTEST_FILE            the file written with the add_test calls, included by ctest through TEST_INCLUDE_FILES
+#   CTRS_TEST_COMMAND_PREFIX   what runs the exe, empty to run it directly (ctrs_cached_test.cmake with use_test_result_cache)
+#   CTRS_DURATION_HISTORY_FILE the --duration-history every discovered test records its duration in and the COST of the tests comes
+#                              from, empty for none
+#every test gets the TIMEOUT of its TEST_FUNCTION_TIMEOUT (plus CTRS_TIMEOUT_MARGIN_SECONDS, the runner fails it at its deadline and ctest
+#only steps in when the fixtures hang), the RESOURCE_LOCK of the tags of its RESOURCE_LOCKED_TEST_FUNCTION and the COST of its duration
+
+#what ctest gives a test past its own deadline to log its backtraces and report
+set(CTRS_TIMEOUT_MARGIN_SECONDS 30)
+
+include(${CTRS_DISCOVER_ARGS_FILE})
+
+set(ctrs_duration_history_args)
+if(NOT "${CTRS_DURATION_HISTORY_FILE}" STREQUAL "")
+    set(ctrs_duration_history_args --duration-history ${CTRS_DURATION_HISTORY_FILE})
+endif()
+
+execute_process(
+    COMMAND ${CTRS_EXECUTABLE} --list-properties ${ctrs_duration_history_args}
+    WORKING_DIRECTORY ${CTRS_WORKING_DIRECTORY}
+    OUTPUT_VARIABLE ctrs_list_output
+    ERROR_VARIABLE ctrs_list_error
+    RESULT_VARIABLE ctrs_list_result
+    TIMEOUT 60
+)
+
+if(NOT ctrs_list_result EQUAL 0)
+    message(FATAL_ERROR "failure listing the tests of ${CTRS_SUITE}: ${CTRS_EXECUTABLE} --list-properties returned ${ctrs_list_result}\n${ctrs_list_output}\n${ctrs_list_error}")
+endif()
+
+#bracket arguments keep test names, paths and property values exactly as they are
+set(ctrs_command_prefix "")
+foreach(ctrs_prefix_argument IN LISTS CTRS_TEST_COMMAND_PREFIX)
+    string(APPEND ctrs_command_prefix "[==[${ctrs_prefix_argument}]==] ")
+endforeach()
+set(ctrs_command_suffix "")
+foreach(ctrs_duration_history_argument IN LISTS ctrs_duration_history_args)
+    string(APPEND ctrs_command_suffix " [==[${ctrs_duration_history_argument}]==]")
+endforeach()
+
+#the properties of every test, as the fallback of what a test declares itself: a set_property(TEST) of the file would not find the tests
+#ctest adds, so every test gets all its properties in one set_tests_properties, with RESOURCE_LOCK and ENVIRONMENT as one list each
+set(ctrs_fallback_properties "")
+set(ctrs_fallback_timeout "")
+set(ctrs_fallback_cost "")
+set(ctrs_fallback_locks)
+set(ctrs_fallback_environment ${CTRS_TEST_ENVIRONMENT})
+list(LENGTH CTRS_TEST_PROPERTIES ctrs_property_count)
+set(ctrs_property_index 0)
+while(ctrs_property_index LESS ctrs_property_count)
+    list(GET CTRS_TEST_PROPERTIES ${ctrs_property_index} ctrs_property_name)
+    math(EXPR ctrs_property_index "${ctrs_property_index} + 1")
+    if(ctrs_property_index LESS ctrs_property_count)
+        list(GET CTRS_TEST_PROPERTIES ${ctrs_property_index} ctrs_property_value)
+    else()
+        set(ctrs_property_value "")
+    endif()
+    math(EXPR ctrs_property_index "${ctrs_property_index} + 1")
+
+    if(ctrs_property_name STREQUAL "RESOURCE_LOCK")
+        list(APPEND ctrs_fallback_locks ${ctrs_property_value})
+    elseif(ctrs_property_name STREQUAL "ENVIRONMENT")
+        list(APPEND ctrs_fallback_environment ${ctrs_property_value})
+    elseif(ctrs_property_name STREQUAL "TIMEOUT")
+        set(ctrs_fallback_timeout ${ctrs_property_value})
+    elseif(ctrs_property_name STREQUAL "COST")
+        set(ctrs_fallback_cost ${ctrs_property_value})
+    else()
+        string(APPEND ctrs_fallback_properties " [==[${ctrs_property_name}]==] [==[${ctrs_property_value}]==]")
+    endif()
+endwhile()
+
+set(ctrs_ctest_content "#generated by ctrs_discover_tests.cmake from ${CTRS_EXECUTABLE} --list-properties, do not edit\n")
+set(ctrs_test_count 0)
+string(REPLACE "\n" ";" ctrs_list_lines "${ctrs_list_output}")
+foreach(ctrs_line IN LISTS ctrs_list_lines)
+    string(STRIP "${ctrs_line}" ctrs_line)
+    #name<TAB>timeout<TAB>locks<TAB>cost, TEST_FUNCTION names are C identifiers, anything else on stdout is not a test
+    if(ctrs_line MATCHES "^([A-Za-z_][A-Za-z0-9_]*)\t([0-9]+)(\\.[0-9]*)?\t([^\t]*)\t([0-9.]+)$")
+        set(ctrs_test_name ${CMAKE_MATCH_1})
+        set(ctrs_timeout_whole_seconds ${CMAKE_MATCH_2})
+        set(ctrs_timeout_seconds ${CMAKE_MATCH_2}${CMAKE_MATCH_3})
+        string(REPLACE "," ";" ctrs_locks "${CMAKE_MATCH_4}")
+        set(ctrs_cost ${CMAKE_MATCH_5})
+
+        set(ctrs_timeout ${ctrs_fallback_timeout})
+        if(ctrs_timeout_seconds GREATER 0)
+            #rounded up
+            math(EXPR ctrs_timeout "${ctrs_timeout_whole_seconds} + 1 + ${CTRS_TIMEOUT_MARGIN_SECONDS}")
+        endif()
+        if(NOT ctrs_cost GREATER 0)
+            set(ctrs_cost ${ctrs_fallback_cost})
+        endif()
+        list(APPEND ctrs_locks ${ctrs_fallback_locks})
+
+        set(ctrs_ctest_name "${CTRS_SUITE}.${ctrs_test_name}")
+        string(APPEND ctrs_ctest_content "add_test([==[${ctrs_ctest_name}]==] ${ctrs_command_prefix}[==[${CTRS_EXECUTABLE}]==] [==[${ctrs_test_name}]==]${ctrs_command_suffix})\n")
+        string(APPEND ctrs_ctest_content "set_tests_properties([==[${ctrs_ctest_name}]==] PROPERTIES WORKING_DIRECTORY [==[${CTRS_WORKING_DIRECTORY}]==] LABELS [==[${CTRS_SUITE}]==]${ctrs_fallback_properties}")
+        if(NOT "${ctrs_timeout}" STREQUAL "")
+            string(APPEND ctrs_ctest_content " TIMEOUT [==[${ctrs_timeout}]==]")
+        endif()
+        if(NOT "${ctrs_cost}" STREQUAL "")
+            string(APPEND ctrs_ctest_content " COST [==[${ctrs_cost}]==]")
+        endif()
+        if(ctrs_locks)
+            string(APPEND ctrs_ctest_content " RESOURCE_LOCK [==[${ctrs_locks}]==]")
+        endif()
+        if(ctrs_fallback_environment)
+            string(APPEND ctrs_ctest_content " ENVIRONMENT [==[${ctrs_fallback_environment}]==]")
+        endif()
+        string(APPEND ctrs_ctest_content ")\n")
+        math(EXPR ctrs_test_count "${ctrs_test_count} + 1")
+    endif()
+endforeach()
+
+if(ctrs_test_count EQUAL 0)
+    #keep an empty suite visible instead of silently running nothing
+    string(APPEND ctrs_ctest_content "add_test([==[${CTRS_SUITE}]==] ${ctrs_command_prefix}[==[${CTRS_EXECUTABLE}]==])\n")
+    string(APPEND ctrs_ctest_content "set_tests_properties([==[${CTRS_SUITE}]==] PROPERTIES WORKING_DIRECTORY [==[${CTRS_WORKING_DIRECTORY}]==])\n")
+endif()
+
+file(WRITE ${CTRS_CTEST_FILE} "${ctrs_ctest_content}")
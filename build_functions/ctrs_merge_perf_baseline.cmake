@@ -0,0 +1,76 @@
+#Copyright (c) Microsoft. All rights reserved.
+#Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#run by the <suite>_update_baseline targets of build_exe, as
+#   cmake -D CTRS_BASELINE_FILE=<baseline> -D CTRS_NEW_BASELINE_FILE=<medians of a fresh run> -P ctrs_merge_perf_baseline.cmake
+#it writes the fresh medians into the baseline and keeps the rest of it: comments, empty lines, the tolerance column of a line and
+#whatever follows it. A benchmark that is not in the baseline yet gets a line at the end, a line of a benchmark that was not run stays as it was.
+#When there is no baseline yet, the fresh medians become the baseline.
+
+if((NOT DEFINED CTRS_BASELINE_FILE) OR (NOT DEFINED CTRS_NEW_BASELINE_FILE))
+    message(FATAL_ERROR "usage: cmake -D CTRS_BASELINE_FILE=... -D CTRS_NEW_BASELINE_FILE=... -P ctrs_merge_perf_baseline.cmake")
+endif()
+
+if(NOT EXISTS ${CTRS_NEW_BASELINE_FILE})
+    message(FATAL_ERROR "${CTRS_NEW_BASELINE_FILE} was not written, the suite has no benchmark or did not record its medians")
+endif()
+
+#the lines of file, a ; of a line is kept as the character 1 so that it does not split the line
+function(read_lines file out_lines)
+    string(ASCII 1 semicolon)
+    file(READ ${file} text)
+    string(REPLACE "\r\n" "\n" text "${text}")
+    string(REGEX REPLACE "\n$" "" text "${text}")
+    string(REPLACE ";" "${semicolon}" text "${text}")
+    string(REPLACE "\n" ";" lines "${text}")
+    set(${out_lines} "${lines}" PARENT_SCOPE)
+endfunction()
+
+#the fresh medians, as ctrs_new_median_<name>, in the order of the run
+read_lines(${CTRS_NEW_BASELINE_FILE} ctrs_new_lines)
+set(ctrs_new_names)
+foreach(ctrs_line IN LISTS ctrs_new_lines)
+    if(ctrs_line MATCHES "^[ \t]*([^ \t#]+)[ \t]+([^ \t]+)")
+        list(APPEND ctrs_new_names ${CMAKE_MATCH_1})
+        set(ctrs_new_median_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+    endif()
+endforeach()
+
+if(NOT EXISTS ${CTRS_BASELINE_FILE})
+    configure_file(${CTRS_NEW_BASELINE_FILE} ${CTRS_BASELINE_FILE} COPYONLY)
+    list(LENGTH ctrs_new_names ctrs_new_count)
+    message(STATUS "wrote the ${ctrs_new_count} medians of ${CTRS_NEW_BASELINE_FILE} to the new baseline ${CTRS_BASELINE_FILE}")
+    return()
+endif()
+
+#the baseline with the median of every benchmark that ran replaced in place
+read_lines(${CTRS_BASELINE_FILE} ctrs_lines)
+string(ASCII 1 ctrs_semicolon)
+set(ctrs_merged "")
+set(ctrs_updated_names)
+foreach(ctrs_line IN LISTS ctrs_lines)
+    #the CMAKE_MATCH_n of the same if() would be the ones of the previous line, hence the nested if
+    if(ctrs_line MATCHES "^([ \t]*([^ \t#]+)[ \t]+)[^ \t]+(.*)$")
+        set(ctrs_name ${CMAKE_MATCH_2})
+        if(DEFINED ctrs_new_median_${ctrs_name})
+            set(ctrs_line "${CMAKE_MATCH_1}${ctrs_new_median_${ctrs_name}}${CMAKE_MATCH_3}")
+            list(APPEND ctrs_updated_names ${ctrs_name})
+        endif()
+    endif()
+    string(REPLACE "${ctrs_semicolon}" ";" ctrs_line "${ctrs_line}")
+    string(APPEND ctrs_merged "${ctrs_line}\n")
+endforeach()
+
+set(ctrs_added_count 0)
+foreach(ctrs_name IN LISTS ctrs_new_names)
+    list(FIND ctrs_updated_names ${ctrs_name} ctrs_index)
+    if(ctrs_index EQUAL -1)
+        string(APPEND ctrs_merged "${ctrs_name} ${ctrs_new_median_${ctrs_name}}\n")
+        math(EXPR ctrs_added_count "${ctrs_added_count} + 1")
+    endif()
+endforeach()
+
+file(WRITE ${CTRS_BASELINE_FILE} "${ctrs_merged}")
+list(REMOVE_DUPLICATES ctrs_updated_names)
+list(LENGTH ctrs_updated_names ctrs_updated_count)
+message(STATUS "updated ${ctrs_updated_count} and added ${ctrs_added_count} medians in ${CTRS_BASELINE_FILE}")
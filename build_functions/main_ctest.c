@@ -3,21 +3,53 @@
 
 #include <stddef.h>
 
+#include "macro_utils/macro_utils.h"
+
 #include "c_logging/logger.h"
 
 #include "testrunnerswitcher.h"
+#include "ctrs_runner.h"
+#include "ctrs_sprintf.h"
+#include "ctrs_resource_lock.h"
+#include "ctrs_data_table.h"
+#include "ctrs_watchdog.h"
+
+/* The list of tests produced by END_TEST_SUITE, needed when the runner (and not RUN_TEST_SUITE) executes the tests */
+extern C_LINKAGE const TEST_FUNCTION_DATA MU_C2(TestListHead_, TEST_SUITE_NAME_FROM_CMAKE);
 
 int main(int argc, char* argv[])
 {
     size_t failed_test_count = 0;
-
-    // If a command line argument is provided, use it as a test name filter
-    // to run only the test case matching that name
-    const char* test_name_filter = (argc > 1) ? argv[1] : NULL;
+    CTRS_RUNNER_OPTIONS runner_options;
 
     (void)logger_init();
 
-    RUN_TEST_SUITE(TEST_SUITE_NAME_FROM_CMAKE, failed_test_count, test_name_filter);
+    // A plain command line argument is a test name filter to run only the test case matching that name
+    // (see ctrs_runner_parse_command_line for the other options, for example --jobs N, --filter PATTERN or --timeout S)
+    if (ctrs_runner_parse_command_line(argc, argv, &runner_options) != 0)
+    {
+        failed_test_count = 1;
+    }
+    else
+    {
+        if (ctrs_runner_is_stock_run(&runner_options))
+        {
+            RUN_TEST_SUITE(TEST_SUITE_NAME_FROM_CMAKE, failed_test_count, runner_options.test_name_filter);
+        }
+        else
+        {
+            failed_test_count = ctrs_runner_run_test_suite(&MU_C2(TestListHead_, TEST_SUITE_NAME_FROM_CMAKE), MU_TOSTRING(TEST_SUITE_NAME_FROM_CMAKE), &runner_options);
+        }
+
+        ctrs_runner_options_deinit(&runner_options);
+    }
+
+    /*RUN_TEST_SUITE has no hook after a failed test, release whatever resource locks are still held*/
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_SUITE);
+    ctrs_sprintf_thread_local_reset();
+    ctrs_data_table_unload_all();
+    ctrs_watchdog_stop();
 
     logger_deinit();
 
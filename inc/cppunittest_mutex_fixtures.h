@@ -12,6 +12,8 @@ void cppunittest_mutex_fixtures_suite_init(void);
 void cppunittest_mutex_fixtures_suite_cleanup(void);
 void cppunittest_mutex_fixtures_function_init(void);
 void cppunittest_mutex_fixtures_function_cleanup(void);
+/*lets the calling test run concurrently with the other tests of the process (from RESOURCE_LOCKED_TEST_FUNCTION, whose tags serialize it)*/
+void cppunittest_mutex_fixtures_leave_serialization(void);
 
 #ifdef __cplusplus
 }
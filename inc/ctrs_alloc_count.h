@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_ALLOC_COUNT_H
+#define CTRS_ALLOC_COUNT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+    What the process allocated since it started, counted by the malloc/calloc/realloc/free of ctrs_alloc_count_linux.c, which replace
+    those of the C library in the exes built with COUNT_ALLOCATIONS (see build_exe). The counts are for all the threads of the process.
+    */
+    typedef struct CTRS_ALLOCATION_COUNTS_TAG
+    {
+        uint64_t malloc_count; /*malloc, posix_memalign, aligned_alloc and memalign*/
+        uint64_t calloc_count;
+        uint64_t realloc_count;
+        uint64_t free_count; /*free of a non-NULL pointer*/
+        uint64_t allocated_bytes; /*the sizes asked for by all the allocations, reallocations included*/
+    } CTRS_ALLOCATION_COUNTS;
+
+    /*returns true when the allocations of the process are counted, all counts stay 0 otherwise (no COUNT_ALLOCATIONS, sanitizer exes, valgrind, Windows)*/
+    bool ctrs_alloc_count_is_enabled(void);
+
+    void ctrs_alloc_count_get(CTRS_ALLOCATION_COUNTS* counts);
+
+    /*malloc + calloc + realloc calls since start*/
+    uint64_t ctrs_alloc_count_allocations_since(const CTRS_ALLOCATION_COUNTS* start);
+    uint64_t ctrs_alloc_count_allocated_bytes_since(const CTRS_ALLOCATION_COUNTS* start);
+
+    /*called by the replacements of the C library functions, they must not allocate*/
+    void ctrs_alloc_count_enable(void);
+    void ctrs_alloc_count_on_malloc(size_t size);
+    void ctrs_alloc_count_on_calloc(size_t size);
+    void ctrs_alloc_count_on_realloc(size_t size);
+    void ctrs_alloc_count_on_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ALLOCATION_REGION_BEGIN() starts counting in the current scope, ASSERT_ALLOCATIONS_AT_MOST(n) and ASSERT_ALLOCATED_BYTES_AT_MOST(n) check
+what the process allocated since then. In an exe that does not count allocations (see ctrs_alloc_count_is_enabled) they always pass.
+
+TEST_FUNCTION(parse_header_does_not_allocate)
+{
+    ...
+    ALLOCATION_REGION_BEGIN();
+    result = parse_header(buffer, sizeof(buffer), &header);
+    ASSERT_ALLOCATIONS_AT_MOST(0);
+    ...
+}
+*/
+#define ALLOCATION_REGION_BEGIN() \
+    CTRS_ALLOCATION_COUNTS ctrs_allocation_region_start; \
+    ctrs_alloc_count_get(&ctrs_allocation_region_start)
+
+#define ASSERT_ALLOCATIONS_AT_MOST(max_allocations) \
+    do \
+    { \
+        uint64_t ctrs_allocations = ctrs_alloc_count_allocations_since(&ctrs_allocation_region_start); \
+        ASSERT_IS_TRUE(!ctrs_alloc_count_is_enabled() || (ctrs_allocations <= (uint64_t)(max_allocations)), \
+            "%llu allocations since ALLOCATION_REGION_BEGIN, expected at most %llu", (unsigned long long)ctrs_allocations, (unsigned long long)(max_allocations)); \
+    } while ((void)0, 0)
+
+#define ASSERT_ALLOCATED_BYTES_AT_MOST(max_bytes) \
+    do \
+    { \
+        uint64_t ctrs_allocated_bytes = ctrs_alloc_count_allocated_bytes_since(&ctrs_allocation_region_start); \
+        ASSERT_IS_TRUE(!ctrs_alloc_count_is_enabled() || (ctrs_allocated_bytes <= (uint64_t)(max_bytes)), \
+            "%llu bytes allocated since ALLOCATION_REGION_BEGIN, expected at most %llu", (unsigned long long)ctrs_allocated_bytes, (unsigned long long)(max_bytes)); \
+    } while ((void)0, 0)
+
+#endif /* CTRS_ALLOC_COUNT_H */
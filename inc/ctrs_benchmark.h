@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_BENCHMARK_H
+#define CTRS_BENCHMARK_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "ctrs_perf_counters.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variables that override how long a benchmark runs (for example to smoke test perf suites in a PR build)*/
+#define CTRS_BENCHMARK_WARMUP_MS_ENV "CTRS_BENCHMARK_WARMUP_MS"
+#define CTRS_BENCHMARK_SAMPLE_MS_ENV "CTRS_BENCHMARK_SAMPLE_MS"
+#define CTRS_BENCHMARK_SAMPLES_ENV "CTRS_BENCHMARK_SAMPLES"
+#define CTRS_BENCHMARK_MAX_TIME_MS_ENV "CTRS_BENCHMARK_MAX_TIME_MS"
+
+#define CTRS_BENCHMARK_DEFAULT_WARMUP_MS 100
+#define CTRS_BENCHMARK_DEFAULT_SAMPLE_MS 10
+#define CTRS_BENCHMARK_DEFAULT_SAMPLES 30
+#define CTRS_BENCHMARK_DEFAULT_MAX_TIME_MS 5000
+
+/*a benchmark always collects at least this many samples, even past its max time*/
+#define CTRS_BENCHMARK_MIN_SAMPLES 5
+#define CTRS_BENCHMARK_MAX_SAMPLES 1000
+
+#define CTRS_BENCHMARK_PHASE_VALUES \
+    CTRS_BENCHMARK_PHASE_NOT_STARTED, \
+    CTRS_BENCHMARK_PHASE_WARMUP, \
+    CTRS_BENCHMARK_PHASE_MEASURE, \
+    CTRS_BENCHMARK_PHASE_DONE
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_BENCHMARK_PHASE, CTRS_BENCHMARK_PHASE_VALUES)
+
+    /*all times are per iteration of the BENCHMARK_LOOP body*/
+    typedef struct CTRS_BENCHMARK_STATISTICS_TAG
+    {
+        size_t sample_count;
+        uint64_t iterations_per_sample;
+        double min_ns;
+        double median_ns;
+        double mean_ns;
+        double p99_ns;
+        double stddev_ns;
+        double ops_per_second;
+        uint64_t measured_iterations;
+        CTRS_PERF_COUNTS perf_counts; /*hardware counters of all the measured iterations (see ctrs_perf_counters.h), not counted unless requested*/
+    } CTRS_BENCHMARK_STATISTICS;
+
+    /*state of one running benchmark, lives on the stack of the test function generated by BENCHMARK_FUNCTION*/
+    typedef struct CTRS_BENCHMARK_TAG
+    {
+        uint64_t remaining_iterations; /*of the current batch, the only field touched on every iteration*/
+        CTRS_BENCHMARK_PHASE phase;
+        const char* name;
+        uint64_t batch_iterations;
+        uint64_t batch_start_ns;
+        uint64_t phase_start_ns;
+        uint64_t warmup_ns;
+        uint64_t sample_ns;
+        uint64_t max_time_ns;
+        size_t max_sample_count;
+        size_t sample_count;
+        double samples[CTRS_BENCHMARK_MAX_SAMPLES]; /*ns per iteration of every measured batch*/
+        CTRS_PERF_COUNTS perf_counts_at_measure_start;
+        CTRS_BENCHMARK_STATISTICS statistics; /*filled by ctrs_benchmark_end*/
+    } CTRS_BENCHMARK;
+
+    void ctrs_benchmark_begin(CTRS_BENCHMARK* benchmark, const char* name);
+
+    /*called when a batch of iterations is over, times it and decides the size of the next one, returns false when the benchmark is done*/
+    bool ctrs_benchmark_next_batch(CTRS_BENCHMARK* benchmark);
+
+    /*computes and logs the statistics, returns 0 when the benchmark ran to completion and did not regress against the perf baseline (see ctrs_perf_baseline.h)*/
+    int ctrs_benchmark_end(CTRS_BENCHMARK* benchmark);
+
+    /*an opaque use of the memory at value, so that the compiler cannot drop the computation that produced it*/
+    void ctrs_benchmark_do_not_optimize(const volatile void* value);
+
+    static inline bool ctrs_benchmark_keep_running(CTRS_BENCHMARK* benchmark)
+    {
+        bool result;
+        if (benchmark->remaining_iterations != 0)
+        {
+            benchmark->remaining_iterations--;
+            result = true;
+        }
+        else
+        {
+            result = ctrs_benchmark_next_batch(benchmark);
+        }
+        return result;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+BENCHMARK_FUNCTION(name) is a TEST_FUNCTION whose body puts the code to measure in a BENCHMARK_LOOP, code before and after the loop is setup/teardown and is not measured:
+
+BENCHMARK_FUNCTION(hash_1k)
+{
+    unsigned char buffer[1024] = { 0 };
+    BENCHMARK_LOOP
+    {
+        uint32_t hash = my_hash(buffer, sizeof(buffer));
+        BENCHMARK_DO_NOT_OPTIMIZE(hash);
+    }
+}
+
+The loop warms up, picks how many iterations a sample has so that it lasts about CTRS_BENCHMARK_SAMPLE_MS, collects the samples and logs min/median/mean/p99/stddev per iteration and ops/sec.
+With CTRS_PERF_COUNTERS it also logs the hardware counters (cycles, instructions, IPC, cache and branch misses) per iteration of the measured samples.
+*/
+#define BENCHMARK_LOOP                      while (ctrs_benchmark_keep_running(ctrs_benchmark))
+#define BENCHMARK_DO_NOT_OPTIMIZE(value)    ctrs_benchmark_do_not_optimize(&(value))
+
+#define BENCHMARK_FUNCTION_RUN(test_name, body_call) \
+    { \
+        CTRS_BENCHMARK ctrs_benchmark; \
+        ctrs_benchmark_begin(&ctrs_benchmark, test_name); \
+        body_call; \
+        ASSERT_ARE_EQUAL(int, 0, ctrs_benchmark_end(&ctrs_benchmark), "benchmark %s failed (incomplete BENCHMARK_LOOP or regression against the perf baseline), see the log", test_name); \
+    }
+
+#define BENCHMARK_FUNCTION(name) \
+    static void MU_C2(name, _benchmark)(CTRS_BENCHMARK* ctrs_benchmark); \
+    TEST_FUNCTION(name) \
+    BENCHMARK_FUNCTION_RUN(MU_TOSTRING(name), MU_C2(name, _benchmark)(&ctrs_benchmark)) \
+    static void MU_C2(name, _benchmark)(CTRS_BENCHMARK* ctrs_benchmark)
+
+/*PARAMETERIZED_BENCHMARK_FUNCTION(base_name, ARGS(...), CASE((...), suffix), ...) is to BENCHMARK_FUNCTION what PARAMETERIZED_TEST_FUNCTION is to TEST_FUNCTION*/
+#define PARAMETERIZED_BENCHMARK_WRAPPER_IMPL(base_name, values, suffix) \
+    TEST_FUNCTION(MU_C3(base_name, _, suffix)) \
+    BENCHMARK_FUNCTION_RUN(MU_TOSTRING(MU_C3(base_name, _, suffix)), MU_C2(base_name, _benchmark)(&ctrs_benchmark, CTEST_PARAMETERIZED_TEST_STRIP_PARENS values))
+
+#define PARAMETERIZED_BENCHMARK_WRAPPER_CALL(base_name, ...) PARAMETERIZED_BENCHMARK_WRAPPER_IMPL(base_name, __VA_ARGS__)
+#define PARAMETERIZED_BENCHMARK_WRAPPER(base_name, case_item) PARAMETERIZED_BENCHMARK_WRAPPER_CALL(base_name, MU_C2B(CTEST_PARAMETERIZED_TEST_EXPAND_CASE_, case_item))
+
+#define PARAMETERIZED_BENCHMARK_FUNCTION(base_name, args, ...) \
+    static void MU_C2(base_name, _benchmark)(CTRS_BENCHMARK* ctrs_benchmark, CTEST_PARAMETERIZED_TEST_ARGS_DECL(args)); \
+    MU_FOR_EACH_1_KEEP_1(PARAMETERIZED_BENCHMARK_WRAPPER, base_name, __VA_ARGS__) \
+    static void MU_C2(base_name, _benchmark)(CTRS_BENCHMARK* ctrs_benchmark, CTEST_PARAMETERIZED_TEST_ARGS_DECL(args))
+
+#endif /* CTRS_BENCHMARK_H */
@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_CONCURRENT_H
+#define CTRS_CONCURRENT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variable that makes every TEST_FUNCTION_CONCURRENT run on 1, 2, 4, ... threads up to the number of processors*/
+#define CTRS_CONCURRENT_SWEEP_ENV "CTRS_CONCURRENT_SWEEP"
+
+/*environment variable with a CSV file the sweeps append their scaling table to (they are always logged)*/
+#define CTRS_CONCURRENT_SWEEP_CSV_ENV "CTRS_CONCURRENT_SWEEP_CSV"
+
+/*the message a failed CONCURRENT_ASSERT_* keeps for its thread*/
+#define CTRS_CONCURRENT_FAILURE_SIZE 512
+
+    typedef void(*CTRS_CONCURRENT_BODY)(void);
+
+    /*
+    Runs body on thread_count threads (0 = the number of processors) released together once all are started, or, with CTRS_CONCURRENT_SWEEP, once
+    for every thread count of the sweep. Logs the throughput of every run. Returns 0 when no thread failed a CONCURRENT_ASSERT_*.
+    */
+    int ctrs_concurrent_run(const char* test_name, size_t thread_count, CTRS_CONCURRENT_BODY body);
+
+    /*the thread the body runs on, 0 to thread count - 1, and the number of threads (they are 0 outside of a body)*/
+    size_t ctrs_concurrent_get_thread_index(void);
+    size_t ctrs_concurrent_get_thread_count(void);
+
+    /*counts operations done by the calling thread for the throughput, a body that counts none is 1 operation*/
+    void ctrs_concurrent_add_operations(uint64_t operations);
+
+    /*records the failure for the calling thread and ends its body, called by the CONCURRENT_ASSERT_* macros (outside of a body: logs it and returns)*/
+    void ctrs_concurrent_fail(const char* file, int line, const char* assertion, const char* format, ...);
+
+    /*the scaling table line of one run of a sweep, in the CSV of CTRS_CONCURRENT_SWEEP_CSV*/
+    typedef struct CTRS_CONCURRENT_RUN_RESULT_TAG
+    {
+        size_t thread_count;
+        uint64_t operations;
+        uint64_t elapsed_ns;
+        double operations_per_second;
+        double speedup; /*operations per second relative to the run on 1 thread*/
+        double efficiency; /*speedup / thread count*/
+    } CTRS_CONCURRENT_RUN_RESULT;
+
+    /*the thread counts of a sweep up to processor_count: 1, 2, 4, ... and processor_count, returns how many were written to thread_counts*/
+    size_t ctrs_concurrent_get_sweep_thread_counts(size_t processor_count, size_t* thread_counts, size_t max_thread_counts);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+TEST_FUNCTION_CONCURRENT(name, threads) is a TEST_FUNCTION whose body runs on threads threads at once (0 = the number of processors). The threads
+are started first and released together, and the run is timed from the release to the end of the last thread:
+
+TEST_FUNCTION_CONCURRENT(queue_push_pop_does_not_lose_items, 8)
+{
+    size_t i;
+    for (i = 0; i < 100000; i++)
+    {
+        CONCURRENT_ASSERT_IS_TRUE(queue_push(g_queue, CONCURRENT_THREAD_INDEX()) == 0);
+        CONCURRENT_ASSERT_IS_TRUE(queue_pop(g_queue, &item) == 0, "pop %zu failed", i);
+    }
+    CONCURRENT_ADD_OPERATIONS(2 * 100000);
+}
+
+ctest assertions jump to one jmp_buf and must not be used in the body, CONCURRENT_ASSERT_* record the failure of their thread and end its body;
+the test fails after all the threads finished, with the failures of every thread in the log. The function initialize and cleanup run once,
+on the test thread. With CTRS_CONCURRENT_SWEEP the body runs again for every thread count of the sweep, so it must not rely on running once.
+*/
+#define TEST_FUNCTION_CONCURRENT(name, threads) \
+    static void MU_C2(name, _concurrent)(void); \
+    TEST_FUNCTION(name) \
+    { \
+        ASSERT_ARE_EQUAL(int, 0, ctrs_concurrent_run(MU_TOSTRING(name), (threads), MU_C2(name, _concurrent)), "%s failed on some of its threads, see the log", MU_TOSTRING(name)); \
+    } \
+    static void MU_C2(name, _concurrent)(void)
+
+#define CONCURRENT_THREAD_INDEX() ctrs_concurrent_get_thread_index()
+#define CONCURRENT_THREAD_COUNT() ctrs_concurrent_get_thread_count()
+#define CONCURRENT_ADD_OPERATIONS(operations) ctrs_concurrent_add_operations(operations)
+
+/*outside of the body of a TEST_FUNCTION_CONCURRENT ctrs_concurrent_fail only logs and returns, the test then fails like after any assertion*/
+#define CTRS_CONCURRENT_FAIL(assertion, ...) \
+    do \
+    { \
+        ctrs_concurrent_fail(__FILE__, __LINE__, assertion, "" __VA_ARGS__); \
+        ASSERT_FAIL("a CONCURRENT_ASSERT failed outside of the body of a TEST_FUNCTION_CONCURRENT, see the log"); \
+    } while ((void)0, 0)
+
+#define CONCURRENT_ASSERT_IS_TRUE(expression, ...) \
+    do \
+    { \
+        if (!(expression)) \
+        { \
+            CTRS_CONCURRENT_FAIL("CONCURRENT_ASSERT_IS_TRUE(" #expression ")", __VA_ARGS__); \
+        } \
+    } while ((void)0, 0)
+
+#define CONCURRENT_ASSERT_IS_FALSE(expression, ...) \
+    do \
+    { \
+        if (expression) \
+        { \
+            CTRS_CONCURRENT_FAIL("CONCURRENT_ASSERT_IS_FALSE(" #expression ")", __VA_ARGS__); \
+        } \
+    } while ((void)0, 0)
+
+#define CONCURRENT_ASSERT_FAIL(...) \
+    CTRS_CONCURRENT_FAIL("CONCURRENT_ASSERT_FAIL", __VA_ARGS__)
+
+#endif /* CTRS_CONCURRENT_H */
@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_DATA_TABLE_H
+#define CTRS_DATA_TABLE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*how many worker processes run the rows of a concurrent table test at once, the number of processors by default*/
+#define CTRS_CONCURRENT_JOBS_ENV "CTRS_CONCURRENT_JOBS"
+
+/*when set, the relative file names of CSV_TEST_FUNCTION and BINARY_TABLE_TEST_FUNCTION are relative to this directory instead of the working directory*/
+#define CTRS_DATA_DIR_ENV "CTRS_DATA_DIR"
+
+#define CTRS_DATA_TABLE_SOURCE_VALUES \
+    CTRS_DATA_TABLE_SOURCE_ARRAY, \
+    CTRS_DATA_TABLE_SOURCE_CSV_FILE, \
+    CTRS_DATA_TABLE_SOURCE_BINARY_FILE
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_DATA_TABLE_SOURCE, CTRS_DATA_TABLE_SOURCE_VALUES)
+
+    /*one line of a CSV file, the fields are named by the first line of the file*/
+    typedef struct CTRS_DATA_TABLE_CSV_ROW_TAG
+    {
+        size_t field_count;
+        const char* const* fields;
+        const char* const* column_names; /*field_count of them*/
+    } CTRS_DATA_TABLE_CSV_ROW;
+
+    /*everything about one table test, a static of the test file generated by TABLE_TEST_FUNCTION and friends*/
+    typedef struct CTRS_DATA_TABLE_TAG
+    {
+        const char* test_name;
+        CTRS_DATA_TABLE_SOURCE source;
+        const void* rows; /*CTRS_DATA_TABLE_SOURCE_ARRAY*/
+        size_t row_count; /*CTRS_DATA_TABLE_SOURCE_ARRAY, set when the file is loaded for the others*/
+        size_t row_size; /*CTRS_DATA_TABLE_SOURCE_ARRAY and CTRS_DATA_TABLE_SOURCE_BINARY_FILE*/
+        const char* file_name; /*CTRS_DATA_TABLE_SOURCE_CSV_FILE and CTRS_DATA_TABLE_SOURCE_BINARY_FILE*/
+        const char* const* row_suffixes; /*CTRS_DATA_TABLE_SOURCE_ARRAY, NULL or row_count names, the rows are then <test>_<suffix>*/
+        bool concurrent; /*all the rows run at once in worker processes when the table test runs all its rows*/
+        void(*run_row)(const void* row);
+        struct CTRS_DATA_TABLE_TAG* next_registered;
+        void* loaded; /*the rows read from file_name and the row names, owned by ctrs_data_table.c*/
+    } CTRS_DATA_TABLE;
+
+    /*makes table known to the runner, which then runs (and lists, and filters) every row as its own test named <test>_<row>*/
+    void ctrs_data_table_register(CTRS_DATA_TABLE* table);
+
+    /*returns the registered table of the TEST_FUNCTION test_name, NULL when test_name is not a table test*/
+    CTRS_DATA_TABLE* ctrs_data_table_find(const char* test_name);
+
+    bool ctrs_data_table_any_registered(void);
+
+    /*reads the file of table (if it has one and it is not read yet) and names its rows, returns 0 on success*/
+    int ctrs_data_table_load(CTRS_DATA_TABLE* table);
+
+    /*frees what ctrs_data_table_load read for table...*/
+    void ctrs_data_table_unload(CTRS_DATA_TABLE* table);
+
+    /*...and for all the registered tables*/
+    void ctrs_data_table_unload_all(void);
+
+    /*name of the row at row_index of a loaded table: <test>_<value of the "name" column> for CSV files with such a column, otherwise <test>_<row_index>*/
+    const char* ctrs_data_table_get_row_name(const CTRS_DATA_TABLE* table, size_t row_index);
+
+    /*the runner selects the one row of table the next run of the table test runs, table NULL goes back to running all the rows*/
+    void ctrs_data_table_select_row(const CTRS_DATA_TABLE* table, size_t row_index);
+
+    /*the body of the TEST_FUNCTION of a table test: runs the selected row, or all the rows (going on after a failed row), returns 0 when they all passed*/
+    int ctrs_data_table_run(CTRS_DATA_TABLE* table);
+
+    /*one CASE of a CONCURRENT_PARAMETERIZED_TEST_FUNCTION, the row of its table*/
+    typedef struct CTRS_DATA_TABLE_CASE_TAG
+    {
+        void(*run_case)(void);
+    } CTRS_DATA_TABLE_CASE;
+
+    /*the run_row of the table of a CONCURRENT_PARAMETERIZED_TEST_FUNCTION, row is a const CTRS_DATA_TABLE_CASE* */
+    void ctrs_data_table_run_case(const void* row);
+
+    /*returns the field of row in column column_name, NULL when the file has no such column*/
+    const char* ctrs_data_table_csv_get(const CTRS_DATA_TABLE_CSV_ROW* row, const char* column_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*registers table (CTRS_DATA_TABLE* getter(void)) before main, so that the runner knows the rows before running anything*/
+#if defined(__cplusplus)
+/*a C++ test file is a cppunittest class, its table tests run all their rows and are never expanded by the runner*/
+#define CTRS_DATA_TABLE_REGISTER(getter)
+#elif defined(_MSC_VER)
+/*the same section the C++ static constructors live in, the CRT calls all its function pointers at startup (C programs included)*/
+#pragma section(".CRT$XCU", read)
+#define CTRS_DATA_TABLE_REGISTER(getter) \
+    static void __cdecl MU_C2(getter, _register)(void) \
+    { \
+        ctrs_data_table_register(getter()); \
+    } \
+    __declspec(allocate(".CRT$XCU")) void (__cdecl* const MU_C2(getter, _initializer))(void) = MU_C2(getter, _register);
+#else
+#define CTRS_DATA_TABLE_REGISTER(getter) \
+    __attribute__((constructor)) static void MU_C2(getter, _register)(void) \
+    { \
+        ctrs_data_table_register(getter()); \
+    }
+#endif
+
+/*the table of the test name, its registration and the TEST_FUNCTION that runs its rows*/
+#define CTRS_DATA_TABLE_DEFINE(name, source, rows, row_count, row_size, file_name, row_suffixes, concurrent, run_row) \
+    static CTRS_DATA_TABLE* MU_C2(name, _data_table)(void) \
+    { \
+        static CTRS_DATA_TABLE data_table = { MU_TOSTRING(name), source, rows, row_count, row_size, file_name, row_suffixes, concurrent, run_row, NULL, NULL }; \
+        return &data_table; \
+    } \
+    CTRS_DATA_TABLE_REGISTER(MU_C2(name, _data_table)) \
+    TEST_FUNCTION(name) \
+    { \
+        ASSERT_ARE_EQUAL(int, 0, ctrs_data_table_run(MU_C2(name, _data_table)()), "rows of %s failed (or its data could not be read), see the log", MU_TOSTRING(name)); \
+    }
+
+#define CTRS_DATA_TABLE_TEST_FUNCTION(name, row_type, source, rows, row_count, file_name, concurrent) \
+    static void MU_C2(name, _row)(const row_type* row); \
+    static void MU_C2(name, _run_row)(const void* row) \
+    { \
+        MU_C2(name, _row)((const row_type*)row); \
+    } \
+    CTRS_DATA_TABLE_DEFINE(name, source, rows, row_count, sizeof(row_type), file_name, NULL, concurrent, MU_C2(name, _run_row)) \
+    static void MU_C2(name, _row)(const row_type* row)
+
+/*
+Table tests run one body over many rows of data without a macro argument (and a wrapper function) per row, so that the compile time
+does not grow with the number of rows. Every row is reported, listed (--list, DISCOVER_TESTS) and filtered as its own test named
+<test>_<row>, the same way as the CASEs of a PARAMETERIZED_TEST_FUNCTION.
+
+TABLE_TEST_FUNCTION(name, row_type, rows) runs the body once per element of the static array rows, row is a const row_type*:
+
+typedef struct HASH_VECTOR_TAG { const char* input; uint32_t expected; } HASH_VECTOR;
+static const HASH_VECTOR hash_vectors[] = { { "", 0x811c9dc5 }, { "a", 0xe40c292c } };
+
+TABLE_TEST_FUNCTION(hash_matches_the_vector, HASH_VECTOR, hash_vectors)
+{
+    ASSERT_ARE_EQUAL(uint32_t, row->expected, my_hash(row->input, strlen(row->input)));
+}
+
+CSV_TEST_FUNCTION(name, file_name) runs the body once per line (after the header line) of a CSV file, row is a const CTRS_DATA_TABLE_CSV_ROW*
+whose fields are read with ctrs_data_table_csv_get(row, "column"). Fields can be quoted ("a, b" and "say ""hi"""), blank lines and lines
+starting with # are skipped, and a column named "name" names the rows.
+
+BINARY_TABLE_TEST_FUNCTION(name, row_type, file_name) runs the body once per sizeof(row_type) bytes of a binary file, row is a const row_type*
+(keep row_type to fixed width fields, the file has to have the same layout on every platform).
+
+The files are listed in DATA_FILES of build_test_artifacts, which copies them next to the test executable.
+*/
+#define TABLE_TEST_FUNCTION(name, row_type, rows) \
+    CTRS_DATA_TABLE_TEST_FUNCTION(name, row_type, CTRS_DATA_TABLE_SOURCE_ARRAY, rows, sizeof(rows) / sizeof((rows)[0]), NULL, false)
+
+#define CSV_TEST_FUNCTION(name, file_name) \
+    CTRS_DATA_TABLE_TEST_FUNCTION(name, CTRS_DATA_TABLE_CSV_ROW, CTRS_DATA_TABLE_SOURCE_CSV_FILE, NULL, 0, file_name, false)
+
+#define BINARY_TABLE_TEST_FUNCTION(name, row_type, file_name) \
+    CTRS_DATA_TABLE_TEST_FUNCTION(name, row_type, CTRS_DATA_TABLE_SOURCE_BINARY_FILE, NULL, 0, file_name, false)
+
+/*
+CONCURRENT_PARAMETERIZED_TEST_FUNCTION(base_name, ARGS(...), CASE((...), suffix), ...) is a PARAMETERIZED_TEST_FUNCTION whose cases run at once,
+spread across CTRS_CONCURRENT_JOBS worker processes (the number of processors by default), and CONCURRENT_TABLE_TEST_FUNCTION is the same for
+the rows of a TABLE_TEST_FUNCTION. Assertions (ctest longjmps to one global jmp_buf) cannot run on several threads, so the workers are processes,
+forked after the function initialize: every case starts from the state the fixture left, and what a case changes in memory is not seen by the
+other cases nor by the test. The output and the result of every case are reported in the order of the cases, whatever order they finished in.
+
+The cases keep their PARAMETERIZED_TEST_FUNCTION names, <base_name>_<suffix>. When the stock main runs single cases (a filter, --report,
+DISCOVER_TESTS) every case is its own test, spread by --jobs (or ctest -j) instead. Without fork (Windows) and with cppunittest the cases run
+one after the other.
+*/
+#define CONCURRENT_TABLE_TEST_FUNCTION(name, row_type, rows) \
+    CTRS_DATA_TABLE_TEST_FUNCTION(name, row_type, CTRS_DATA_TABLE_SOURCE_ARRAY, rows, sizeof(rows) / sizeof((rows)[0]), NULL, true)
+
+#ifdef __cplusplus
+#define CONCURRENT_PARAMETERIZED_TEST_FUNCTION PARAMETERIZED_TEST_FUNCTION
+#else
+#define CTRS_CONCURRENT_CASE_FUNCTION_IMPL(base_name, values, suffix) \
+    static void MU_C3(base_name, _case_, suffix)(void) \
+    { \
+        MU_C2(base_name, _impl)(CTEST_PARAMETERIZED_TEST_STRIP_PARENS values); \
+    }
+#define CTRS_CONCURRENT_CASE_ENTRY_IMPL(base_name, values, suffix) { MU_C3(base_name, _case_, suffix) },
+#define CTRS_CONCURRENT_CASE_SUFFIX_IMPL(base_name, values, suffix) MU_TOSTRING(suffix),
+
+#define CTRS_CONCURRENT_CASE_FUNCTION_CALL(base_name, ...) CTRS_CONCURRENT_CASE_FUNCTION_IMPL(base_name, __VA_ARGS__)
+#define CTRS_CONCURRENT_CASE_ENTRY_CALL(base_name, ...) CTRS_CONCURRENT_CASE_ENTRY_IMPL(base_name, __VA_ARGS__)
+#define CTRS_CONCURRENT_CASE_SUFFIX_CALL(base_name, ...) CTRS_CONCURRENT_CASE_SUFFIX_IMPL(base_name, __VA_ARGS__)
+
+#define CTRS_CONCURRENT_CASE_FUNCTION(base_name, case_item) CTRS_CONCURRENT_CASE_FUNCTION_CALL(base_name, MU_C2B(CTEST_PARAMETERIZED_TEST_EXPAND_CASE_, case_item))
+#define CTRS_CONCURRENT_CASE_ENTRY(base_name, case_item) CTRS_CONCURRENT_CASE_ENTRY_CALL(base_name, MU_C2B(CTEST_PARAMETERIZED_TEST_EXPAND_CASE_, case_item))
+#define CTRS_CONCURRENT_CASE_SUFFIX(base_name, case_item) CTRS_CONCURRENT_CASE_SUFFIX_CALL(base_name, MU_C2B(CTEST_PARAMETERIZED_TEST_EXPAND_CASE_, case_item))
+
+#define CONCURRENT_PARAMETERIZED_TEST_FUNCTION(base_name, args, ...) \
+    static void MU_C2(base_name, _impl)(CTEST_PARAMETERIZED_TEST_ARGS_DECL(args)); \
+    MU_FOR_EACH_1_KEEP_1(CTRS_CONCURRENT_CASE_FUNCTION, base_name, __VA_ARGS__) \
+    static const CTRS_DATA_TABLE_CASE MU_C2(base_name, _cases)[] = { MU_FOR_EACH_1_KEEP_1(CTRS_CONCURRENT_CASE_ENTRY, base_name, __VA_ARGS__) }; \
+    static const char* const MU_C2(base_name, _case_suffixes)[] = { MU_FOR_EACH_1_KEEP_1(CTRS_CONCURRENT_CASE_SUFFIX, base_name, __VA_ARGS__) }; \
+    CTRS_DATA_TABLE_DEFINE(base_name, CTRS_DATA_TABLE_SOURCE_ARRAY, MU_C2(base_name, _cases), sizeof(MU_C2(base_name, _cases)) / sizeof(MU_C2(base_name, _cases)[0]), \
+        sizeof(CTRS_DATA_TABLE_CASE), NULL, MU_C2(base_name, _case_suffixes), true, ctrs_data_table_run_case) \
+    static void MU_C2(base_name, _impl)(CTEST_PARAMETERIZED_TEST_ARGS_DECL(args))
+#endif
+
+#endif /* CTRS_DATA_TABLE_H */
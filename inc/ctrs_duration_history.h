@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_DURATION_HISTORY_H
+#define CTRS_DURATION_HISTORY_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variable with the duration history file of --duration-history*/
+#define CTRS_DURATION_HISTORY_ENV "CTRS_DURATION_HISTORY"
+
+/*the value of --duration-history that turns the history off*/
+#define CTRS_DURATION_HISTORY_OFF "off"
+
+    /*
+    The duration of every test of a suite in its recent runs, kept in a text file ("<duration_ms> <test name>" per line), so that the runner
+    can spread the tests across --jobs workers and shards longest first. A duration is the average of the last one recorded and the one
+    before it, so one slow run does not reorder everything.
+
+    The history of a suite is read and written under a test mutex named after the suite. A shard writes its durations to
+    "<path>.shard_<i>_of_<n>", and they are merged into the history once all the shards of the same history wrote theirs, so that all the
+    shards of a run split the tests with the same durations (a shard that started later still sees what the first one saw).
+    */
+    typedef struct CTRS_DURATION_HISTORY_TAG* CTRS_DURATION_HISTORY_HANDLE;
+
+    /*reads the history at path (an empty history when the file does not exist yet), shard_count 1 for a run that is not sharded*/
+    CTRS_DURATION_HISTORY_HANDLE ctrs_duration_history_load(const char* path, const char* suite_name, size_t shard_index, size_t shard_count);
+    void ctrs_duration_history_destroy(CTRS_DURATION_HISTORY_HANDLE history);
+
+    /*returns true and the duration of test_name when the history has one*/
+    bool ctrs_duration_history_get(CTRS_DURATION_HISTORY_HANDLE history, const char* test_name, double* duration_ms);
+
+    /*the cost of a test without history: the median of the durations in the history, 1 ms when it is empty*/
+    double ctrs_duration_history_get_default(CTRS_DURATION_HISTORY_HANDLE history);
+
+    /*records the duration test_name took in this run, written by ctrs_duration_history_save*/
+    void ctrs_duration_history_record(CTRS_DURATION_HISTORY_HANDLE history, const char* test_name, double duration_ms);
+
+    /*
+    Writes what was recorded: to the history for a run that is not sharded (with prune, the tests that did not run are dropped, for a run of
+    the whole suite), to the file of the shard otherwise (prune: the shard ran all its tests, when all the shards did the merge of their files
+    drops the tests none of them ran). Returns 0 on success.
+    */
+    int ctrs_duration_history_save(CTRS_DURATION_HISTORY_HANDLE history, bool prune);
+
+    /*
+    Assigns every one of the item_count items to one of bin_count bins, longest first: the items by decreasing cost (then by index), each to
+    the bin with the least cost so far (then the lowest bin). The result is within 4/3 of the best possible finish time and the same for the
+    same costs, in every process. With equal costs it is round robin. Returns 0 on success.
+    */
+    int ctrs_duration_history_assign_longest_first(const double* costs, size_t item_count, size_t bin_count, size_t* bins);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_DURATION_HISTORY_H */
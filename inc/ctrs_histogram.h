@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_HISTOGRAM_H
+#define CTRS_HISTOGRAM_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*every power of 2 is split in this many buckets, a value is known within 1/128 (0.8%) of itself, values below 256 exactly*/
+#define CTRS_HISTOGRAM_SUB_BUCKET_BITS 7
+
+    /*
+    A latency histogram in the spirit of HdrHistogram: it covers 0 to UINT64_MAX (nanoseconds, or any other unit) in log-linear buckets,
+    so recording a value is a few instructions and never allocates. A percentile is the highest value of the bucket it falls in (never
+    more than the max recorded), so it is at most 0.8% pessimistic and an ASSERT_PERCENTILE_AT_MOST that passes holds for the real values.
+
+    A histogram is not thread safe: give every thread its own and merge them with ctrs_histogram_add when the threads are done.
+    */
+    typedef struct CTRS_HISTOGRAM_TAG* CTRS_HISTOGRAM_HANDLE;
+
+    /*the buckets take ~58 KB, allocated here once*/
+    CTRS_HISTOGRAM_HANDLE ctrs_histogram_create(void);
+    void ctrs_histogram_destroy(CTRS_HISTOGRAM_HANDLE histogram);
+
+    void ctrs_histogram_reset(CTRS_HISTOGRAM_HANDLE histogram);
+
+    void ctrs_histogram_record(CTRS_HISTOGRAM_HANDLE histogram, uint64_t value);
+
+    /*records value count times, for example a coordinated omission correction*/
+    void ctrs_histogram_record_count(CTRS_HISTOGRAM_HANDLE histogram, uint64_t value, uint64_t count);
+
+    /*adds all the values recorded in source to destination*/
+    int ctrs_histogram_add(CTRS_HISTOGRAM_HANDLE destination, CTRS_HISTOGRAM_HANDLE source);
+
+    uint64_t ctrs_histogram_get_count(CTRS_HISTOGRAM_HANDLE histogram);
+    uint64_t ctrs_histogram_get_min(CTRS_HISTOGRAM_HANDLE histogram);
+    uint64_t ctrs_histogram_get_max(CTRS_HISTOGRAM_HANDLE histogram);
+    double ctrs_histogram_get_mean(CTRS_HISTOGRAM_HANDLE histogram);
+
+    /*the value at percentile (0 to 100, for example 99.9) of the recorded values, 0 when nothing was recorded*/
+    uint64_t ctrs_histogram_get_percentile(CTRS_HISTOGRAM_HANDLE histogram, double percentile);
+
+    /*logs count/min/mean/max and the percentile distribution (50%, 75%, 87.5%, ... up to the max), the way HdrHistogram prints it*/
+    void ctrs_histogram_log_distribution(CTRS_HISTOGRAM_HANDLE histogram, const char* name);
+
+    /*returns 0 when something was recorded and the value at percentile is at most max_value, otherwise logs why and the distribution*/
+    int ctrs_histogram_check_percentile(CTRS_HISTOGRAM_HANDLE histogram, const char* name, double percentile, uint64_t max_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ASSERT_PERCENTILE_AT_MOST(histogram, percentile, max_value) fails the test when the value at percentile of what histogram recorded is above
+max_value (or when it recorded nothing), after logging the whole distribution:
+
+TEST_FUNCTION(send_has_a_p999_under_2_ms)
+{
+    CTRS_HISTOGRAM_HANDLE latencies = ctrs_histogram_create();
+    for (i = 0; i < 100000; i++)
+    {
+        uint64_t start = ctrs_time_monotonic_ns();
+        send_message(client, message);
+        ctrs_histogram_record(latencies, ctrs_time_monotonic_ns() - start);
+    }
+    ASSERT_PERCENTILE_AT_MOST(latencies, 99, 500000);
+    ASSERT_PERCENTILE_AT_MOST(latencies, 99.9, 2000000);
+    ctrs_histogram_destroy(latencies);
+}
+*/
+#define ASSERT_PERCENTILE_AT_MOST(histogram, percentile, max_value) \
+    ASSERT_ARE_EQUAL(int, 0, ctrs_histogram_check_percentile((histogram), MU_TOSTRING(histogram), (percentile), (uint64_t)(max_value)), \
+        "p%g of %s is above %llu, see the distribution in the log", (double)(percentile), MU_TOSTRING(histogram), (unsigned long long)(max_value))
+
+#endif /* CTRS_HISTOGRAM_H */
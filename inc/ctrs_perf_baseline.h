@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_PERF_BASELINE_H
+#define CTRS_PERF_BASELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*set by build_test_artifacts(... PERF_BASELINE file [PERF_TOLERANCE percent]) on the ctest tests of the suite*/
+#define CTRS_PERF_BASELINE_ENV "CTRS_PERF_BASELINE"
+#define CTRS_PERF_TOLERANCE_PERCENT_ENV "CTRS_PERF_TOLERANCE_PERCENT"
+/*set by the <suite>_update_baseline target, every benchmark appends its median to this file instead of being compared*/
+#define CTRS_PERF_BASELINE_UPDATE_ENV "CTRS_PERF_BASELINE_UPDATE"
+
+#define CTRS_PERF_DEFAULT_TOLERANCE_PERCENT 10.0
+
+/*
+A baseline file has one line per benchmark: <benchmark name> <median ns per iteration> [<tolerance percent>]
+Empty lines and lines starting with # are ignored. The tolerance of a line overrides the tolerance of the suite.
+Any other measurement where lower is better (a compile time, a size in bytes) can be tracked in the same way.
+*/
+
+    /*returns a non-zero value when the file cannot be read or median_ns exceeds the baseline of name by more than the tolerance, a benchmark missing from the file passes*/
+    int ctrs_perf_baseline_check(const char* baseline_file, double tolerance_percent, const char* name, double median_ns);
+
+    /*appends the line of name to baseline_file (created with a header comment when it does not exist)*/
+    int ctrs_perf_baseline_append(const char* baseline_file, const char* name, double median_ns);
+
+    /*checks median_ns against the baseline of the suite, or appends it when the baseline is being updated (see the environment variables above), returns 0 when neither is set*/
+    int ctrs_perf_baseline_apply(const char* name, double median_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_PERF_BASELINE_H */
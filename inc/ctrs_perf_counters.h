@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_PERF_COUNTERS_H
+#define CTRS_PERF_COUNTERS_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variable that turns the hardware counters on (PERF_COUNTERS of build_test_artifacts sets it to 1)*/
+#define CTRS_PERF_COUNTERS_ENV "CTRS_PERF_COUNTERS"
+
+#define CTRS_PERF_COUNTER_VALUES \
+    CTRS_PERF_COUNTER_CYCLES, \
+    CTRS_PERF_COUNTER_INSTRUCTIONS, \
+    CTRS_PERF_COUNTER_CACHE_MISSES, \
+    CTRS_PERF_COUNTER_BRANCH_MISSES
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_PERF_COUNTER, CTRS_PERF_COUNTER_VALUES)
+
+#define CTRS_PERF_COUNTER_COUNT 4
+
+    /*
+    Hardware events of the thread that first read the counters and of the threads it created after that (user space only). A counter the
+    CPU or the kernel does not provide is not counted. When the PMU is shared by more events than it has registers, the kernel multiplexes
+    them and the values are scaled to the time they were enabled.
+    */
+    typedef struct CTRS_PERF_COUNTS_TAG
+    {
+        bool counted[CTRS_PERF_COUNTER_COUNT];
+        uint64_t values[CTRS_PERF_COUNTER_COUNT];
+    } CTRS_PERF_COUNTS;
+
+    /*returns true when CTRS_PERF_COUNTERS asks for the counters, whether the kernel allows them or not*/
+    bool ctrs_perf_counters_are_requested(void);
+
+    /*
+    Returns true when the counters are requested and at least one of them could be opened. The first call opens them, when the kernel forbids
+    them (perf_event_paranoid, a container without CAP_PERFMON, a VM without a virtual PMU) it logs why once and everything goes on without
+    counters, so a test that needs them can return early on false. Not available on Windows.
+    */
+    bool ctrs_perf_counters_are_available(void);
+
+    /*the running totals, nothing is counted when the counters are not available*/
+    void ctrs_perf_counters_read(CTRS_PERF_COUNTS* counts);
+
+    /*the difference between 2 reads, only the counters counted in both are counted in delta*/
+    void ctrs_perf_counts_delta(const CTRS_PERF_COUNTS* before, const CTRS_PERF_COUNTS* after, CTRS_PERF_COUNTS* delta);
+
+    bool ctrs_perf_counts_any_counted(const CTRS_PERF_COUNTS* counts);
+
+    /*"cycles", "instructions", "cache_misses", "branch_misses", the names used in the log and in the reports*/
+    const char* ctrs_perf_counter_name(CTRS_PERF_COUNTER counter);
+
+    /*writes "cycles=... instructions=... IPC=... cache_misses=... branch_misses=..." with every value divided by divisor (for example per iteration)*/
+    void ctrs_perf_counts_format(const CTRS_PERF_COUNTS* counts, double divisor, char* buffer, size_t buffer_size);
+
+    /*logs the counts of what ran since start, used by PERF_COUNTERS_REGION_END*/
+    void ctrs_perf_counters_log_since(const char* region_name, const CTRS_PERF_COUNTS* start);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+PERF_COUNTERS_REGION_BEGIN() and PERF_COUNTERS_REGION_END(name) log the hardware counters of the code between them:
+
+TEST_FUNCTION(parse_1000_headers)
+{
+    ...
+    PERF_COUNTERS_REGION_BEGIN();
+    for (i = 0; i < 1000; i++)
+    {
+        (void)parse_header(buffer, sizeof(buffer), &header);
+    }
+    PERF_COUNTERS_REGION_END("parse_header x 1000");
+    ...
+}
+*/
+#define PERF_COUNTERS_REGION_BEGIN() \
+    CTRS_PERF_COUNTS ctrs_perf_counters_region_start; \
+    ctrs_perf_counters_read(&ctrs_perf_counters_region_start)
+
+#define PERF_COUNTERS_REGION_END(region_name) \
+    ctrs_perf_counters_log_since(region_name, &ctrs_perf_counters_region_start)
+
+#endif /* CTRS_PERF_COUNTERS_H */
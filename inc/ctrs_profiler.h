@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_PROFILER_H
+#define CTRS_PROFILER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variables for --profile and --profile-frequency of the stock main*/
+#define CTRS_PROFILE_DIR_ENV "CTRS_PROFILE_DIR"
+#define CTRS_PROFILE_FREQUENCY_ENV "CTRS_PROFILE_FREQUENCY"
+
+/*samples per second of CPU time, not a multiple of the usual timer ticks so the samples do not lock step with periodic work*/
+#define CTRS_PROFILER_DEFAULT_FREQUENCY_HZ 999
+
+    /*
+    A sampling profiler for the runner: while started, ITIMER_PROF sends SIGPROF for every 1/frequency_hz s of CPU time the process uses
+    (on any of its threads), and the handler saves the stack of the interrupted thread. ctrs_profiler_stop writes the samples as folded
+    stacks ("main;run_test;parse_header;memchr 42", outermost frame first, one line per distinct stack), which flamegraph.pl, speedscope
+    and inferno read as they are.
+
+    Only one profile runs at a time. SIGPROF interrupts system calls that SA_RESTART does not restart (for example nanosleep), so code that
+    does not retry on EINTR can behave differently while profiled. Functions are named by dladdr, so static functions show as
+    module+0xoffset (addr2line turns them into names). Linux only.
+    */
+
+    /*starts sampling, returns 0 on success (non-zero when a profile is already running or the platform has no profiler)*/
+    int ctrs_profiler_start(uint32_t frequency_hz);
+
+    /*stops sampling and writes the folded stacks to folded_path (nothing is written when it is NULL), returns 0 on success*/
+    int ctrs_profiler_stop(const char* folded_path, size_t* sample_count);
+
+    /*writes to path "directory/suite.test.folded", with the characters of test names that are not safe in a file name replaced by '_'*/
+    int ctrs_profiler_get_folded_path(const char* directory, const char* suite_name, const char* test_name, char* path, size_t path_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_PROFILER_H */
@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_REPORT_H
+#define CTRS_REPORT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "ctrs_test_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variables used when --report/--report-format are not on the command line*/
+#define CTRS_REPORT_FILE_ENV "CTRS_REPORT_FILE"
+#define CTRS_REPORT_FORMAT_ENV "CTRS_REPORT_FORMAT"
+
+    /*everything the report says about one run of a suite (or of one shard of it)*/
+    typedef struct CTRS_REPORT_SUITE_TAG
+    {
+        const char* name;
+        size_t shard_index;
+        size_t shard_count;
+        size_t test_count;
+        const char* const* test_names; /*test_count names...*/
+        const CTRS_TEST_RESULT* test_results; /*...and their results, in the same order*/
+        size_t run_failures; /*failures outside of tests (suite fixtures, runner errors)*/
+    } CTRS_REPORT_SUITE;
+
+    /*returns 0 when report_format is NULL (the format then follows the extension of the file) or one of "junit", "json"*/
+    int ctrs_report_validate_format(const char* report_format);
+
+    /*writes the report of suite to report_path, which is either a file or an existing directory (the file is then named after the suite and shard)*/
+    int ctrs_report_write(const char* report_path, const char* report_format, const CTRS_REPORT_SUITE* suite);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_REPORT_H */
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_RESOURCE_LOCK_H
+#define CTRS_RESOURCE_LOCK_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "cppunittest_mutex_fixtures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CTRS_RESOURCE_LOCK_SCOPE_VALUES \
+    CTRS_RESOURCE_LOCK_SCOPE_TEST, \
+    CTRS_RESOURCE_LOCK_SCOPE_SUITE
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_RESOURCE_LOCK_SCOPE, CTRS_RESOURCE_LOCK_SCOPE_VALUES)
+
+    /*
+    A resource lock is a named test mutex (testmutex_create_named) per tag, shared by all the test processes of the machine: tests (or suites)
+    that share a tag run one at a time, tests with disjoint tags (or no tags) run concurrently, in --jobs workers and under ctest -j alike.
+    The tags of one call are acquired in sorted order, so that two tests locking the same tags in a different order cannot deadlock.
+    */
+    int ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE scope, const char* const* tags, size_t tag_count);
+
+    /*releases everything acquired for scope, the runner calls it for CTRS_RESOURCE_LOCK_SCOPE_TEST after every test (a failed assertion skips the release in the test)*/
+    void ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE scope);
+
+    /*the tags of one RESOURCE_LOCKED_TEST_FUNCTION, registered before main so that the runner can list them without running the test (--list-properties)*/
+    typedef struct CTRS_TEST_RESOURCE_LOCKS_TAG
+    {
+        const char* test_name;
+        const char* const* tags;
+        size_t tag_count;
+        struct CTRS_TEST_RESOURCE_LOCKS_TAG* next_registered;
+    } CTRS_TEST_RESOURCE_LOCKS;
+
+    void ctrs_resource_lock_register_test_locks(CTRS_TEST_RESOURCE_LOCKS* test_locks);
+
+    /*returns the tags registered for the TEST_FUNCTION test_name, NULL when it has none*/
+    const CTRS_TEST_RESOURCE_LOCKS* ctrs_resource_lock_get_test_locks(const char* test_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*registers the tags of the RESOURCE_LOCKED_TEST_FUNCTION name before main*/
+#if defined(__cplusplus)
+/*cppunittest runs the tests of a C++ test file, never the stock runner that lists the tags*/
+#define CTRS_RESOURCE_LOCK_REGISTER(name, ...)
+#else
+#define CTRS_RESOURCE_LOCK_REGISTERED(name, ...) \
+    static const char* const MU_C2(name, _registered_resource_lock_tags)[] = { __VA_ARGS__ }; \
+    static CTRS_TEST_RESOURCE_LOCKS MU_C2(name, _registered_resource_locks) = \
+    { \
+        MU_TOSTRING(name), \
+        MU_C2(name, _registered_resource_lock_tags), \
+        sizeof(MU_C2(name, _registered_resource_lock_tags)) / sizeof(MU_C2(name, _registered_resource_lock_tags)[0]), \
+        NULL \
+    };
+#if defined(_MSC_VER)
+#pragma section(".CRT$XCU", read)
+#define CTRS_RESOURCE_LOCK_REGISTER(name, ...) \
+    CTRS_RESOURCE_LOCK_REGISTERED(name, __VA_ARGS__) \
+    static void __cdecl MU_C2(name, _register_resource_locks)(void) \
+    { \
+        ctrs_resource_lock_register_test_locks(&MU_C2(name, _registered_resource_locks)); \
+    } \
+    __declspec(allocate(".CRT$XCU")) void (__cdecl* const MU_C2(name, _resource_locks_initializer))(void) = MU_C2(name, _register_resource_locks);
+#else
+#define CTRS_RESOURCE_LOCK_REGISTER(name, ...) \
+    CTRS_RESOURCE_LOCK_REGISTERED(name, __VA_ARGS__) \
+    __attribute__((constructor)) static void MU_C2(name, _register_resource_locks)(void) \
+    { \
+        ctrs_resource_lock_register_test_locks(&MU_C2(name, _registered_resource_locks)); \
+    }
+#endif
+#endif
+
+#ifdef CPP_UNITTEST
+/*a tagged test is serialized by its tags only, it lets go of the mutex cppunittest_mutex_fixtures takes around every test*/
+#define CTRS_RESOURCE_LOCK_LEAVE_TEST_SERIALIZATION() cppunittest_mutex_fixtures_leave_serialization()
+#else
+#define CTRS_RESOURCE_LOCK_LEAVE_TEST_SERIALIZATION() ((void)0)
+#endif
+
+/*
+RESOURCE_LOCKED_TEST_FUNCTION(name, "tag", ...) is a TEST_FUNCTION that holds the resource locks of its tags while it runs:
+
+RESOURCE_LOCKED_TEST_FUNCTION(opens_the_listening_port, "port_4840")
+{
+    ...
+}
+
+A whole suite is locked from its TEST_SUITE_INITIALIZE with SUITE_RESOURCE_LOCK_ACQUIRE("tag", ...) and unlocked from its
+TEST_SUITE_CLEANUP with SUITE_RESOURCE_LOCK_RELEASE().
+
+The tags of a RESOURCE_LOCKED_TEST_FUNCTION are also listed by --list-properties of the stock main, so that DISCOVER_TESTS gives the ctest
+test the same RESOURCE_LOCK and ctest -j does not start tests that would only wait for each other. The tags of a suite are not listed.
+*/
+#define RESOURCE_LOCKED_TEST_FUNCTION(name, ...) \
+    CTRS_RESOURCE_LOCK_REGISTER(name, __VA_ARGS__) \
+    static void MU_C2(name, _resource_locked)(void); \
+    TEST_FUNCTION(name) \
+    { \
+        static const char* const ctrs_resource_lock_tags[] = { __VA_ARGS__ }; \
+        CTRS_RESOURCE_LOCK_LEAVE_TEST_SERIALIZATION(); \
+        ASSERT_ARE_EQUAL(int, 0, ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, ctrs_resource_lock_tags, sizeof(ctrs_resource_lock_tags) / sizeof(ctrs_resource_lock_tags[0])), "cannot acquire the resource locks of %s", MU_TOSTRING(name)); \
+        MU_C2(name, _resource_locked)(); \
+        ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST); \
+    } \
+    static void MU_C2(name, _resource_locked)(void)
+
+#define SUITE_RESOURCE_LOCK_ACQUIRE(...) \
+    do \
+    { \
+        static const char* const ctrs_resource_lock_tags[] = { __VA_ARGS__ }; \
+        ASSERT_ARE_EQUAL(int, 0, ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_SUITE, ctrs_resource_lock_tags, sizeof(ctrs_resource_lock_tags) / sizeof(ctrs_resource_lock_tags[0])), "cannot acquire the resource locks of the suite"); \
+    } while ((void)0, 0)
+
+#define SUITE_RESOURCE_LOCK_RELEASE() \
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_SUITE)
+
+#endif /* CTRS_RESOURCE_LOCK_H */
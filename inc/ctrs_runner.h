@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_RUNNER_H
+#define CTRS_RUNNER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "ctest.h"
+
+#include "ctrs_test_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variables that select a shard when --shard is not on the command line*/
+#define CTRS_RUNNER_SHARD_INDEX_ENV "CTRS_SHARD_INDEX"
+#define CTRS_RUNNER_SHARD_COUNT_ENV "CTRS_SHARD_COUNT"
+
+    /*the runner is an alternative to RUN_TEST_SUITE used by the stock main (main_ctest.c) when the command line asks for more than running a single test by name*/
+    typedef struct CTRS_RUNNER_OPTIONS_TAG
+    {
+        CTRS_TEST_FILTER_HANDLE test_filter; /*when not NULL only the tests it matches are run (test names, --filter, --exclude, --filter-file)*/
+        const char* test_name_filter; /*the exact test name when that is all test_filter selects on, what RUN_TEST_SUITE can do*/
+        bool list_tests; /*print the names of the selected tests instead of running them*/
+        bool list_test_properties; /*with list_tests, print "name<TAB>timeout<TAB>locks<TAB>cost" per test (--list-properties)*/
+        size_t jobs; /*number of worker processes the tests are spread across, 1 = serial (default)*/
+        size_t fork_batch_size; /*0 = no fork (default), otherwise the tests run fork_batch_size at a time in children forked after the suite initialize*/
+        double test_timeout_seconds; /*deadline of every test (TEST_FUNCTION_TIMEOUT wins over it), 0 = none (default), see ctrs_watchdog.h*/
+        size_t shard_index; /*0 based index of the part of the tests to run...*/
+        size_t shard_count; /*...out of shard_count equal parts, 1 = all tests (default)*/
+        const char* report_path; /*when not NULL a report with the result and metrics of every test is written to this file or existing directory*/
+        const char* report_format; /*"junit", "json" or NULL (junit for a .xml file, JSON lines otherwise)*/
+        const char* profile_directory; /*when not NULL every test is profiled and its folded stacks are written to this directory, see ctrs_profiler.h*/
+        uint32_t profile_frequency_hz; /*samples per second of CPU time of the profiles*/
+        const char* duration_history_path; /*per test durations the tests are spread across jobs and shards by, NULL = "<suite>.durations" for --jobs without --shard, "off" = none, see ctrs_duration_history.h*/
+    } CTRS_RUNNER_OPTIONS;
+
+    /*fills options from the command line of the test executable, returns 0 on success*/
+    int ctrs_runner_parse_command_line(int argc, char* argv[], CTRS_RUNNER_OPTIONS* options);
+
+    /*frees what ctrs_runner_parse_command_line allocated in options*/
+    void ctrs_runner_options_deinit(CTRS_RUNNER_OPTIONS* options);
+
+    /*returns true when options only ask for what RUN_TEST_SUITE does (all tests, or one test by name, serially, unforked, unsharded, without deadlines, profiles, a report or a duration history)*/
+    bool ctrs_runner_is_stock_run(const CTRS_RUNNER_OPTIONS* options);
+
+    /*runs the tests of the suite whose list starts at test_list_head, returns the number of failed tests*/
+    size_t ctrs_runner_run_test_suite(const TEST_FUNCTION_DATA* test_list_head, const char* test_suite_name, const CTRS_RUNNER_OPTIONS* options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_RUNNER_H */
@@ -11,9 +11,15 @@ extern "C" {
     char* ctrs_sprintf_char(const char* format, ...);
     void ctrs_sprintf_free(char* string);
 
+    /*formats into a buffer owned by the calling thread, the result is valid until the next ctrs_sprintf_thread_local/ctrs_sprintf_thread_local_reset on the same thread*/
+    /*it does not need to be free'd, so assertion messages cost neither a malloc nor a second formatting pass*/
+    const char* ctrs_sprintf_thread_local(const char* format, ...);
+
+    /*releases the memory the calling thread's buffer grew into (the runner calls it between tests)*/
+    void ctrs_sprintf_thread_local_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* CTRS_SPRINTF_H */
-
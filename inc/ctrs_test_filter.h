@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_TEST_FILTER_H
+#define CTRS_TEST_FILTER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*prefix that makes a pattern a regular expression, patterns without it are globs*/
+#define CTRS_TEST_FILTER_REGEX_PREFIX "re:"
+
+    /*
+    A test filter is a set of include and exclude patterns, compiled once when they are added. A test name is selected when it matches
+    at least one include pattern (or there are none) and no exclude pattern.
+
+    Patterns are globs ('*' any run of characters, '?' any character, a pattern without either is an exact name) or, with the "re:" prefix,
+    regular expressions searched anywhere in the name: '.', '[a-z]', '[^a-z]', '\d', '\w', '\s', '*', '+', '?', '^' and '$'. Groups,
+    alternation and counted repetitions are rejected; several patterns are the alternation.
+    */
+    typedef struct CTRS_TEST_FILTER_TAG* CTRS_TEST_FILTER_HANDLE;
+
+    CTRS_TEST_FILTER_HANDLE ctrs_test_filter_create(void);
+    void ctrs_test_filter_destroy(CTRS_TEST_FILTER_HANDLE test_filter);
+
+    /*compiles pattern (which is copied) and adds it as an include or exclude pattern, returns 0 on success*/
+    int ctrs_test_filter_add(CTRS_TEST_FILTER_HANDLE test_filter, const char* pattern, bool exclude);
+
+    /*adds the patterns of a file, one per line: empty lines and lines starting with '#' are skipped, a leading '-' makes the pattern an exclude*/
+    int ctrs_test_filter_add_from_file(CTRS_TEST_FILTER_HANDLE test_filter, const char* file_name);
+
+    bool ctrs_test_filter_matches(CTRS_TEST_FILTER_HANDLE test_filter, const char* test_name);
+
+    /*returns the name when the filter is exactly one include pattern that is an exact name (what RUN_TEST_SUITE can filter on), NULL otherwise*/
+    const char* ctrs_test_filter_get_single_name(CTRS_TEST_FILTER_HANDLE test_filter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_TEST_FILTER_H */
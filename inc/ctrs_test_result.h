@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_TEST_RESULT_H
+#define CTRS_TEST_RESULT_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "ctrs_alloc_count.h"
+#include "ctrs_perf_counters.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CTRS_TEST_OUTCOME_VALUES \
+    CTRS_TEST_OUTCOME_NOT_EXECUTED, \
+    CTRS_TEST_OUTCOME_PASSED, \
+    CTRS_TEST_OUTCOME_FAILED
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_TEST_OUTCOME, CTRS_TEST_OUTCOME_VALUES)
+
+    /*what running one test cost, measured around function initialize + test + function cleanup*/
+    typedef struct CTRS_TEST_METRICS_TAG
+    {
+        uint64_t wall_time_ns; /*monotonic clock*/
+        uint64_t cpu_time_ns; /*user + system time of the process*/
+        int64_t peak_rss_delta_kb; /*how much the peak resident set size of the process grew*/
+        uint64_t voluntary_context_switches;
+        uint64_t involuntary_context_switches;
+        bool allocations_counted; /*false when the exe does not count allocations (see ctrs_alloc_count.h), the 3 counts below are then 0*/
+        uint64_t allocation_count; /*malloc, calloc and realloc calls*/
+        uint64_t free_count;
+        uint64_t allocated_bytes;
+        CTRS_PERF_COUNTS perf_counts; /*hardware counters, only with CTRS_PERF_COUNTERS (see ctrs_perf_counters.h)*/
+    } CTRS_TEST_METRICS;
+
+    typedef struct CTRS_TEST_RESULT_TAG
+    {
+        CTRS_TEST_OUTCOME outcome;
+        CTRS_TEST_METRICS metrics;
+    } CTRS_TEST_RESULT;
+
+    /*a point in time of the process, the metrics of a test are the difference between the samples before and after it*/
+    typedef struct CTRS_TEST_METRICS_SAMPLE_TAG
+    {
+        uint64_t monotonic_ns;
+        uint64_t cpu_time_ns;
+        int64_t peak_rss_kb;
+        uint64_t voluntary_context_switches;
+        uint64_t involuntary_context_switches;
+        CTRS_ALLOCATION_COUNTS allocation_counts;
+        CTRS_PERF_COUNTS perf_counts;
+    } CTRS_TEST_METRICS_SAMPLE;
+
+    void ctrs_test_metrics_sample(CTRS_TEST_METRICS_SAMPLE* sample);
+    void ctrs_test_metrics_compute(const CTRS_TEST_METRICS_SAMPLE* before, const CTRS_TEST_METRICS_SAMPLE* after, CTRS_TEST_METRICS* metrics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_TEST_RESULT_H */
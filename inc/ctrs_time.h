@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_TIME_H
+#define CTRS_TIME_H
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif
+
+    /*returns a monotonic time in nanoseconds, only differences between two values are meaningful*/
+    uint64_t ctrs_time_monotonic_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CTRS_TIME_H */
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CTRS_WATCHDOG_H
+#define CTRS_WATCHDOG_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*environment variable with the deadline of every test of the suite in seconds (TEST_TIMEOUT of build_test_artifacts), --timeout wins over it*/
+#define CTRS_TEST_TIMEOUT_ENV "CTRS_TEST_TIMEOUT"
+
+/*exit code of a forked child ended by the watchdog, the same as timeout(1)*/
+#define CTRS_WATCHDOG_TIMEOUT_EXIT_CODE 124
+
+    /*the deadline of the tests of one TEST_FUNCTION, see TEST_FUNCTION_TIMEOUT*/
+    typedef struct CTRS_TEST_TIMEOUT_TAG
+    {
+        const char* test_name;
+        double timeout_seconds;
+        struct CTRS_TEST_TIMEOUT_TAG* next_registered;
+    } CTRS_TEST_TIMEOUT;
+
+    void ctrs_watchdog_register_test_timeout(CTRS_TEST_TIMEOUT* test_timeout);
+
+    bool ctrs_watchdog_any_test_timeout_registered(void);
+
+    /*returns the deadline registered for the TEST_FUNCTION test_name, default_timeout_seconds when it has none*/
+    double ctrs_watchdog_get_test_timeout(const char* test_name, double default_timeout_seconds);
+
+    /*
+    Starts watching the calling thread, which is about to run the test test_name. When timeout_seconds pass before ctrs_watchdog_disarm, the
+    watchdog logs the name of the test and the backtraces of all the threads of the process, kills the processes of the test (see
+    ctrs_watchdog_add_test_process) and ends the process with CTRS_WATCHDOG_TIMEOUT_EXIT_CODE. A test is not interrupted in the process
+    that runs it, so the calling process is one the runner can lose: a child forked to run the tests, which the runner reports from its exit
+    code before it goes on with the next tests in a new child. Returns 0 on success, non-zero when the platform has no watchdog.
+    */
+    int ctrs_watchdog_arm(const char* test_name, double timeout_seconds);
+
+    /*stops watching*/
+    void ctrs_watchdog_disarm(void);
+
+    /*
+    process_id is a process forked by the test (the worker of a concurrent table test), which is killed and collected with the test when it
+    times out, until it is removed once the test collected it itself. Without a deadline (no watchdog yet) they do nothing.
+    */
+    void ctrs_watchdog_add_test_process(int process_id);
+    void ctrs_watchdog_remove_test_process(int process_id);
+
+    /*logs the backtraces of all the threads of the process (not available on Windows)*/
+    void ctrs_watchdog_log_all_thread_backtraces(void);
+
+    /*stops the thread of the watchdog of the process, if it was started*/
+    void ctrs_watchdog_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*registers test_timeout (CTRS_TEST_TIMEOUT* getter(void)) before main*/
+#if defined(__cplusplus)
+/*cppunittest has its own timeouts (TEST_METHOD_ATTRIBUTE), the stock runner never runs a C++ test file*/
+#define CTRS_WATCHDOG_REGISTER(getter)
+#elif defined(_MSC_VER)
+#pragma section(".CRT$XCU", read)
+#define CTRS_WATCHDOG_REGISTER(getter) \
+    static void __cdecl MU_C2(getter, _register)(void) \
+    { \
+        ctrs_watchdog_register_test_timeout(getter()); \
+    } \
+    __declspec(allocate(".CRT$XCU")) void (__cdecl* const MU_C2(getter, _initializer))(void) = MU_C2(getter, _register);
+#else
+#define CTRS_WATCHDOG_REGISTER(getter) \
+    __attribute__((constructor)) static void MU_C2(getter, _register)(void) \
+    { \
+        ctrs_watchdog_register_test_timeout(getter()); \
+    }
+#endif
+
+/*
+TEST_FUNCTION_TIMEOUT(name, seconds), at file scope, gives the TEST_FUNCTION name (all the rows of a table test, all the cases of a
+parameterized test when name is the name of the case) its own deadline, instead of the --timeout of the run or the TEST_TIMEOUT of the suite.
+A test that is still running at its deadline fails, after the name of the test and the backtraces of all the threads are logged: the child
+process running it is killed and the next tests go on in a new child.
+
+TEST_FUNCTION_TIMEOUT(connect_retries_until_the_server_is_up, 30)
+TEST_FUNCTION(connect_retries_until_the_server_is_up)
+{
+    ...
+}
+*/
+#define TEST_FUNCTION_TIMEOUT(name, seconds) \
+    static CTRS_TEST_TIMEOUT* MU_C2(name, _test_timeout)(void) \
+    { \
+        static CTRS_TEST_TIMEOUT test_timeout = { MU_TOSTRING(name), (seconds), NULL }; \
+        return &test_timeout; \
+    } \
+    CTRS_WATCHDOG_REGISTER(MU_C2(name, _test_timeout))
+
+#endif /* CTRS_WATCHDOG_H */
@@ -4,15 +4,21 @@
 #ifndef TESTMUTEX_H
 #define TESTMUTEX_H
 
-#ifdef _MSC_VER
+#if defined(_MSC_VER) || !defined(_WIN32)
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*on POSIX, when this environment variable is set, the mutex is shared by all the processes that create it with the same value (otherwise it is private to the process)*/
+#define TESTMUTEX_NAME_ENV "CTRS_TEST_MUTEX_NAME"
+
     typedef void* TEST_MUTEX_HANDLE;
 
     extern TEST_MUTEX_HANDLE testmutex_create(void);
+    /*a mutex shared by all the processes that create it with the same name, whatever TESTMUTEX_NAME_ENV says ('/' in the name is the same as '_' on POSIX)*/
+    extern TEST_MUTEX_HANDLE testmutex_create_named(const char* name);
     extern int testmutex_acquire(TEST_MUTEX_HANDLE mutex);
+    /*returns non-zero, and releases nothing, when the calling thread does not hold the mutex*/
     extern int testmutex_release(TEST_MUTEX_HANDLE mutex);
     extern void testmutex_destroy(TEST_MUTEX_HANDLE mutex);
 
@@ -20,7 +26,6 @@ extern "C" {
 }
 #endif
 
-#endif /* _MSC_VER */
+#endif /* defined(_MSC_VER) || !defined(_WIN32) */
 
 #endif /*MICROMOCKTESTMUTEX_H*/
-
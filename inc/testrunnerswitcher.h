@@ -72,11 +72,21 @@ typedef void* TEST_MUTEX_HANDLE;
 
 #define PARAMETERIZED_TEST_FUNCTION                 CTEST_PARAMETERIZED_TEST_FUNCTION
 
+#ifdef _WIN32
 #define TEST_MUTEX_CREATE()             (TEST_MUTEX_HANDLE)1
 // the strlen check is simply to shut the compiler up and not create a hell of #pragma warning suppress
 #define TEST_MUTEX_ACQUIRE(mutex)       (strlen("a") == 0)
 #define TEST_MUTEX_RELEASE(mutex)
 #define TEST_MUTEX_DESTROY(mutex)
+#else
+// a recursive mutex, also serializing all the test processes that set the same CTRS_TEST_MUTEX_NAME (see testmutex_linux.c)
+#include "testmutex.h"
+
+#define TEST_MUTEX_CREATE()             testmutex_create()
+#define TEST_MUTEX_ACQUIRE(mutex)       testmutex_acquire(mutex)
+#define TEST_MUTEX_RELEASE(mutex)       testmutex_release(mutex)
+#define TEST_MUTEX_DESTROY(mutex)       testmutex_destroy(mutex)
+#endif
 
 #elif defined CPP_UNITTEST
 
@@ -112,8 +122,9 @@ extern "C" void CPPUNITTEST_SYMBOL(void) {}
 
 // these are generic macros for formatting the optional message
 // they can be used in all the ASSERT macros without repeating the code over and over again
+// the message lives in a thread local buffer (see ctrs_sprintf_thread_local) and is copied by ToString right away
 #define CONSTRUCT_CTRS_MESSAGE_FORMATTED(format, ...) \
-    MU_IF(MU_COUNT_ARG(__VA_ARGS__), ctrs_sprintf_char(format, __VA_ARGS__), ctrs_sprintf_char(format));
+    MU_IF(MU_COUNT_ARG(__VA_ARGS__), ctrs_sprintf_thread_local(format, __VA_ARGS__), ctrs_sprintf_thread_local(format));
 
 #define CONSTRUCT_CTRS_MESSAGE_FORMATTED_EMPTY(...) \
     NULL
@@ -124,63 +135,56 @@ extern "C" void CPPUNITTEST_SYMBOL(void) {}
 #define ASSERT_ARE_EQUAL(type, A, B, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::AreEqual((type)(A), (type)(B), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_ARE_NOT_EQUAL(type, A, B, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::AreNotEqual((type)(A), (type)(B), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_FAIL(...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::Fail(cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_IS_TRUE(expression, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::IsTrue((expression), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_IS_FALSE(expression, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::IsFalse((expression), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_IS_NOT_NULL(value, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::IsNotNull((value), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
 #define ASSERT_IS_NULL(value, ...) \
     do \
     { \
-        char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
+        const char* ctrs_message = CONSTRUCT_CTRS_MESSAGE(__VA_ARGS__); \
         std::wstring cppUnitTestMessage = ToString(ctrs_message); \
-        ctrs_sprintf_free(ctrs_message); \
         Assert::IsNull((value), cppUnitTestMessage.c_str()); \
     } while ((void)0, 0)
 
@@ -295,4 +299,13 @@ namespace Microsoft
 #error No test runner defined
 #endif
 
+#include "ctrs_benchmark.h"
+#include "ctrs_resource_lock.h"
+#include "ctrs_data_table.h"
+#include "ctrs_watchdog.h"
+#include "ctrs_alloc_count.h"
+#include "ctrs_perf_counters.h"
+#include "ctrs_histogram.h"
+#include "ctrs_concurrent.h"
+
 #endif
@@ -9,8 +9,12 @@
 
 #include "testrunnerswitcher.h"
 #include "testmutex.h"
+#include "ctrs_sprintf.h"
+#include "ctrs_resource_lock.h"
 
 static TEST_MUTEX_HANDLE g_cppunittest_serialize_mutex;
+/*the test running on this thread holds g_cppunittest_serialize_mutex, a tagged test lets go of it before taking its tags*/
+static thread_local bool g_serialize_mutex_held;
 
 void cppunittest_mutex_fixtures_suite_init(void)
 {
@@ -20,6 +24,7 @@ void cppunittest_mutex_fixtures_suite_init(void)
 
 void cppunittest_mutex_fixtures_suite_cleanup(void)
 {
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_SUITE);
     TEST_MUTEX_DESTROY(g_cppunittest_serialize_mutex);
     logger_deinit();
 }
@@ -30,9 +35,23 @@ void cppunittest_mutex_fixtures_function_init(void)
     {
         ASSERT_FAIL("Could not acquire test serialization mutex.");
     }
+    g_serialize_mutex_held = true;
+}
+
+void cppunittest_mutex_fixtures_leave_serialization(void)
+{
+    if (g_serialize_mutex_held)
+    {
+        g_serialize_mutex_held = false;
+        TEST_MUTEX_RELEASE(g_cppunittest_serialize_mutex);
+    }
 }
 
 void cppunittest_mutex_fixtures_function_cleanup(void)
 {
-    TEST_MUTEX_RELEASE(g_cppunittest_serialize_mutex);
+    /*assertion messages of the test are formatted in a thread local buffer, release what it grew into*/
+    ctrs_sprintf_thread_local_reset();
+    /*a test that failed an assertion while holding resource locks did not get to release them*/
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+    cppunittest_mutex_fixtures_leave_serialization();
 }
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_alloc_count.h"
+
+/*updated by every thread of the process with relaxed atomics, a sample is not a consistent snapshot of all the counts (nor needs to be)*/
+static CTRS_ALLOCATION_COUNTS g_allocation_counts;
+static bool g_counting;
+
+#ifdef _MSC_VER
+/*nothing replaces the allocator on Windows, the counts are only read*/
+#define COUNTER_ADD(counter, value) ((void)(counter), (void)(value))
+#define COUNTER_LOAD(counter) (counter)
+#else
+#define COUNTER_ADD(counter, value) ((void)__atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED))
+#define COUNTER_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#endif
+
+bool ctrs_alloc_count_is_enabled(void)
+{
+    return g_counting;
+}
+
+void ctrs_alloc_count_get(CTRS_ALLOCATION_COUNTS* counts)
+{
+    if (counts == NULL)
+    {
+        LogError("Invalid arguments CTRS_ALLOCATION_COUNTS* counts=%p", (void*)counts);
+    }
+    else
+    {
+        counts->malloc_count = COUNTER_LOAD(g_allocation_counts.malloc_count);
+        counts->calloc_count = COUNTER_LOAD(g_allocation_counts.calloc_count);
+        counts->realloc_count = COUNTER_LOAD(g_allocation_counts.realloc_count);
+        counts->free_count = COUNTER_LOAD(g_allocation_counts.free_count);
+        counts->allocated_bytes = COUNTER_LOAD(g_allocation_counts.allocated_bytes);
+    }
+}
+
+uint64_t ctrs_alloc_count_allocations_since(const CTRS_ALLOCATION_COUNTS* start)
+{
+    uint64_t result;
+
+    if (start == NULL)
+    {
+        LogError("Invalid arguments const CTRS_ALLOCATION_COUNTS* start=%p", (void*)start);
+        result = 0;
+    }
+    else
+    {
+        CTRS_ALLOCATION_COUNTS now;
+        ctrs_alloc_count_get(&now);
+        result = (now.malloc_count - start->malloc_count) + (now.calloc_count - start->calloc_count) + (now.realloc_count - start->realloc_count);
+    }
+
+    return result;
+}
+
+uint64_t ctrs_alloc_count_allocated_bytes_since(const CTRS_ALLOCATION_COUNTS* start)
+{
+    uint64_t result;
+
+    if (start == NULL)
+    {
+        LogError("Invalid arguments const CTRS_ALLOCATION_COUNTS* start=%p", (void*)start);
+        result = 0;
+    }
+    else
+    {
+        result = COUNTER_LOAD(g_allocation_counts.allocated_bytes) - start->allocated_bytes;
+    }
+
+    return result;
+}
+
+void ctrs_alloc_count_enable(void)
+{
+    g_counting = true;
+}
+
+void ctrs_alloc_count_on_malloc(size_t size)
+{
+    COUNTER_ADD(g_allocation_counts.malloc_count, 1);
+    COUNTER_ADD(g_allocation_counts.allocated_bytes, size);
+}
+
+void ctrs_alloc_count_on_calloc(size_t size)
+{
+    COUNTER_ADD(g_allocation_counts.calloc_count, 1);
+    COUNTER_ADD(g_allocation_counts.allocated_bytes, size);
+}
+
+void ctrs_alloc_count_on_realloc(size_t size)
+{
+    COUNTER_ADD(g_allocation_counts.realloc_count, 1);
+    COUNTER_ADD(g_allocation_counts.allocated_bytes, size);
+}
+
+void ctrs_alloc_count_on_free(void)
+{
+    COUNTER_ADD(g_allocation_counts.free_count, 1);
+}
@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "ctrs_alloc_count.h"
+
+/*
+Linked (as an object library) into the exes built with COUNT_ALLOCATIONS: the exe defines malloc, calloc, realloc and free, so the dynamic
+linker binds every call of the process to them, the C library and the other shared libraries included. They count the call and forward it to
+the glibc allocator (__libc_malloc & co.), so the memory, and what valgrind sees of it, is the same as without counting.
+*/
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+/*called through a volatile pointer so that the compiler cannot drop the malloc/free pair of the probe*/
+static void* (*volatile g_malloc_probe)(size_t size) = malloc;
+
+__attribute__((constructor)) static void enable_allocation_counting(void)
+{
+    /*valgrind replaces the malloc of the exe too, the counts would then stay 0 and the budgets pass for the wrong reason*/
+    CTRS_ALLOCATION_COUNTS before;
+    CTRS_ALLOCATION_COUNTS after;
+    void* probe;
+
+    ctrs_alloc_count_get(&before);
+    probe = g_malloc_probe(1);
+    ctrs_alloc_count_get(&after);
+    free(probe);
+
+    if (after.malloc_count != before.malloc_count)
+    {
+        ctrs_alloc_count_enable();
+    }
+}
+
+void* malloc(size_t size)
+{
+    ctrs_alloc_count_on_malloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    ctrs_alloc_count_on_calloc(((size != 0) && (count > SIZE_MAX / size)) ? SIZE_MAX : count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    ctrs_alloc_count_on_realloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        ctrs_alloc_count_on_free();
+    }
+    __libc_free(ptr);
+}
+
+/*the aligned allocations are freed with free, so they come from the same allocator*/
+void* memalign(size_t alignment, size_t size)
+{
+    ctrs_alloc_count_on_malloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    ctrs_alloc_count_on_malloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size)
+{
+    int result;
+
+    if ((alignment % sizeof(void*) != 0) || ((alignment & (alignment - 1)) != 0) || (alignment == 0))
+    {
+        result = EINVAL;
+    }
+    else
+    {
+        void* allocated;
+
+        ctrs_alloc_count_on_malloc(size);
+        allocated = __libc_memalign(alignment, size);
+        if (allocated == NULL)
+        {
+            result = ENOMEM;
+        }
+        else
+        {
+            *memptr = allocated;
+            result = 0;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,250 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_time.h"
+#include "ctrs_perf_baseline.h"
+#include "ctrs_perf_counters.h"
+
+#include "ctrs_benchmark.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(CTRS_BENCHMARK_PHASE, CTRS_BENCHMARK_PHASE_VALUES)
+
+#define NS_PER_MS 1000000
+
+/*a batch during warmup grows at most this many times, so that one slow iteration cannot blow up the next batch*/
+#define CTRS_BENCHMARK_MAX_BATCH_GROWTH 10
+
+static uint64_t read_ms_from_environment(const char* name, uint64_t default_value)
+{
+    uint64_t result;
+    const char* value = getenv(name);
+
+    if ((value == NULL) || (value[0] == '\0'))
+    {
+        result = default_value;
+    }
+    else
+    {
+        char* end;
+        unsigned long long parsed = strtoull(value, &end, 10);
+        if ((*end != '\0') || (value[0] == '-'))
+        {
+            LogWarning("ignoring invalid %s=%s, using %" PRIu64, name, value, default_value);
+            result = default_value;
+        }
+        else
+        {
+            result = (uint64_t)parsed;
+        }
+    }
+
+    return result;
+}
+
+void ctrs_benchmark_begin(CTRS_BENCHMARK* benchmark, const char* name)
+{
+    uint64_t sample_count;
+
+    benchmark->name = name;
+    benchmark->phase = CTRS_BENCHMARK_PHASE_NOT_STARTED;
+    benchmark->remaining_iterations = 0;
+    benchmark->batch_iterations = 1;
+    benchmark->batch_start_ns = 0;
+    benchmark->phase_start_ns = 0;
+    benchmark->sample_count = 0;
+    (void)memset(&benchmark->statistics, 0, sizeof(benchmark->statistics));
+
+    benchmark->warmup_ns = read_ms_from_environment(CTRS_BENCHMARK_WARMUP_MS_ENV, CTRS_BENCHMARK_DEFAULT_WARMUP_MS) * NS_PER_MS;
+    benchmark->sample_ns = read_ms_from_environment(CTRS_BENCHMARK_SAMPLE_MS_ENV, CTRS_BENCHMARK_DEFAULT_SAMPLE_MS) * NS_PER_MS;
+    benchmark->max_time_ns = read_ms_from_environment(CTRS_BENCHMARK_MAX_TIME_MS_ENV, CTRS_BENCHMARK_DEFAULT_MAX_TIME_MS) * NS_PER_MS;
+
+    sample_count = read_ms_from_environment(CTRS_BENCHMARK_SAMPLES_ENV, CTRS_BENCHMARK_DEFAULT_SAMPLES);
+    if (sample_count < CTRS_BENCHMARK_MIN_SAMPLES)
+    {
+        sample_count = CTRS_BENCHMARK_MIN_SAMPLES;
+    }
+    else if (sample_count > CTRS_BENCHMARK_MAX_SAMPLES)
+    {
+        sample_count = CTRS_BENCHMARK_MAX_SAMPLES;
+    }
+    benchmark->max_sample_count = (size_t)sample_count;
+}
+
+/*number of iterations expected to take target_ns, given that iterations took elapsed_ns, not growing by more than CTRS_BENCHMARK_MAX_BATCH_GROWTH*/
+static uint64_t scale_batch(uint64_t iterations, uint64_t elapsed_ns, uint64_t target_ns)
+{
+    uint64_t result;
+
+    if (elapsed_ns == 0)
+    {
+        result = iterations * CTRS_BENCHMARK_MAX_BATCH_GROWTH;
+    }
+    else
+    {
+        double scaled = (double)iterations * (double)target_ns / (double)elapsed_ns;
+        double max_scaled = (double)iterations * CTRS_BENCHMARK_MAX_BATCH_GROWTH;
+        result = (uint64_t)((scaled < max_scaled) ? scaled : max_scaled);
+    }
+
+    return (result == 0) ? 1 : result;
+}
+
+bool ctrs_benchmark_next_batch(CTRS_BENCHMARK* benchmark)
+{
+    bool result;
+    uint64_t now = ctrs_time_monotonic_ns();
+    uint64_t elapsed = now - benchmark->batch_start_ns;
+
+    switch (benchmark->phase)
+    {
+        default:
+        case CTRS_BENCHMARK_PHASE_DONE:
+            /*the loop is over, BENCHMARK_LOOP entered again is not measured*/
+            result = false;
+            break;
+        case CTRS_BENCHMARK_PHASE_NOT_STARTED:
+            benchmark->phase = CTRS_BENCHMARK_PHASE_WARMUP;
+            benchmark->phase_start_ns = now;
+            benchmark->batch_iterations = 1;
+            result = true;
+            break;
+        case CTRS_BENCHMARK_PHASE_WARMUP:
+            if ((now - benchmark->phase_start_ns) < benchmark->warmup_ns)
+            {
+                /*warm caches, branch predictors and CPU frequency while growing the batch towards the sample time*/
+                if (elapsed < benchmark->sample_ns)
+                {
+                    benchmark->batch_iterations = scale_batch(benchmark->batch_iterations, elapsed, benchmark->sample_ns);
+                }
+            }
+            else
+            {
+                /*the last warmup batch is the best estimate of the cost of one iteration*/
+                benchmark->batch_iterations = scale_batch(benchmark->batch_iterations, elapsed, benchmark->sample_ns);
+                benchmark->phase = CTRS_BENCHMARK_PHASE_MEASURE;
+                benchmark->phase_start_ns = now;
+                ctrs_perf_counters_read(&benchmark->perf_counts_at_measure_start);
+            }
+            result = true;
+            break;
+        case CTRS_BENCHMARK_PHASE_MEASURE:
+            benchmark->samples[benchmark->sample_count] = (double)elapsed / (double)benchmark->batch_iterations;
+            benchmark->sample_count++;
+
+            if (
+                (benchmark->sample_count >= benchmark->max_sample_count) ||
+                ((benchmark->sample_count >= CTRS_BENCHMARK_MIN_SAMPLES) && ((now - benchmark->phase_start_ns) >= benchmark->max_time_ns))
+                )
+            {
+                CTRS_PERF_COUNTS perf_counts_at_measure_end;
+                ctrs_perf_counters_read(&perf_counts_at_measure_end);
+                ctrs_perf_counts_delta(&benchmark->perf_counts_at_measure_start, &perf_counts_at_measure_end, &benchmark->statistics.perf_counts);
+
+                benchmark->phase = CTRS_BENCHMARK_PHASE_DONE;
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+            break;
+    }
+
+    if (result)
+    {
+        /*this call counts as the first iteration of the batch*/
+        benchmark->remaining_iterations = benchmark->batch_iterations - 1;
+        benchmark->batch_start_ns = ctrs_time_monotonic_ns();
+    }
+    else
+    {
+        benchmark->remaining_iterations = 0;
+    }
+
+    return result;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+int ctrs_benchmark_end(CTRS_BENCHMARK* benchmark)
+{
+    int result;
+
+    if (benchmark->phase != CTRS_BENCHMARK_PHASE_DONE)
+    {
+        LogError("benchmark %s: BENCHMARK_LOOP was not run to completion (phase=%" PRI_MU_ENUM ")", benchmark->name, MU_ENUM_VALUE(CTRS_BENCHMARK_PHASE, benchmark->phase));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        CTRS_BENCHMARK_STATISTICS* statistics = &benchmark->statistics;
+        size_t count = benchmark->sample_count;
+        size_t i;
+        double sum = 0;
+        double squared_deviations = 0;
+        size_t p99_rank;
+
+        qsort(benchmark->samples, count, sizeof(double), compare_doubles);
+
+        for (i = 0; i < count; i++)
+        {
+            sum += benchmark->samples[i];
+        }
+
+        statistics->sample_count = count;
+        statistics->iterations_per_sample = benchmark->batch_iterations;
+        statistics->measured_iterations = (uint64_t)count * benchmark->batch_iterations;
+        statistics->min_ns = benchmark->samples[0];
+        statistics->median_ns = ((count % 2) == 1) ? benchmark->samples[count / 2] : ((benchmark->samples[(count / 2) - 1] + benchmark->samples[count / 2]) / 2);
+        statistics->mean_ns = sum / (double)count;
+
+        /*nearest rank*/
+        p99_rank = (size_t)ceil(0.99 * (double)count);
+        statistics->p99_ns = benchmark->samples[(p99_rank == 0) ? 0 : (p99_rank - 1)];
+
+        for (i = 0; i < count; i++)
+        {
+            double deviation = benchmark->samples[i] - statistics->mean_ns;
+            squared_deviations += deviation * deviation;
+        }
+        statistics->stddev_ns = sqrt(squared_deviations / (double)(count - 1));
+        statistics->ops_per_second = (statistics->mean_ns > 0) ? (1000000000.0 / statistics->mean_ns) : 0;
+
+        LogInfo("Benchmark %s: %zu samples x %" PRIu64 " iterations, ns/op min=%.2f median=%.2f mean=%.2f p99=%.2f stddev=%.2f, %.0f ops/sec",
+            benchmark->name, statistics->sample_count, statistics->iterations_per_sample,
+            statistics->min_ns, statistics->median_ns, statistics->mean_ns, statistics->p99_ns, statistics->stddev_ns, statistics->ops_per_second);
+
+        if (ctrs_perf_counts_any_counted(&statistics->perf_counts))
+        {
+            char formatted[256];
+            ctrs_perf_counts_format(&statistics->perf_counts, (double)statistics->measured_iterations, formatted, sizeof(formatted));
+            LogInfo("Benchmark %s: per op %s", benchmark->name, formatted);
+        }
+
+        /*the median and not the mean, so that a few preempted samples do not fail the benchmark*/
+        result = ctrs_perf_baseline_apply(benchmark->name, statistics->median_ns);
+    }
+
+    return result;
+}
+
+void ctrs_benchmark_do_not_optimize(const volatile void* value)
+{
+    (void)value;
+}
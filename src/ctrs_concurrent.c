@@ -0,0 +1,444 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <setjmp.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_time.h"
+
+#include "ctrs_concurrent.h"
+
+#ifdef _MSC_VER
+#define CTRS_THREAD_LOCAL __declspec(thread)
+#else
+#define CTRS_THREAD_LOCAL __thread
+#endif
+
+/*1, 2, 4, ... covers 2^63 processors*/
+#define MAX_SWEEP_THREAD_COUNTS 64
+
+/*holds the threads until all of them are started, then releases them together (or tells them not to run the body when some could not be started)*/
+typedef struct START_GATE_TAG
+{
+#ifdef _WIN32
+    SRWLOCK lock;
+    CONDITION_VARIABLE changed;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+#endif
+    size_t arrived_count;
+    bool released;
+    bool cancelled;
+} START_GATE;
+
+typedef struct CONCURRENT_THREAD_TAG
+{
+    size_t thread_index;
+    size_t thread_count;
+    CTRS_CONCURRENT_BODY body;
+    START_GATE* start_gate;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    jmp_buf failure_jump;
+    bool failed;
+    char failure[CTRS_CONCURRENT_FAILURE_SIZE];
+    uint64_t operations;
+    uint64_t end_ns;
+} CONCURRENT_THREAD;
+
+/*the thread of the body running on this thread, NULL on the other threads*/
+static CTRS_THREAD_LOCAL CONCURRENT_THREAD* g_current_thread;
+
+static size_t get_processor_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (system_info.dwNumberOfProcessors > 0) ? (size_t)system_info.dwNumberOfProcessors : 1;
+#else
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processor_count > 0) ? (size_t)processor_count : 1;
+#endif
+}
+
+static bool is_sweep_requested(void)
+{
+    const char* value = getenv(CTRS_CONCURRENT_SWEEP_ENV);
+    return (value != NULL) && (value[0] != '\0') && (strcmp(value, "0") != 0);
+}
+
+#ifdef _WIN32
+static void start_gate_init(START_GATE* start_gate)
+{
+    InitializeSRWLock(&start_gate->lock);
+    InitializeConditionVariable(&start_gate->changed);
+    start_gate->arrived_count = 0;
+    start_gate->released = false;
+    start_gate->cancelled = false;
+}
+
+static void start_gate_deinit(START_GATE* start_gate)
+{
+    (void)start_gate;
+}
+
+#define start_gate_lock(start_gate) AcquireSRWLockExclusive(&(start_gate)->lock)
+#define start_gate_unlock(start_gate) ReleaseSRWLockExclusive(&(start_gate)->lock)
+#define start_gate_wait(start_gate) (void)SleepConditionVariableSRW(&(start_gate)->changed, &(start_gate)->lock, INFINITE, 0)
+#define start_gate_notify_all(start_gate) WakeAllConditionVariable(&(start_gate)->changed)
+#else
+static void start_gate_init(START_GATE* start_gate)
+{
+    (void)pthread_mutex_init(&start_gate->lock, NULL);
+    (void)pthread_cond_init(&start_gate->changed, NULL);
+    start_gate->arrived_count = 0;
+    start_gate->released = false;
+    start_gate->cancelled = false;
+}
+
+static void start_gate_deinit(START_GATE* start_gate)
+{
+    (void)pthread_cond_destroy(&start_gate->changed);
+    (void)pthread_mutex_destroy(&start_gate->lock);
+}
+
+#define start_gate_lock(start_gate) (void)pthread_mutex_lock(&(start_gate)->lock)
+#define start_gate_unlock(start_gate) (void)pthread_mutex_unlock(&(start_gate)->lock)
+#define start_gate_wait(start_gate) (void)pthread_cond_wait(&(start_gate)->changed, &(start_gate)->lock)
+#define start_gate_notify_all(start_gate) (void)pthread_cond_broadcast(&(start_gate)->changed)
+#endif
+
+/*called by every thread, returns false when the run is cancelled*/
+static bool start_gate_arrive_and_wait(START_GATE* start_gate)
+{
+    bool result;
+
+    start_gate_lock(start_gate);
+    start_gate->arrived_count++;
+    start_gate_notify_all(start_gate);
+    while (!start_gate->released)
+    {
+        start_gate_wait(start_gate);
+    }
+    result = !start_gate->cancelled;
+    start_gate_unlock(start_gate);
+
+    return result;
+}
+
+/*called by the test thread once the started_count threads are started*/
+static void start_gate_release(START_GATE* start_gate, size_t started_count, bool cancelled)
+{
+    start_gate_lock(start_gate);
+    while (start_gate->arrived_count < started_count)
+    {
+        start_gate_wait(start_gate);
+    }
+    start_gate->released = true;
+    start_gate->cancelled = cancelled;
+    start_gate_notify_all(start_gate);
+    start_gate_unlock(start_gate);
+}
+
+static void run_body(CONCURRENT_THREAD* thread)
+{
+    g_current_thread = thread;
+
+    /*all the threads are created before any of them runs the body*/
+    if (!start_gate_arrive_and_wait(thread->start_gate))
+    {
+        /*some threads could not be started, the run failed already*/
+    }
+    else if (setjmp(thread->failure_jump) == 0)
+    {
+        thread->body();
+    }
+    else
+    {
+        /*a CONCURRENT_ASSERT_* failed, the failure is recorded*/
+    }
+
+    thread->end_ns = ctrs_time_monotonic_ns();
+    g_current_thread = NULL;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI concurrent_thread_function(LPVOID context)
+{
+    run_body(context);
+    return 0;
+}
+#else
+static void* concurrent_thread_function(void* context)
+{
+    run_body(context);
+    return NULL;
+}
+#endif
+
+/*runs body on thread_count threads, fills result, returns 0 when no thread failed*/
+static int run_once(const char* test_name, size_t thread_count, CTRS_CONCURRENT_BODY body, CTRS_CONCURRENT_RUN_RESULT* result)
+{
+    int run_result;
+    CONCURRENT_THREAD* threads = calloc(thread_count, sizeof(CONCURRENT_THREAD));
+
+    if (threads == NULL)
+    {
+        LogError("failure in calloc(%zu, sizeof(CONCURRENT_THREAD))", thread_count);
+        run_result = MU_FAILURE;
+    }
+    else
+    {
+        START_GATE start_gate;
+        size_t started_count = 0;
+        size_t failed_count = 0;
+        uint64_t start_ns;
+        uint64_t end_ns = 0;
+        uint64_t operations = 0;
+        size_t i;
+
+        start_gate_init(&start_gate);
+
+        for (i = 0; i < thread_count; i++)
+        {
+            bool started;
+            threads[i].thread_index = i;
+            threads[i].thread_count = thread_count;
+            threads[i].body = body;
+            threads[i].start_gate = &start_gate;
+#ifdef _WIN32
+            threads[i].handle = CreateThread(NULL, 0, concurrent_thread_function, &threads[i], 0, NULL);
+            started = (threads[i].handle != NULL);
+#else
+            started = (pthread_create(&threads[i].handle, NULL, concurrent_thread_function, &threads[i]) == 0);
+#endif
+            if (!started)
+            {
+                LogError("failure creating thread %zu of %zu", i, thread_count);
+                break;
+            }
+            started_count++;
+        }
+
+        start_gate_release(&start_gate, started_count, (started_count != thread_count));
+        start_ns = ctrs_time_monotonic_ns();
+
+        for (i = 0; i < started_count; i++)
+        {
+#ifdef _WIN32
+            (void)WaitForSingleObject(threads[i].handle, INFINITE);
+            (void)CloseHandle(threads[i].handle);
+#else
+            (void)pthread_join(threads[i].handle, NULL);
+#endif
+            if (threads[i].failed)
+            {
+                LogError("%s: thread %zu of %zu failed: %s", test_name, i, thread_count, threads[i].failure);
+                failed_count++;
+            }
+            operations += (threads[i].operations == 0) ? 1 : threads[i].operations;
+            if (threads[i].end_ns > end_ns)
+            {
+                end_ns = threads[i].end_ns;
+            }
+        }
+
+        start_gate_deinit(&start_gate);
+
+        (void)memset(result, 0, sizeof(CTRS_CONCURRENT_RUN_RESULT));
+        result->thread_count = thread_count;
+        result->operations = operations;
+        result->elapsed_ns = (end_ns > start_ns) ? (end_ns - start_ns) : 0;
+        result->operations_per_second = (result->elapsed_ns == 0) ? 0 : ((double)operations * 1000000000.0 / (double)result->elapsed_ns);
+
+        LogInfo("Concurrent %s: %zu threads, %" PRIu64 " operations in %.3f ms, %.0f ops/sec%s",
+            test_name, thread_count, operations, (double)result->elapsed_ns / 1000000.0, result->operations_per_second,
+            (failed_count == 0) ? "" : ", some threads failed");
+
+        run_result = ((started_count == thread_count) && (failed_count == 0)) ? 0 : MU_FAILURE;
+        free(threads);
+    }
+
+    return run_result;
+}
+
+size_t ctrs_concurrent_get_sweep_thread_counts(size_t processor_count, size_t* thread_counts, size_t max_thread_counts)
+{
+    size_t result = 0;
+
+    if ((processor_count == 0) || (thread_counts == NULL))
+    {
+        LogError("Invalid arguments size_t processor_count=%zu, size_t* thread_counts=%p, size_t max_thread_counts=%zu", processor_count, (void*)thread_counts, max_thread_counts);
+    }
+    else
+    {
+        size_t thread_count;
+        for (thread_count = 1; (thread_count < processor_count) && (result < max_thread_counts); thread_count *= 2)
+        {
+            thread_counts[result] = thread_count;
+            result++;
+        }
+        if (result < max_thread_counts)
+        {
+            thread_counts[result] = processor_count;
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static void write_sweep_csv(const char* test_name, const CTRS_CONCURRENT_RUN_RESULT* results, size_t result_count)
+{
+    const char* csv_file_name = getenv(CTRS_CONCURRENT_SWEEP_CSV_ENV);
+    FILE* csv_file = NULL;
+    size_t i;
+
+    if ((csv_file_name != NULL) && (csv_file_name[0] != '\0'))
+    {
+        csv_file = fopen(csv_file_name, "a");
+        if (csv_file == NULL)
+        {
+            LogError("failure in fopen(%s, \"a\"), the scaling table of %s is only logged", csv_file_name, test_name);
+        }
+        else if (ftell(csv_file) == 0)
+        {
+            (void)fprintf(csv_file, "test,threads,operations,elapsed_ns,ops_per_second,speedup,efficiency\n");
+        }
+        else
+        {
+            /*appending to the table of the tests before*/
+        }
+    }
+
+    LogInfo("Concurrent %s scaling:", test_name);
+    LogInfo("test,threads,operations,elapsed_ns,ops_per_second,speedup,efficiency");
+    for (i = 0; i < result_count; i++)
+    {
+        LogInfo("%s,%zu,%" PRIu64 ",%" PRIu64 ",%.0f,%.2f,%.2f",
+            test_name, results[i].thread_count, results[i].operations, results[i].elapsed_ns, results[i].operations_per_second, results[i].speedup, results[i].efficiency);
+        if (csv_file != NULL)
+        {
+            (void)fprintf(csv_file, "%s,%zu,%" PRIu64 ",%" PRIu64 ",%.0f,%.2f,%.2f\n",
+                test_name, results[i].thread_count, results[i].operations, results[i].elapsed_ns, results[i].operations_per_second, results[i].speedup, results[i].efficiency);
+        }
+    }
+
+    if (csv_file != NULL)
+    {
+        (void)fclose(csv_file);
+    }
+}
+
+int ctrs_concurrent_run(const char* test_name, size_t thread_count, CTRS_CONCURRENT_BODY body)
+{
+    int result;
+
+    if ((test_name == NULL) || (body == NULL))
+    {
+        LogError("Invalid arguments const char* test_name=%s, size_t thread_count=%zu, CTRS_CONCURRENT_BODY body=%p", MU_P_OR_NULL(test_name), thread_count, (void*)body);
+        result = MU_FAILURE;
+    }
+    else if (!is_sweep_requested())
+    {
+        CTRS_CONCURRENT_RUN_RESULT run_result;
+        result = run_once(test_name, (thread_count == 0) ? get_processor_count() : thread_count, body, &run_result);
+    }
+    else
+    {
+        size_t thread_counts[MAX_SWEEP_THREAD_COUNTS];
+        CTRS_CONCURRENT_RUN_RESULT results[MAX_SWEEP_THREAD_COUNTS];
+        size_t sweep_count = ctrs_concurrent_get_sweep_thread_counts(get_processor_count(), thread_counts, MAX_SWEEP_THREAD_COUNTS);
+        size_t i;
+
+        result = 0;
+        for (i = 0; i < sweep_count; i++)
+        {
+            if (run_once(test_name, thread_counts[i], body, &results[i]) != 0)
+            {
+                result = MU_FAILURE;
+                break;
+            }
+
+            /*the sweep starts at 1 thread*/
+            results[i].speedup = (results[0].operations_per_second == 0) ? 0 : (results[i].operations_per_second / results[0].operations_per_second);
+            results[i].efficiency = results[i].speedup / (double)results[i].thread_count;
+        }
+
+        write_sweep_csv(test_name, results, i);
+    }
+
+    return result;
+}
+
+size_t ctrs_concurrent_get_thread_index(void)
+{
+    return (g_current_thread == NULL) ? 0 : g_current_thread->thread_index;
+}
+
+size_t ctrs_concurrent_get_thread_count(void)
+{
+    return (g_current_thread == NULL) ? 0 : g_current_thread->thread_count;
+}
+
+void ctrs_concurrent_add_operations(uint64_t operations)
+{
+    if (g_current_thread == NULL)
+    {
+        LogError("CONCURRENT_ADD_OPERATIONS(%" PRIu64 ") outside of the body of a TEST_FUNCTION_CONCURRENT", operations);
+    }
+    else
+    {
+        g_current_thread->operations += operations;
+    }
+}
+
+void ctrs_concurrent_fail(const char* file, int line, const char* assertion, const char* format, ...)
+{
+    CONCURRENT_THREAD* thread = g_current_thread;
+    char local_failure[CTRS_CONCURRENT_FAILURE_SIZE];
+    char* failure = (thread == NULL) ? local_failure : thread->failure;
+    int length;
+
+    /*"file:line: assertion failed: message", the message is cut when it does not fit*/
+    length = snprintf(failure, CTRS_CONCURRENT_FAILURE_SIZE, "%s:%d: %s failed%s", file, line, assertion, (format[0] == '\0') ? "" : ": ");
+    if ((length > 0) && ((size_t)length < CTRS_CONCURRENT_FAILURE_SIZE))
+    {
+        va_list args;
+        va_start(args, format);
+        (void)vsnprintf(failure + length, CTRS_CONCURRENT_FAILURE_SIZE - (size_t)length, format, args);
+        va_end(args);
+    }
+
+    if (thread == NULL)
+    {
+        /*the macro fails the test the way of the other assertions*/
+        LogError("%s (outside of the body of a TEST_FUNCTION_CONCURRENT)", failure);
+    }
+    else
+    {
+        thread->failed = true;
+        longjmp(thread->failure_jump, 1);
+    }
+}
@@ -0,0 +1,1127 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctest.h"
+
+#include "ctrs_watchdog.h"
+
+#include "ctrs_data_table.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(CTRS_DATA_TABLE_SOURCE, CTRS_DATA_TABLE_SOURCE_VALUES)
+
+#define CTRS_DATA_TABLE_NAME_COLUMN "name"
+
+typedef struct CTRS_DATA_TABLE_LOADED_TAG
+{
+    char* content; /*the whole file plus a '\0', the CSV fields are unquoted in place and point into it*/
+    size_t content_size;
+    const char** csv_fields; /*the header fields, then the fields of every row*/
+    CTRS_DATA_TABLE_CSV_ROW* csv_rows;
+    char* row_names_buffer;
+    const char** row_names; /*row_count of them, pointing into row_names_buffer*/
+} CTRS_DATA_TABLE_LOADED;
+
+/*the table tests of the suite, registered before main*/
+static CTRS_DATA_TABLE* g_registered_tables;
+
+/*the row the runner wants the next run of its table to run, tests run on one thread so this is per process*/
+static const CTRS_DATA_TABLE* g_selected_table;
+static size_t g_selected_row;
+
+void ctrs_data_table_register(CTRS_DATA_TABLE* table)
+{
+    if (table == NULL)
+    {
+        LogError("Invalid arguments CTRS_DATA_TABLE* table=%p", (void*)table);
+    }
+    else
+    {
+        table->next_registered = g_registered_tables;
+        g_registered_tables = table;
+    }
+}
+
+CTRS_DATA_TABLE* ctrs_data_table_find(const char* test_name)
+{
+    CTRS_DATA_TABLE* result;
+
+    if (test_name == NULL)
+    {
+        LogError("Invalid arguments const char* test_name=%s", MU_P_OR_NULL(test_name));
+        result = NULL;
+    }
+    else
+    {
+        for (result = g_registered_tables; result != NULL; result = result->next_registered)
+        {
+            if (strcmp(result->test_name, test_name) == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool ctrs_data_table_any_registered(void)
+{
+    return (g_registered_tables != NULL);
+}
+
+static bool is_absolute_path(const char* path)
+{
+    return (path[0] == '/') || (path[0] == '\\') || ((path[0] != '\0') && (path[1] == ':'));
+}
+
+static int read_file(const char* file_name, CTRS_DATA_TABLE_LOADED* loaded)
+{
+    int result;
+    char path[1024];
+    const char* data_dir = getenv(CTRS_DATA_DIR_ENV);
+    int written = ((data_dir != NULL) && (data_dir[0] != '\0') && !is_absolute_path(file_name))
+        ? snprintf(path, sizeof(path), "%s/%s", data_dir, file_name)
+        : snprintf(path, sizeof(path), "%s", file_name);
+
+    if ((written < 0) || ((size_t)written >= sizeof(path)))
+    {
+        LogError("path of data file %s is too long", file_name);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            LogError("failure in fopen(%s, \"rb\"), is it in DATA_FILES of build_test_artifacts?", path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            long size;
+
+            if (
+                (fseek(file, 0, SEEK_END) != 0) ||
+                ((size = ftell(file)) < 0) ||
+                (fseek(file, 0, SEEK_SET) != 0)
+                )
+            {
+                LogError("failure getting the size of %s", path);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                loaded->content_size = (size_t)size;
+                loaded->content = malloc(loaded->content_size + 1);
+                if (loaded->content == NULL)
+                {
+                    LogError("failure in malloc(%zu + 1)", loaded->content_size);
+                    result = MU_FAILURE;
+                }
+                else if (fread(loaded->content, 1, loaded->content_size, file) != loaded->content_size)
+                {
+                    LogError("failure reading %zu bytes from %s", loaded->content_size, path);
+                    free(loaded->content);
+                    loaded->content = NULL;
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    loaded->content[loaded->content_size] = '\0';
+                    result = 0;
+                }
+            }
+
+            (void)fclose(file);
+        }
+    }
+
+    return result;
+}
+
+static int append_field(const char*** fields, size_t* field_count, size_t* field_capacity, const char* field)
+{
+    int result;
+
+    if (*field_count == *field_capacity)
+    {
+        size_t new_capacity = (*field_capacity == 0) ? 64 : (*field_capacity * 2);
+        const char** new_fields = realloc((void*)*fields, new_capacity * sizeof(const char*));
+        if (new_fields == NULL)
+        {
+            LogError("failure in realloc(%p, %zu * sizeof(const char*))", (void*)*fields, new_capacity);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            *fields = new_fields;
+            *field_capacity = new_capacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        (*fields)[*field_count] = field;
+        (*field_count)++;
+    }
+
+    return result;
+}
+
+/*splits the content in fields in place (a field is never longer than its text in the file), every line must have the fields of the header line*/
+static int parse_csv(CTRS_DATA_TABLE* table, CTRS_DATA_TABLE_LOADED* loaded)
+{
+    int result = 0;
+    char* read = loaded->content;
+    char* end = loaded->content + loaded->content_size;
+    size_t line_number = 0;
+    size_t column_count = 0;
+    size_t field_count = 0;
+    size_t field_capacity = 0;
+    size_t row_count = 0;
+
+    loaded->csv_fields = NULL;
+
+    while ((result == 0) && (read < end))
+    {
+        line_number++;
+
+        if ((*read == '\r') || (*read == '\n') || (*read == '#'))
+        {
+            /*blank line or comment*/
+            while ((read < end) && (*read != '\n'))
+            {
+                read++;
+            }
+            if (read < end)
+            {
+                read++;
+            }
+        }
+        else
+        {
+            size_t line_field_count = 0;
+            bool end_of_line = false;
+
+            while ((result == 0) && !end_of_line)
+            {
+                char* field = read;
+                char* write = read;
+                char delimiter;
+
+                if ((read < end) && (*read == '"'))
+                {
+                    bool closed = false;
+                    read++;
+                    while ((read < end) && !closed)
+                    {
+                        if (*read != '"')
+                        {
+                            *write++ = *read++;
+                        }
+                        else if (((read + 1) < end) && (read[1] == '"'))
+                        {
+                            *write++ = '"';
+                            read += 2;
+                        }
+                        else
+                        {
+                            read++;
+                            closed = true;
+                        }
+                    }
+
+                    if (!closed)
+                    {
+                        LogError("%s:%zu: unterminated quoted field", table->file_name, line_number);
+                        result = MU_FAILURE;
+                        break;
+                    }
+                    else if ((read < end) && (*read != ',') && (*read != '\r') && (*read != '\n'))
+                    {
+                        LogError("%s:%zu: unexpected character after a quoted field", table->file_name, line_number);
+                        result = MU_FAILURE;
+                        break;
+                    }
+                    else
+                    {
+                        /*the field ends at the delimiter*/
+                    }
+                }
+                else
+                {
+                    while ((read < end) && (*read != ',') && (*read != '\r') && (*read != '\n'))
+                    {
+                        *write++ = *read++;
+                    }
+                }
+
+                /*the delimiter is read before the terminating '\0' is written, which can be over it*/
+                delimiter = (read < end) ? *read : '\n';
+                *write = '\0';
+
+                if (append_field(&loaded->csv_fields, &field_count, &field_capacity, field) != 0)
+                {
+                    LogError("failure in append_field");
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    line_field_count++;
+
+                    if (delimiter == ',')
+                    {
+                        read++;
+                    }
+                    else
+                    {
+                        /*the '\0' may be over the '\r' (or the '\n'), the delimiter says what it was*/
+                        end_of_line = true;
+                        if (read < end)
+                        {
+                            read++;
+                            if ((delimiter == '\r') && (read < end) && (*read == '\n'))
+                            {
+                                read++;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (result == 0)
+            {
+                if (column_count == 0)
+                {
+                    column_count = line_field_count;
+                }
+                else if (line_field_count != column_count)
+                {
+                    LogError("%s:%zu: %zu fields, the header line has %zu", table->file_name, line_number, line_field_count, column_count);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    row_count++;
+                }
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        if (column_count == 0)
+        {
+            LogError("%s has no header line", table->file_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            loaded->csv_rows = malloc((row_count + 1) * sizeof(CTRS_DATA_TABLE_CSV_ROW));
+            if (loaded->csv_rows == NULL)
+            {
+                LogError("failure in malloc((%zu + 1) * sizeof(CTRS_DATA_TABLE_CSV_ROW))", row_count);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                size_t i;
+                for (i = 0; i < row_count; i++)
+                {
+                    loaded->csv_rows[i].field_count = column_count;
+                    loaded->csv_rows[i].fields = &loaded->csv_fields[(i + 1) * column_count];
+                    loaded->csv_rows[i].column_names = &loaded->csv_fields[0];
+                }
+                table->row_count = row_count;
+                table->rows = loaded->csv_rows;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        free((void*)loaded->csv_fields);
+        loaded->csv_fields = NULL;
+    }
+
+    return result;
+}
+
+/*the name the data gives the row (CASE suffix, "name" column), NULL to name it by its index*/
+static const char* get_given_row_name(const CTRS_DATA_TABLE* table, const CTRS_DATA_TABLE_LOADED* loaded, size_t row_index)
+{
+    const char* result;
+
+    if ((table->source == CTRS_DATA_TABLE_SOURCE_CSV_FILE) && (loaded->csv_rows != NULL))
+    {
+        result = ctrs_data_table_csv_get(&loaded->csv_rows[row_index], CTRS_DATA_TABLE_NAME_COLUMN);
+    }
+    else if ((table->source == CTRS_DATA_TABLE_SOURCE_ARRAY) && (table->row_suffixes != NULL))
+    {
+        result = table->row_suffixes[row_index];
+    }
+    else
+    {
+        result = NULL;
+    }
+
+    /*a row with an empty name is named by its index*/
+    return ((result != NULL) && (result[0] != '\0')) ? result : NULL;
+}
+
+/*the row name becomes part of a test name, which --filter, the reports and DISCOVER_TESTS (^[A-Za-z_][A-Za-z0-9_]*$) take as an identifier*/
+static bool is_valid_row_name(const char* row_name)
+{
+    size_t i;
+
+    for (i = 0; row_name[i] != '\0'; i++)
+    {
+        char c = row_name[i];
+        if (!(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_')))
+        {
+            break;
+        }
+    }
+
+    return (row_name[i] == '\0');
+}
+
+static int compare_row_names(const void* left, const void* right)
+{
+    return strcmp(*(const char* const*)left, *(const char* const*)right);
+}
+
+/*two rows with the same test name could not be told apart by a filter or in the results*/
+static int check_row_names_are_unique(const CTRS_DATA_TABLE* table, const CTRS_DATA_TABLE_LOADED* loaded)
+{
+    int result;
+    const char** sorted_names = malloc((table->row_count + 1) * sizeof(const char*));
+
+    if (sorted_names == NULL)
+    {
+        LogError("failure in malloc((%zu + 1) * sizeof(const char*))", table->row_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        (void)memcpy((void*)sorted_names, (const void*)loaded->row_names, table->row_count * sizeof(const char*));
+        qsort((void*)sorted_names, table->row_count, sizeof(const char*), compare_row_names);
+
+        result = 0;
+        for (i = 1; i < table->row_count; i++)
+        {
+            if (strcmp(sorted_names[i - 1], sorted_names[i]) == 0)
+            {
+                LogError("%s: more than one row is named %s, give every row its own name", table->test_name, sorted_names[i]);
+                result = MU_FAILURE;
+                break;
+            }
+        }
+
+        free((void*)sorted_names);
+    }
+
+    return result;
+}
+
+static int name_rows(CTRS_DATA_TABLE* table, CTRS_DATA_TABLE_LOADED* loaded)
+{
+    int result;
+    size_t i;
+    size_t buffer_size = 0;
+    size_t test_name_length = strlen(table->test_name);
+
+    /*<test>_<name or index>\0 for every row, the index takes at most 20 digits*/
+    for (i = 0; i < table->row_count; i++)
+    {
+        const char* row_name = get_given_row_name(table, loaded, i);
+        if ((row_name != NULL) && !is_valid_row_name(row_name))
+        {
+            break;
+        }
+        buffer_size += test_name_length + 1 + ((row_name != NULL) ? strlen(row_name) : 20) + 1;
+    }
+
+    if (i < table->row_count)
+    {
+        LogError("%s: row %zu is named \"%s\", a row name can only have letters, digits and '_'", table->test_name, i, get_given_row_name(table, loaded, i));
+        result = MU_FAILURE;
+    }
+    else if (
+        ((loaded->row_names_buffer = malloc(buffer_size + 1)) == NULL) ||
+        ((loaded->row_names = malloc((table->row_count + 1) * sizeof(const char*))) == NULL)
+        )
+    {
+        LogError("failure allocating the names of %zu rows (%zu bytes)", table->row_count, buffer_size);
+        free(loaded->row_names_buffer);
+        loaded->row_names_buffer = NULL;
+        free((void*)loaded->row_names);
+        loaded->row_names = NULL;
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t offset = 0;
+
+        for (i = 0; i < table->row_count; i++)
+        {
+            const char* row_name = get_given_row_name(table, loaded, i);
+            int written = (row_name != NULL)
+                ? snprintf(loaded->row_names_buffer + offset, buffer_size + 1 - offset, "%s_%s", table->test_name, row_name)
+                : snprintf(loaded->row_names_buffer + offset, buffer_size + 1 - offset, "%s_%zu", table->test_name, i);
+
+            loaded->row_names[i] = loaded->row_names_buffer + offset;
+            offset += (size_t)written + 1;
+        }
+
+        /*a given name can also be the index of another row*/
+        result = check_row_names_are_unique(table, loaded);
+    }
+
+    return result;
+}
+
+void ctrs_data_table_unload(CTRS_DATA_TABLE* table)
+{
+    if (table == NULL)
+    {
+        LogError("Invalid arguments CTRS_DATA_TABLE* table=%p", (void*)table);
+    }
+    else if (table->loaded != NULL)
+    {
+        CTRS_DATA_TABLE_LOADED* loaded = table->loaded;
+
+        free(loaded->row_names_buffer);
+        free((void*)loaded->row_names);
+        free(loaded->csv_rows);
+        free((void*)loaded->csv_fields);
+        free(loaded->content);
+        free(loaded);
+        table->loaded = NULL;
+
+        if (table->source != CTRS_DATA_TABLE_SOURCE_ARRAY)
+        {
+            table->rows = NULL;
+            table->row_count = 0;
+        }
+    }
+}
+
+int ctrs_data_table_load(CTRS_DATA_TABLE* table)
+{
+    int result;
+
+    if (
+        (table == NULL) ||
+        (table->run_row == NULL) ||
+        (table->row_size == 0) ||
+        ((table->source != CTRS_DATA_TABLE_SOURCE_ARRAY) && (table->file_name == NULL))
+        )
+    {
+        LogError("Invalid arguments CTRS_DATA_TABLE* table=%p", (void*)table);
+        result = MU_FAILURE;
+    }
+    else if (table->loaded != NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        CTRS_DATA_TABLE_LOADED* loaded = calloc(1, sizeof(CTRS_DATA_TABLE_LOADED));
+        if (loaded == NULL)
+        {
+            LogError("failure in calloc(1, sizeof(CTRS_DATA_TABLE_LOADED))");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            table->loaded = loaded;
+
+            switch (table->source)
+            {
+                default:
+                    LogError("unknown CTRS_DATA_TABLE_SOURCE %" PRI_MU_ENUM " of %s", MU_ENUM_VALUE(CTRS_DATA_TABLE_SOURCE, table->source), table->test_name);
+                    result = MU_FAILURE;
+                    break;
+                case CTRS_DATA_TABLE_SOURCE_ARRAY:
+                    result = 0;
+                    break;
+                case CTRS_DATA_TABLE_SOURCE_CSV_FILE:
+                    if (read_file(table->file_name, loaded) != 0)
+                    {
+                        LogError("failure in read_file(%s)", table->file_name);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        result = parse_csv(table, loaded);
+                    }
+                    break;
+                case CTRS_DATA_TABLE_SOURCE_BINARY_FILE:
+                    if (read_file(table->file_name, loaded) != 0)
+                    {
+                        LogError("failure in read_file(%s)", table->file_name);
+                        result = MU_FAILURE;
+                    }
+                    else if ((loaded->content_size % table->row_size) != 0)
+                    {
+                        LogError("%s has %zu bytes, which is not a whole number of %zu byte rows", table->file_name, loaded->content_size, table->row_size);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        table->rows = loaded->content;
+                        table->row_count = loaded->content_size / table->row_size;
+                        result = 0;
+                    }
+                    break;
+            }
+
+            if (result == 0)
+            {
+                result = name_rows(table, loaded);
+            }
+
+            if (result != 0)
+            {
+                LogError("failure loading the rows of %s", table->test_name);
+                ctrs_data_table_unload(table);
+            }
+        }
+    }
+
+    return result;
+}
+
+void ctrs_data_table_unload_all(void)
+{
+    CTRS_DATA_TABLE* table;
+
+    for (table = g_registered_tables; table != NULL; table = table->next_registered)
+    {
+        ctrs_data_table_unload(table);
+    }
+}
+
+const char* ctrs_data_table_get_row_name(const CTRS_DATA_TABLE* table, size_t row_index)
+{
+    const char* result;
+
+    if (
+        (table == NULL) ||
+        (table->loaded == NULL) ||
+        (row_index >= table->row_count)
+        )
+    {
+        LogError("Invalid arguments const CTRS_DATA_TABLE* table=%p, size_t row_index=%zu", (void*)table, row_index);
+        result = NULL;
+    }
+    else
+    {
+        result = ((const CTRS_DATA_TABLE_LOADED*)table->loaded)->row_names[row_index];
+    }
+
+    return result;
+}
+
+void ctrs_data_table_select_row(const CTRS_DATA_TABLE* table, size_t row_index)
+{
+    g_selected_table = table;
+    g_selected_row = row_index;
+}
+
+/*runs one row and turns a failed ctest assertion (which longjmps to g_ExceptionJump) into a non-zero return, so that the next rows still run*/
+static int run_row(const CTRS_DATA_TABLE* table, size_t row_index)
+{
+    int result;
+    jmp_buf saved_exception_jump;
+    const void* row = (table->source == CTRS_DATA_TABLE_SOURCE_CSV_FILE)
+        ? (const void*)&((const CTRS_DATA_TABLE_CSV_ROW*)table->rows)[row_index]
+        : (const void*)((const unsigned char*)table->rows + (row_index * table->row_size));
+
+    (void)memcpy(saved_exception_jump, g_ExceptionJump, sizeof(jmp_buf));
+    if (setjmp(g_ExceptionJump) == 0)
+    {
+        table->run_row(row);
+        result = 0;
+    }
+    else
+    {
+        LogError("Row %s failed", ctrs_data_table_get_row_name(table, row_index));
+        result = MU_FAILURE;
+    }
+    (void)memcpy(g_ExceptionJump, saved_exception_jump, sizeof(jmp_buf));
+
+    return result;
+}
+
+static size_t run_rows_serially(const CTRS_DATA_TABLE* table)
+{
+    size_t i;
+    size_t failed_count = 0;
+
+    for (i = 0; i < table->row_count; i++)
+    {
+        if (run_row(table, i) != 0)
+        {
+            failed_count++;
+        }
+    }
+
+    return failed_count;
+}
+
+#ifndef _WIN32
+/*what a worker reports about one row: the result and where its output is in the output file of the worker*/
+typedef struct CTRS_DATA_TABLE_ROW_RECORD_TAG
+{
+    size_t row_index;
+    int result;
+    off_t output_start;
+    off_t output_end;
+} CTRS_DATA_TABLE_ROW_RECORD;
+
+typedef struct CTRS_DATA_TABLE_WORKER_TAG
+{
+    pid_t pid;
+    FILE* output;
+    bool wait_failed; /*its end could not be collected, its rows are failed*/
+} CTRS_DATA_TABLE_WORKER;
+
+static size_t get_concurrent_jobs(size_t row_count)
+{
+    size_t result;
+    const char* jobs_text = getenv(CTRS_CONCURRENT_JOBS_ENV);
+    char* end = NULL;
+    unsigned long jobs = ((jobs_text != NULL) && (jobs_text[0] != '\0')) ? strtoul(jobs_text, &end, 10) : 0;
+
+    if ((end != NULL) && (*end == '\0') && (jobs > 0))
+    {
+        result = (size_t)jobs;
+    }
+    else
+    {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+        if (end != NULL)
+        {
+            LogWarning("ignoring %s=%s, it is not a positive number", CTRS_CONCURRENT_JOBS_ENV, jobs_text);
+        }
+        result = (processor_count > 0) ? (size_t)processor_count : 1;
+    }
+
+    return (result < row_count) ? result : row_count;
+}
+
+static void write_row_record(int pipe_write_fd, const CTRS_DATA_TABLE_ROW_RECORD* record)
+{
+    const unsigned char* bytes = (const unsigned char*)record;
+    size_t written = 0;
+
+    /*records are smaller than PIPE_BUF so the write is atomic with respect to the other workers*/
+    while (written < sizeof(CTRS_DATA_TABLE_ROW_RECORD))
+    {
+        ssize_t write_result = write(pipe_write_fd, bytes + written, sizeof(CTRS_DATA_TABLE_ROW_RECORD) - written);
+        if (write_result < 0)
+        {
+            if (errno != EINTR)
+            {
+                LogError("failure in write(%d, ...), errno=%d", pipe_write_fd, errno);
+                break;
+            }
+        }
+        else
+        {
+            written += (size_t)write_result;
+        }
+    }
+}
+
+/*runs every worker_count-th row starting at worker_index, with stdout and stderr going to output*/
+static void run_worker(const CTRS_DATA_TABLE* table, size_t worker_index, size_t worker_count, FILE* output, int pipe_write_fd)
+{
+    size_t row_index;
+
+    if (
+        (dup2(fileno(output), STDOUT_FILENO) < 0) ||
+        (dup2(fileno(output), STDERR_FILENO) < 0)
+        )
+    {
+        LogError("failure redirecting the output of worker %d, errno=%d", (int)getpid(), errno);
+    }
+    else
+    {
+        /*stdout is now a file, line buffering keeps the output of a row that crashes the worker*/
+        (void)setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+    }
+
+    for (row_index = worker_index; row_index < table->row_count; row_index += worker_count)
+    {
+        CTRS_DATA_TABLE_ROW_RECORD record;
+
+        record.row_index = row_index;
+        (void)fflush(stdout);
+        (void)fflush(stderr);
+        record.output_start = lseek(fileno(output), 0, SEEK_CUR);
+        record.result = run_row(table, row_index);
+        (void)fflush(stdout);
+        (void)fflush(stderr);
+        record.output_end = lseek(fileno(output), 0, SEEK_CUR);
+
+        write_row_record(pipe_write_fd, &record);
+    }
+}
+
+static void read_row_records(int pipe_read_fd, CTRS_DATA_TABLE_ROW_RECORD* records, size_t row_count)
+{
+    CTRS_DATA_TABLE_ROW_RECORD record;
+    size_t received = 0;
+
+    for (;;)
+    {
+        ssize_t read_result = read(pipe_read_fd, (unsigned char*)&record + received, sizeof(record) - received);
+        if (read_result < 0)
+        {
+            if (errno != EINTR)
+            {
+                LogError("failure in read(%d, ...), errno=%d", pipe_read_fd, errno);
+                break;
+            }
+        }
+        else if (read_result == 0)
+        {
+            /*all workers have closed their end of the pipe*/
+            break;
+        }
+        else
+        {
+            received += (size_t)read_result;
+            if (received == sizeof(record))
+            {
+                if (record.row_index < row_count)
+                {
+                    records[record.row_index] = record;
+                }
+                else
+                {
+                    LogError("record for unknown row %zu (row_count=%zu)", record.row_index, row_count);
+                }
+                received = 0;
+            }
+        }
+    }
+}
+
+static void replay_row_output(FILE* output, const CTRS_DATA_TABLE_ROW_RECORD* record)
+{
+    if (
+        (record->output_start >= 0) &&
+        (record->output_end > record->output_start) &&
+        (fseeko(output, record->output_start, SEEK_SET) == 0)
+        )
+    {
+        char buffer[4096];
+        off_t remaining = record->output_end - record->output_start;
+
+        while (remaining > 0)
+        {
+            size_t read_count = fread(buffer, 1, (remaining < (off_t)sizeof(buffer)) ? (size_t)remaining : sizeof(buffer), output);
+            if (read_count == 0)
+            {
+                break;
+            }
+            (void)fwrite(buffer, 1, read_count, stdout);
+            remaining -= (off_t)read_count;
+        }
+    }
+}
+
+/*the rows are spread round robin across worker_count forked workers, their outputs and results are replayed in the order of the rows*/
+static size_t run_rows_concurrently(const CTRS_DATA_TABLE* table, size_t worker_count)
+{
+    size_t failed_count = 0;
+    CTRS_DATA_TABLE_ROW_RECORD* records = malloc((table->row_count + 1) * sizeof(CTRS_DATA_TABLE_ROW_RECORD));
+    CTRS_DATA_TABLE_WORKER* workers = calloc(worker_count, sizeof(CTRS_DATA_TABLE_WORKER));
+    int pipe_fds[2];
+
+    if (
+        (records == NULL) ||
+        (workers == NULL)
+        )
+    {
+        LogError("failure allocating the workers of %s, running its %zu rows serially", table->test_name, table->row_count);
+        failed_count = run_rows_serially(table);
+    }
+    else if (pipe(pipe_fds) != 0)
+    {
+        LogError("failure in pipe, errno=%d, running the %zu rows of %s serially", errno, table->row_count, table->test_name);
+        failed_count = run_rows_serially(table);
+    }
+    else
+    {
+        size_t i;
+        size_t started_count;
+
+        for (i = 0; i < table->row_count; i++)
+        {
+            records[i].row_index = SIZE_MAX; /*not reported (yet)*/
+        }
+
+        LogInfo("Running %zu rows of %s in %zu worker processes", table->row_count, table->test_name, worker_count);
+
+        (void)fflush(stdout);
+        (void)fflush(stderr);
+
+        for (started_count = 0; started_count < worker_count; started_count++)
+        {
+            CTRS_DATA_TABLE_WORKER* worker = &workers[started_count];
+
+            worker->output = tmpfile();
+            if (worker->output == NULL)
+            {
+                LogError("failure in tmpfile for worker %zu, errno=%d", started_count, errno);
+                break;
+            }
+
+            worker->pid = fork();
+            if (worker->pid < 0)
+            {
+                LogError("failure in fork for worker %zu, errno=%d", started_count, errno);
+                (void)fclose(worker->output);
+                worker->output = NULL;
+                break;
+            }
+            else if (worker->pid == 0)
+            {
+                (void)close(pipe_fds[0]);
+                run_worker(table, started_count, worker_count, worker->output, pipe_fds[1]);
+                (void)close(pipe_fds[1]);
+                _exit(0);
+            }
+            else
+            {
+                /*killed with the test when it times out*/
+                ctrs_watchdog_add_test_process((int)worker->pid);
+            }
+        }
+
+        (void)close(pipe_fds[1]);
+
+        read_row_records(pipe_fds[0], records, table->row_count);
+
+        (void)close(pipe_fds[0]);
+
+        for (i = 0; i < started_count; i++)
+        {
+            int status = 0;
+            pid_t wait_result;
+            while (((wait_result = waitpid(workers[i].pid, &status, 0)) < 0) && (errno == EINTR))
+            {
+            }
+            ctrs_watchdog_remove_test_process((int)workers[i].pid);
+
+            if (wait_result < 0)
+            {
+                LogError("failure in waitpid for worker %zu (pid %d) of %s, errno=%d", i, (int)workers[i].pid, table->test_name, errno);
+                workers[i].wait_failed = true;
+            }
+            else if (WIFSIGNALED(status))
+            {
+                LogError("worker %zu (pid %d) of %s was terminated by signal %d", i, (int)workers[i].pid, table->test_name, WTERMSIG(status));
+            }
+        }
+
+        for (i = 0; i < table->row_count; i++)
+        {
+            size_t worker_index = i % worker_count;
+
+            if ((worker_index < started_count) && workers[worker_index].wait_failed)
+            {
+                if (records[i].row_index == i)
+                {
+                    replay_row_output(workers[worker_index].output, &records[i]);
+                }
+                LogError("Row %s failed, the end of its worker process could not be collected", ctrs_data_table_get_row_name(table, i));
+                failed_count++;
+            }
+            else if (records[i].row_index == i)
+            {
+                replay_row_output(workers[worker_index].output, &records[i]);
+                if (records[i].result != 0)
+                {
+                    failed_count++;
+                }
+            }
+            else if (worker_index >= started_count)
+            {
+                /*its worker could not be started*/
+                if (run_row(table, i) != 0)
+                {
+                    failed_count++;
+                }
+            }
+            else
+            {
+                LogError("Row %s did not complete (its worker process died)", ctrs_data_table_get_row_name(table, i));
+                failed_count++;
+            }
+        }
+        (void)fflush(stdout);
+
+        for (i = 0; i < started_count; i++)
+        {
+            (void)fclose(workers[i].output);
+        }
+    }
+
+    free(workers);
+    free(records);
+
+    return failed_count;
+}
+#endif
+
+static size_t run_all_rows(const CTRS_DATA_TABLE* table)
+{
+    size_t result;
+
+#ifdef _WIN32
+    /*no fork, the rows of a concurrent table run one after the other*/
+    result = run_rows_serially(table);
+#else
+    size_t worker_count = table->concurrent ? get_concurrent_jobs(table->row_count) : 1;
+    result = (worker_count > 1) ? run_rows_concurrently(table, worker_count) : run_rows_serially(table);
+#endif
+
+    return result;
+}
+
+int ctrs_data_table_run(CTRS_DATA_TABLE* table)
+{
+    int result;
+
+    if (table == NULL)
+    {
+        LogError("Invalid arguments CTRS_DATA_TABLE* table=%p", (void*)table);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        /*a table loaded by the runner stays loaded for the rest of the run, one loaded here is only needed by this run*/
+        bool loaded_here = (table->loaded == NULL);
+
+        if (ctrs_data_table_load(table) != 0)
+        {
+            LogError("failure in ctrs_data_table_load(%s)", table->test_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if (g_selected_table == table)
+            {
+                if (g_selected_row >= table->row_count)
+                {
+                    LogError("%s has no row %zu (it has %zu)", table->test_name, g_selected_row, table->row_count);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    result = run_row(table, g_selected_row);
+                }
+            }
+            else
+            {
+                size_t failed_count = run_all_rows(table);
+
+                if (failed_count == 0)
+                {
+                    LogInfo("%s: %zu rows passed", table->test_name, table->row_count);
+                    result = 0;
+                }
+                else
+                {
+                    LogError("%s: %zu of %zu rows failed", table->test_name, failed_count, table->row_count);
+                    result = MU_FAILURE;
+                }
+            }
+
+            if (loaded_here)
+            {
+                ctrs_data_table_unload(table);
+            }
+        }
+    }
+
+    return result;
+}
+
+void ctrs_data_table_run_case(const void* row)
+{
+    const CTRS_DATA_TABLE_CASE* test_case = (const CTRS_DATA_TABLE_CASE*)row;
+
+    if (
+        (test_case == NULL) ||
+        (test_case->run_case == NULL)
+        )
+    {
+        LogError("Invalid arguments const void* row=%p", row);
+        /*fails the row, run_row catches it*/
+        longjmp(g_ExceptionJump, 1);
+    }
+    else
+    {
+        test_case->run_case();
+    }
+}
+
+const char* ctrs_data_table_csv_get(const CTRS_DATA_TABLE_CSV_ROW* row, const char* column_name)
+{
+    const char* result = NULL;
+
+    if (
+        (row == NULL) ||
+        (column_name == NULL)
+        )
+    {
+        LogError("Invalid arguments const CTRS_DATA_TABLE_CSV_ROW* row=%p, const char* column_name=%s", (void*)row, MU_P_OR_NULL(column_name));
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < row->field_count; i++)
+        {
+            if (strcmp(row->column_names[i], column_name) == 0)
+            {
+                result = row->fields[i];
+                break;
+            }
+        }
+    }
+
+    return result;
+}
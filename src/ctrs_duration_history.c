@@ -0,0 +1,771 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "testmutex.h"
+
+#include "ctrs_duration_history.h"
+
+#define DURATION_HISTORY_HEADER "# testrunnerswitcher duration history: <duration_ms> <test name>"
+#define DURATION_HISTORY_LOCK_PREFIX "duration_history_"
+#define DURATION_HISTORY_MAX_LINE 4096
+#define DURATION_HISTORY_MAX_PATH 1024
+
+typedef struct DURATION_ENTRY_TAG
+{
+    char* test_name;
+    double duration_ms;
+    bool recorded; /*set by ctrs_duration_history_record in this run (while merging: read from a shard file)*/
+    size_t sequence; /*position before sort_entries sorts, for a name that is there more than once the last one wins*/
+} DURATION_ENTRY;
+
+typedef struct CTRS_DURATION_HISTORY_TAG
+{
+    char* path;
+    size_t shard_index;
+    size_t shard_count;
+    TEST_MUTEX_HANDLE lock;
+    unsigned long long generation; /*goes up with every write of the history, the shard files of an older one are not merged*/
+    DURATION_ENTRY* entries; /*[0, sorted_count) sorted by name, then the tests recorded in this run that were not in the history*/
+    size_t sorted_count;
+    size_t count;
+    size_t capacity;
+} CTRS_DURATION_HISTORY;
+
+static int compare_entries(const void* left, const void* right)
+{
+    return strcmp(((const DURATION_ENTRY*)left)->test_name, ((const DURATION_ENTRY*)right)->test_name);
+}
+
+/*qsort is not stable, the same names stay in the order they were appended*/
+static int compare_entries_in_sequence(const void* left, const void* right)
+{
+    int result = compare_entries(left, right);
+    if (result == 0)
+    {
+        size_t left_sequence = ((const DURATION_ENTRY*)left)->sequence;
+        size_t right_sequence = ((const DURATION_ENTRY*)right)->sequence;
+        result = (left_sequence < right_sequence) ? -1 : ((left_sequence > right_sequence) ? 1 : 0);
+    }
+    return result;
+}
+
+static void free_entries(DURATION_ENTRY* entries, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        free(entries[i].test_name);
+    }
+    free(entries);
+}
+
+static DURATION_ENTRY* find_entry(CTRS_DURATION_HISTORY* history, const char* test_name)
+{
+    DURATION_ENTRY key;
+    DURATION_ENTRY* result;
+
+    key.test_name = (char*)test_name;
+    result = (history->sorted_count == 0) ? NULL : bsearch(&key, history->entries, history->sorted_count, sizeof(DURATION_ENTRY), compare_entries);
+    if (result == NULL)
+    {
+        /*the tests recorded in this run are few next to the history, they are not kept sorted*/
+        size_t i;
+        for (i = history->sorted_count; i < history->count; i++)
+        {
+            if (strcmp(history->entries[i].test_name, test_name) == 0)
+            {
+                result = &history->entries[i];
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int append_entry(CTRS_DURATION_HISTORY* history, const char* test_name, double duration_ms, bool recorded)
+{
+    int result;
+
+    if (history->count == history->capacity)
+    {
+        size_t new_capacity = (history->capacity == 0) ? 64 : (history->capacity * 2);
+        DURATION_ENTRY* new_entries = realloc(history->entries, new_capacity * sizeof(DURATION_ENTRY));
+        if (new_entries == NULL)
+        {
+            LogError("failure in realloc(%zu * sizeof(DURATION_ENTRY))", new_capacity);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            history->entries = new_entries;
+            history->capacity = new_capacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        size_t name_length = strlen(test_name);
+        DURATION_ENTRY* entry = &history->entries[history->count];
+
+        entry->test_name = malloc(name_length + 1);
+        if (entry->test_name == NULL)
+        {
+            LogError("failure in malloc(%zu)", name_length + 1);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)memcpy(entry->test_name, test_name, name_length + 1);
+            entry->duration_ms = duration_ms;
+            entry->recorded = recorded;
+            history->count++;
+        }
+    }
+
+    return result;
+}
+
+/*sorts all the entries by name, for a name appended again the last duration wins*/
+static void sort_entries(CTRS_DURATION_HISTORY* history)
+{
+    size_t i;
+    size_t kept = 0;
+
+    for (i = history->sorted_count; i < history->count; i++)
+    {
+        DURATION_ENTRY key;
+        DURATION_ENTRY* existing;
+
+        key.test_name = history->entries[i].test_name;
+        existing = (history->sorted_count == 0) ? NULL : bsearch(&key, history->entries, history->sorted_count, sizeof(DURATION_ENTRY), compare_entries);
+        if (existing != NULL)
+        {
+            existing->duration_ms = history->entries[i].duration_ms;
+            existing->recorded = existing->recorded || history->entries[i].recorded;
+            free(history->entries[i].test_name);
+        }
+        else
+        {
+            history->entries[history->sorted_count + kept] = history->entries[i];
+            kept++;
+        }
+    }
+
+    history->count = history->sorted_count + kept;
+    for (i = 0; i < history->count; i++)
+    {
+        history->entries[i].sequence = i;
+    }
+    if (history->count > 1)
+    {
+        qsort(history->entries, history->count, sizeof(DURATION_ENTRY), compare_entries_in_sequence);
+    }
+
+    /*a name can still be twice among the appended ones (an edited file), the one appended last follows the others*/
+    kept = 0;
+    for (i = 0; i < history->count; i++)
+    {
+        if ((kept > 0) && (strcmp(history->entries[kept - 1].test_name, history->entries[i].test_name) == 0))
+        {
+            history->entries[kept - 1].duration_ms = history->entries[i].duration_ms;
+            history->entries[kept - 1].recorded = history->entries[kept - 1].recorded || history->entries[i].recorded;
+            free(history->entries[i].test_name);
+        }
+        else
+        {
+            history->entries[kept] = history->entries[i];
+            kept++;
+        }
+    }
+
+    history->count = kept;
+    history->sorted_count = kept;
+}
+
+/*
+reads the entries of path after the ones already there (marked recorded with from_shard), returns 0 also when the file does not exist
+(*found is then false). *all_tests tells whether the shard that wrote the file ran all its tests.
+*/
+static int read_file(CTRS_DURATION_HISTORY* history, const char* path, bool from_shard, bool* found, unsigned long long* generation, bool* all_tests)
+{
+    int result;
+    FILE* file = fopen(path, "r");
+
+    *generation = 0;
+    *all_tests = false;
+
+    if (file == NULL)
+    {
+        /*no history yet*/
+        *found = false;
+        result = 0;
+    }
+    else
+    {
+        char line[DURATION_HISTORY_MAX_LINE];
+
+        *found = true;
+        result = 0;
+        while ((result == 0) && (fgets(line, sizeof(line), file) != NULL))
+        {
+            double duration_ms;
+            int name_start = 0;
+
+            line[strcspn(line, "\r\n")] = '\0';
+
+            if ((line[0] == '#') || (line[0] == '\0'))
+            {
+                /*a comment*/
+            }
+            else if (sscanf(line, "generation %llu", generation) == 1)
+            {
+                /*the generation of the history the file was written from*/
+            }
+            else if (strcmp(line, "all_tests") == 0)
+            {
+                /*the shard ran all its tests, the tests in none of the shard files are gone from the suite*/
+                *all_tests = true;
+            }
+            else if ((sscanf(line, "%lf %n", &duration_ms, &name_start) != 1) || (name_start == 0) || (line[name_start] == '\0') || !(duration_ms >= 0))
+            {
+                LogWarning("%s: ignoring the line \"%s\"", path, line);
+            }
+            else
+            {
+                result = append_entry(history, line + name_start, duration_ms, from_shard);
+            }
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+/*
+writes the entries (only the recorded ones of a shard that ran all_tests or not, with only_recorded) to path through a temporary file, so a
+reader never sees half a file
+*/
+static int write_file(const CTRS_DURATION_HISTORY* history, const char* path, unsigned long long generation, bool only_recorded, bool all_tests)
+{
+    int result;
+    char temporary_path[DURATION_HISTORY_MAX_PATH + 8];
+    FILE* file;
+
+    (void)snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path);
+    file = fopen(temporary_path, "w");
+    if (file == NULL)
+    {
+        LogError("failure in fopen(%s, \"w\"), errno=%d", temporary_path, errno);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        bool write_failed;
+
+        (void)fprintf(file, DURATION_HISTORY_HEADER "\n");
+        (void)fprintf(file, "generation %llu\n", generation);
+        if (only_recorded && all_tests)
+        {
+            (void)fprintf(file, "all_tests\n");
+        }
+        for (i = 0; i < history->count; i++)
+        {
+            if (!only_recorded || history->entries[i].recorded)
+            {
+                (void)fprintf(file, "%.3f %s\n", history->entries[i].duration_ms, history->entries[i].test_name);
+            }
+        }
+
+        write_failed = (ferror(file) != 0);
+        if ((fclose(file) != 0) || write_failed)
+        {
+            LogError("failure writing %s", temporary_path);
+            (void)remove(temporary_path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+#ifdef _WIN32
+            /*rename does not replace an existing file on Windows, the lock keeps the other processes out meanwhile*/
+            (void)remove(path);
+#endif
+            if (rename(temporary_path, path) != 0)
+            {
+                LogError("failure in rename(%s, %s), errno=%d", temporary_path, path, errno);
+                (void)remove(temporary_path);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*drops the entries that were not recorded, the tests that are gone from the suite*/
+static void prune_entries(CTRS_DURATION_HISTORY* history)
+{
+    size_t i;
+    size_t kept = 0;
+
+    for (i = 0; i < history->count; i++)
+    {
+        if (history->entries[i].recorded)
+        {
+            history->entries[kept] = history->entries[i];
+            kept++;
+        }
+        else
+        {
+            free(history->entries[i].test_name);
+        }
+    }
+    history->count = kept;
+    history->sorted_count = kept;
+}
+
+static void get_shard_path(const CTRS_DURATION_HISTORY* history, size_t shard_index, char* shard_path, size_t shard_path_size)
+{
+    (void)snprintf(shard_path, shard_path_size, "%s.shard_%zu_of_%zu", history->path, shard_index, history->shard_count);
+}
+
+/*when every shard of the current generation wrote its file, their durations go into the history, which moves to the next generation*/
+static int merge_shard_files(CTRS_DURATION_HISTORY* history)
+{
+    int result = 0;
+    size_t i;
+    bool complete = true;
+    bool all_tests = true;
+    char shard_path[DURATION_HISTORY_MAX_PATH + 64];
+
+    for (i = 0; (i < history->shard_count) && complete && (result == 0); i++)
+    {
+        unsigned long long shard_generation;
+        bool found;
+        bool shard_ran_all_tests;
+
+        get_shard_path(history, i, shard_path, sizeof(shard_path));
+        result = read_file(history, shard_path, true, &found, &shard_generation, &shard_ran_all_tests);
+        all_tests = all_tests && shard_ran_all_tests;
+        if ((result == 0) && (!found || (shard_generation != history->generation)))
+        {
+            /*a shard of this generation did not write its file yet (or it is from an older generation)*/
+            complete = false;
+        }
+    }
+
+    if (result != 0)
+    {
+        LogError("failure reading the shard files of %s", history->path);
+    }
+    else if (!complete)
+    {
+        /*the durations read from the shard files are dropped with the entries appended after the history*/
+        size_t j;
+        for (j = history->sorted_count; j < history->count; j++)
+        {
+            free(history->entries[j].test_name);
+        }
+        history->count = history->sorted_count;
+    }
+    else
+    {
+        sort_entries(history);
+
+        /*when all the shards ran all their tests, the tests in none of their files are gone from the suite, as for a save with prune*/
+        if (all_tests)
+        {
+            prune_entries(history);
+        }
+        for (i = 0; i < history->count; i++)
+        {
+            history->entries[i].recorded = false;
+        }
+
+        if (write_file(history, history->path, history->generation + 1, false, false) != 0)
+        {
+            LogError("failure merging the shard files into %s", history->path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            history->generation++;
+            for (i = 0; i < history->shard_count; i++)
+            {
+                get_shard_path(history, i, shard_path, sizeof(shard_path));
+                (void)remove(shard_path);
+            }
+            LogInfo("merged the durations of %zu shards into %s", history->shard_count, history->path);
+        }
+    }
+
+    return result;
+}
+
+CTRS_DURATION_HISTORY_HANDLE ctrs_duration_history_load(const char* path, const char* suite_name, size_t shard_index, size_t shard_count)
+{
+    CTRS_DURATION_HISTORY_HANDLE result;
+
+    if (
+        (path == NULL) ||
+        (suite_name == NULL) ||
+        (shard_count == 0) ||
+        (shard_index >= shard_count) ||
+        (strlen(path) > DURATION_HISTORY_MAX_PATH)
+        )
+    {
+        LogError("Invalid arguments const char* path=%s, const char* suite_name=%s, size_t shard_index=%zu, size_t shard_count=%zu",
+            MU_P_OR_NULL(path), MU_P_OR_NULL(suite_name), shard_index, shard_count);
+        result = NULL;
+    }
+    else
+    {
+        char lock_name[256];
+        int written = snprintf(lock_name, sizeof(lock_name), DURATION_HISTORY_LOCK_PREFIX "%s", suite_name);
+
+        result = calloc(1, sizeof(CTRS_DURATION_HISTORY));
+        if (result == NULL)
+        {
+            LogError("failure in calloc(1, sizeof(CTRS_DURATION_HISTORY))");
+        }
+        else if ((written < 0) || ((size_t)written >= sizeof(lock_name)))
+        {
+            LogError("suite name %s is too long", suite_name);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->path = malloc(strlen(path) + 1)) == NULL)
+        {
+            LogError("failure in malloc(%zu)", strlen(path) + 1);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->lock = testmutex_create_named(lock_name)) == NULL)
+        {
+            LogError("failure in testmutex_create_named(%s)", lock_name);
+            free(result->path);
+            free(result);
+            result = NULL;
+        }
+        else if (testmutex_acquire(result->lock) != 0)
+        {
+            LogError("failure in testmutex_acquire(%s)", lock_name);
+            testmutex_destroy(result->lock);
+            free(result->path);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            int load_result;
+            bool found;
+
+            (void)strcpy(result->path, path);
+            result->shard_index = shard_index;
+            result->shard_count = shard_count;
+
+            bool all_tests;
+
+            load_result = read_file(result, path, false, &found, &result->generation, &all_tests);
+            if (load_result == 0)
+            {
+                sort_entries(result);
+                if (shard_count > 1)
+                {
+                    load_result = merge_shard_files(result);
+                }
+            }
+
+            (void)testmutex_release(result->lock);
+
+            if (load_result != 0)
+            {
+                LogError("failure reading the duration history %s", path);
+                ctrs_duration_history_destroy(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void ctrs_duration_history_destroy(CTRS_DURATION_HISTORY_HANDLE history)
+{
+    if (history == NULL)
+    {
+        LogError("Invalid arguments CTRS_DURATION_HISTORY_HANDLE history=%p", (void*)history);
+    }
+    else
+    {
+        free_entries(history->entries, history->count);
+        testmutex_destroy(history->lock);
+        free(history->path);
+        free(history);
+    }
+}
+
+bool ctrs_duration_history_get(CTRS_DURATION_HISTORY_HANDLE history, const char* test_name, double* duration_ms)
+{
+    bool result;
+
+    if (
+        (history == NULL) ||
+        (test_name == NULL) ||
+        (duration_ms == NULL)
+        )
+    {
+        LogError("Invalid arguments CTRS_DURATION_HISTORY_HANDLE history=%p, const char* test_name=%s, double* duration_ms=%p",
+            (void*)history, MU_P_OR_NULL(test_name), (void*)duration_ms);
+        result = false;
+    }
+    else
+    {
+        const DURATION_ENTRY* entry = find_entry(history, test_name);
+        if (entry == NULL)
+        {
+            result = false;
+        }
+        else
+        {
+            *duration_ms = entry->duration_ms;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+double ctrs_duration_history_get_default(CTRS_DURATION_HISTORY_HANDLE history)
+{
+    double result = 1;
+
+    if (history == NULL)
+    {
+        LogError("Invalid arguments CTRS_DURATION_HISTORY_HANDLE history=%p", (void*)history);
+    }
+    else if (history->count == 0)
+    {
+        /*nothing known, every test costs the same*/
+    }
+    else
+    {
+        double* durations = malloc(history->count * sizeof(double));
+        if (durations == NULL)
+        {
+            LogError("failure in malloc(%zu * sizeof(double))", history->count);
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < history->count; i++)
+            {
+                durations[i] = history->entries[i].duration_ms;
+            }
+            qsort(durations, history->count, sizeof(double), compare_doubles);
+            result = durations[history->count / 2];
+            free(durations);
+        }
+    }
+
+    return result;
+}
+
+void ctrs_duration_history_record(CTRS_DURATION_HISTORY_HANDLE history, const char* test_name, double duration_ms)
+{
+    if (
+        (history == NULL) ||
+        (test_name == NULL) ||
+        !(duration_ms >= 0)
+        )
+    {
+        LogError("Invalid arguments CTRS_DURATION_HISTORY_HANDLE history=%p, const char* test_name=%s, double duration_ms=%f",
+            (void*)history, MU_P_OR_NULL(test_name), duration_ms);
+    }
+    else
+    {
+        DURATION_ENTRY* entry = find_entry(history, test_name);
+        if (entry == NULL)
+        {
+            if (append_entry(history, test_name, duration_ms, true) != 0)
+            {
+                LogError("failure recording the duration of %s", test_name);
+            }
+        }
+        else
+        {
+            /*half the last run, half the runs before*/
+            entry->duration_ms = entry->recorded ? duration_ms : ((entry->duration_ms + duration_ms) / 2);
+            entry->recorded = true;
+        }
+    }
+}
+
+int ctrs_duration_history_save(CTRS_DURATION_HISTORY_HANDLE history, bool prune)
+{
+    int result;
+
+    if (history == NULL)
+    {
+        LogError("Invalid arguments CTRS_DURATION_HISTORY_HANDLE history=%p, bool prune=%" PRI_BOOL, (void*)history, MU_BOOL_VALUE(prune));
+        result = MU_FAILURE;
+    }
+    else if (testmutex_acquire(history->lock) != 0)
+    {
+        LogError("failure acquiring the lock of the duration history %s", history->path);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        sort_entries(history);
+
+        if (history->shard_count > 1)
+        {
+            char shard_path[DURATION_HISTORY_MAX_PATH + 64];
+            get_shard_path(history, history->shard_index, shard_path, sizeof(shard_path));
+            /*the generation the shard split the tests with, its durations are merged only with the files of the other shards of that split*/
+            result = write_file(history, shard_path, history->generation, true, prune);
+        }
+        else
+        {
+            if (prune)
+            {
+                prune_entries(history);
+            }
+
+            result = write_file(history, history->path, history->generation + 1, false, false);
+            if (result == 0)
+            {
+                history->generation++;
+            }
+        }
+
+        (void)testmutex_release(history->lock);
+    }
+
+    return result;
+}
+
+typedef struct COST_ORDER_TAG
+{
+    double cost;
+    size_t index;
+} COST_ORDER;
+
+static int compare_cost_order(const void* left, const void* right)
+{
+    const COST_ORDER* left_order = left;
+    const COST_ORDER* right_order = right;
+    int result;
+
+    /*decreasing cost, then increasing index, so that the order is the same in every process*/
+    if (left_order->cost > right_order->cost)
+    {
+        result = -1;
+    }
+    else if (left_order->cost < right_order->cost)
+    {
+        result = 1;
+    }
+    else
+    {
+        result = (left_order->index < right_order->index) ? -1 : ((left_order->index > right_order->index) ? 1 : 0);
+    }
+
+    return result;
+}
+
+int ctrs_duration_history_assign_longest_first(const double* costs, size_t item_count, size_t bin_count, size_t* bins)
+{
+    int result;
+
+    if (
+        ((costs == NULL) && (item_count != 0)) ||
+        (bin_count == 0) ||
+        ((bins == NULL) && (item_count != 0))
+        )
+    {
+        LogError("Invalid arguments const double* costs=%p, size_t item_count=%zu, size_t bin_count=%zu, size_t* bins=%p",
+            (const void*)costs, item_count, bin_count, (void*)bins);
+        result = MU_FAILURE;
+    }
+    else if (item_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        COST_ORDER* order = malloc(item_count * sizeof(COST_ORDER));
+        double* bin_costs = calloc(bin_count, sizeof(double));
+
+        if ((order == NULL) || (bin_costs == NULL))
+        {
+            LogError("failure allocating the order of %zu items in %zu bins", item_count, bin_count);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < item_count; i++)
+            {
+                order[i].cost = costs[i];
+                order[i].index = i;
+            }
+            qsort(order, item_count, sizeof(COST_ORDER), compare_cost_order);
+
+            for (i = 0; i < item_count; i++)
+            {
+                size_t bin;
+                size_t least_bin = 0;
+
+                /*bin_count is small (jobs or shards), a scan is cheaper than a heap*/
+                for (bin = 1; bin < bin_count; bin++)
+                {
+                    if (bin_costs[bin] < bin_costs[least_bin])
+                    {
+                        least_bin = bin;
+                    }
+                }
+
+                bins[order[i].index] = least_bin;
+                bin_costs[least_bin] += order[i].cost;
+            }
+
+            result = 0;
+        }
+
+        free(bin_costs);
+        free(order);
+    }
+
+    return result;
+}
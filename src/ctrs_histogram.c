@@ -0,0 +1,396 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_histogram.h"
+
+#define SUB_BUCKET_COUNT ((uint64_t)1 << CTRS_HISTOGRAM_SUB_BUCKET_BITS)
+/*the values below are their own bucket*/
+#define EXACT_LIMIT (2 * SUB_BUCKET_COUNT)
+/*above EXACT_LIMIT every power of 2 (from 2^(CTRS_HISTOGRAM_SUB_BUCKET_BITS + 1) to 2^63) has SUB_BUCKET_COUNT buckets*/
+#define BUCKET_COUNT (EXACT_LIMIT + (64 - (CTRS_HISTOGRAM_SUB_BUCKET_BITS + 1)) * SUB_BUCKET_COUNT)
+
+typedef struct CTRS_HISTOGRAM_TAG
+{
+    uint64_t total_count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    uint64_t counts[BUCKET_COUNT];
+} CTRS_HISTOGRAM;
+
+static unsigned int highest_bit(uint64_t value)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    (void)_BitScanReverse64(&index, value);
+    return (unsigned int)index;
+#elif defined(_MSC_VER)
+    unsigned int index = 63;
+    while ((value & ((uint64_t)1 << index)) == 0)
+    {
+        index--;
+    }
+    return index;
+#else
+    return 63u - (unsigned int)__builtin_clzll(value);
+#endif
+}
+
+static size_t bucket_index(uint64_t value)
+{
+    size_t result;
+
+    if (value < EXACT_LIMIT)
+    {
+        result = (size_t)value;
+    }
+    else
+    {
+        /*the highest CTRS_HISTOGRAM_SUB_BUCKET_BITS + 1 bits of the value, which start with a 1*/
+        unsigned int shift = highest_bit(value) - CTRS_HISTOGRAM_SUB_BUCKET_BITS;
+        result = (size_t)(shift * SUB_BUCKET_COUNT + (value >> shift));
+    }
+
+    return result;
+}
+
+/*the highest value that falls in bucket index*/
+static uint64_t bucket_highest_value(size_t index)
+{
+    uint64_t result;
+
+    if (index < EXACT_LIMIT)
+    {
+        result = (uint64_t)index;
+    }
+    else
+    {
+        unsigned int shift = (unsigned int)(index / SUB_BUCKET_COUNT) - 1;
+        uint64_t sub_bucket = (uint64_t)index - (uint64_t)shift * SUB_BUCKET_COUNT;
+        result = (sub_bucket << shift) + (((uint64_t)1 << shift) - 1);
+    }
+
+    return result;
+}
+
+CTRS_HISTOGRAM_HANDLE ctrs_histogram_create(void)
+{
+    CTRS_HISTOGRAM_HANDLE result = malloc(sizeof(CTRS_HISTOGRAM));
+    if (result == NULL)
+    {
+        LogError("failure in malloc(sizeof(CTRS_HISTOGRAM)=%zu)", sizeof(CTRS_HISTOGRAM));
+    }
+    else
+    {
+        ctrs_histogram_reset(result);
+    }
+    return result;
+}
+
+void ctrs_histogram_destroy(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+    }
+    else
+    {
+        free(histogram);
+    }
+}
+
+void ctrs_histogram_reset(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+    }
+    else
+    {
+        (void)memset(histogram, 0, sizeof(CTRS_HISTOGRAM));
+        histogram->min = UINT64_MAX;
+    }
+}
+
+void ctrs_histogram_record(CTRS_HISTOGRAM_HANDLE histogram, uint64_t value)
+{
+    ctrs_histogram_record_count(histogram, value, 1);
+}
+
+void ctrs_histogram_record_count(CTRS_HISTOGRAM_HANDLE histogram, uint64_t value, uint64_t count)
+{
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p, uint64_t value=%" PRIu64 ", uint64_t count=%" PRIu64, (void*)histogram, value, count);
+    }
+    else if (count != 0)
+    {
+        histogram->counts[bucket_index(value)] += count;
+        histogram->total_count += count;
+        histogram->sum += (double)value * (double)count;
+        if (value < histogram->min)
+        {
+            histogram->min = value;
+        }
+        if (value > histogram->max)
+        {
+            histogram->max = value;
+        }
+    }
+    else
+    {
+        /*nothing to record*/
+    }
+}
+
+int ctrs_histogram_add(CTRS_HISTOGRAM_HANDLE destination, CTRS_HISTOGRAM_HANDLE source)
+{
+    int result;
+
+    if ((destination == NULL) || (source == NULL))
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE destination=%p, CTRS_HISTOGRAM_HANDLE source=%p", (void*)destination, (void*)source);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < BUCKET_COUNT; i++)
+        {
+            destination->counts[i] += source->counts[i];
+        }
+        destination->total_count += source->total_count;
+        destination->sum += source->sum;
+        if (source->min < destination->min)
+        {
+            destination->min = source->min;
+        }
+        if (source->max > destination->max)
+        {
+            destination->max = source->max;
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+uint64_t ctrs_histogram_get_count(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    uint64_t result;
+
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+        result = 0;
+    }
+    else
+    {
+        result = histogram->total_count;
+    }
+
+    return result;
+}
+
+uint64_t ctrs_histogram_get_min(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    uint64_t result;
+
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+        result = 0;
+    }
+    else
+    {
+        result = (histogram->total_count == 0) ? 0 : histogram->min;
+    }
+
+    return result;
+}
+
+uint64_t ctrs_histogram_get_max(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    uint64_t result;
+
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+        result = 0;
+    }
+    else
+    {
+        result = histogram->max;
+    }
+
+    return result;
+}
+
+double ctrs_histogram_get_mean(CTRS_HISTOGRAM_HANDLE histogram)
+{
+    double result;
+
+    if (histogram == NULL)
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p", (void*)histogram);
+        result = 0;
+    }
+    else
+    {
+        result = (histogram->total_count == 0) ? 0 : (histogram->sum / (double)histogram->total_count);
+    }
+
+    return result;
+}
+
+/*the value of the rank-th (1 based) smallest recorded value, rank is at most total_count*/
+static uint64_t value_at_rank(CTRS_HISTOGRAM_HANDLE histogram, uint64_t rank)
+{
+    uint64_t result = histogram->max;
+    uint64_t cumulative_count = 0;
+    size_t i;
+
+    for (i = 0; i < BUCKET_COUNT; i++)
+    {
+        cumulative_count += histogram->counts[i];
+        if (cumulative_count >= rank)
+        {
+            uint64_t highest = bucket_highest_value(i);
+            result = (highest < histogram->max) ? highest : histogram->max;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static uint64_t rank_of_percentile(uint64_t total_count, double percentile)
+{
+    /*nearest rank*/
+    double rank = ceil(percentile / 100.0 * (double)total_count);
+    return (rank < 1) ? 1 : ((rank > (double)total_count) ? total_count : (uint64_t)rank);
+}
+
+uint64_t ctrs_histogram_get_percentile(CTRS_HISTOGRAM_HANDLE histogram, double percentile)
+{
+    uint64_t result;
+
+    if (
+        (histogram == NULL) ||
+        !(percentile >= 0) ||
+        (percentile > 100)
+        )
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p, double percentile=%f", (void*)histogram, percentile);
+        result = 0;
+    }
+    else if (histogram->total_count == 0)
+    {
+        result = 0;
+    }
+    else if (percentile == 0)
+    {
+        result = histogram->min;
+    }
+    else
+    {
+        result = value_at_rank(histogram, rank_of_percentile(histogram->total_count, percentile));
+    }
+
+    return result;
+}
+
+void ctrs_histogram_log_distribution(CTRS_HISTOGRAM_HANDLE histogram, const char* name)
+{
+    if ((histogram == NULL) || (name == NULL))
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p, const char* name=%s", (void*)histogram, MU_P_OR_NULL(name));
+    }
+    else if (histogram->total_count == 0)
+    {
+        LogInfo("Histogram %s: no values recorded", name);
+    }
+    else
+    {
+        /*the percentiles halve the distance to 100% each time (50, 75, 87.5, ...) until they are past the last but one value*/
+        double remaining = 50.0;
+        double percentile = 50.0;
+
+        LogInfo("Histogram %s: %" PRIu64 " values, min=%" PRIu64 " mean=%.1f max=%" PRIu64,
+            name, histogram->total_count, ctrs_histogram_get_min(histogram), ctrs_histogram_get_mean(histogram), histogram->max);
+        LogInfo("%20s %14s %20s", "Value", "Percentile", "TotalCount");
+
+        while (true)
+        {
+            uint64_t rank = rank_of_percentile(histogram->total_count, percentile);
+            LogInfo("%20" PRIu64 " %13.6f%% %20" PRIu64, value_at_rank(histogram, rank), percentile, rank);
+
+            if (rank >= histogram->total_count)
+            {
+                break;
+            }
+
+            remaining /= 2;
+            percentile = 100.0 - remaining;
+            if ((double)histogram->total_count * remaining / 100.0 < 1.0)
+            {
+                /*fewer than 1 value left above, the next line would be the max anyway*/
+                LogInfo("%20" PRIu64 " %13.6f%% %20" PRIu64, histogram->max, 100.0, histogram->total_count);
+                break;
+            }
+        }
+    }
+}
+
+int ctrs_histogram_check_percentile(CTRS_HISTOGRAM_HANDLE histogram, const char* name, double percentile, uint64_t max_value)
+{
+    int result;
+
+    if (
+        (histogram == NULL) ||
+        (name == NULL) ||
+        !(percentile >= 0) ||
+        (percentile > 100)
+        )
+    {
+        LogError("Invalid arguments CTRS_HISTOGRAM_HANDLE histogram=%p, const char* name=%s, double percentile=%f, uint64_t max_value=%" PRIu64,
+            (void*)histogram, MU_P_OR_NULL(name), percentile, max_value);
+        result = MU_FAILURE;
+    }
+    else if (histogram->total_count == 0)
+    {
+        LogError("Histogram %s: no values recorded, p%g cannot be checked", name, percentile);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        uint64_t value = ctrs_histogram_get_percentile(histogram, percentile);
+        if (value > max_value)
+        {
+            LogError("Histogram %s: p%g is %" PRIu64 ", expected at most %" PRIu64, name, percentile, value, max_value);
+            ctrs_histogram_log_distribution(histogram, name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,237 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_perf_baseline.h"
+
+#define CTRS_PERF_BASELINE_MAX_LINE 1024
+
+/*parses "name median [tolerance]" into its parts (name points into line), returns false for comments, empty and malformed lines*/
+static bool parse_baseline_line(char* line, const char** name, double* median_ns, double* tolerance_percent, bool* has_tolerance)
+{
+    bool result;
+    char* token;
+    char* end;
+
+    token = strtok(line, " \t\r\n");
+    if ((token == NULL) || (token[0] == '#'))
+    {
+        result = false;
+    }
+    else
+    {
+        *name = token;
+
+        token = strtok(NULL, " \t\r\n");
+        if (token == NULL)
+        {
+            result = false;
+        }
+        else
+        {
+            *median_ns = strtod(token, &end);
+            if ((*end != '\0') || (*median_ns <= 0))
+            {
+                result = false;
+            }
+            else
+            {
+                token = strtok(NULL, " \t\r\n");
+                if (token == NULL)
+                {
+                    *has_tolerance = false;
+                    result = true;
+                }
+                else
+                {
+                    *tolerance_percent = strtod(token, &end);
+                    *has_tolerance = true;
+                    result = (*end == '\0') && (*tolerance_percent >= 0);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int ctrs_perf_baseline_check(const char* baseline_file, double tolerance_percent, const char* name, double median_ns)
+{
+    int result;
+
+    if (
+        (baseline_file == NULL) ||
+        (name == NULL) ||
+        (tolerance_percent < 0)
+        )
+    {
+        LogError("Invalid arguments const char* baseline_file=%s, double tolerance_percent=%f, const char* name=%s, double median_ns=%f",
+            MU_P_OR_NULL(baseline_file), tolerance_percent, MU_P_OR_NULL(name), median_ns);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        FILE* file = fopen(baseline_file, "r");
+        if (file == NULL)
+        {
+            LogError("failure in fopen(%s, \"r\"), the perf baseline cannot be read", baseline_file);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            char line[CTRS_PERF_BASELINE_MAX_LINE];
+            unsigned int line_number = 0;
+            bool found = false;
+
+            result = 0;
+            while (!found && (fgets(line, sizeof(line), file) != NULL))
+            {
+                const char* line_name;
+                double baseline_median_ns;
+                double line_tolerance_percent;
+                bool has_tolerance;
+
+                line_number++;
+                if (
+                    parse_baseline_line(line, &line_name, &baseline_median_ns, &line_tolerance_percent, &has_tolerance) &&
+                    (strcmp(line_name, name) == 0)
+                    )
+                {
+                    double tolerance = has_tolerance ? line_tolerance_percent : tolerance_percent;
+                    double limit_ns = baseline_median_ns * (1.0 + (tolerance / 100.0));
+                    double change_percent = ((median_ns - baseline_median_ns) * 100.0) / baseline_median_ns;
+
+                    found = true;
+                    if (median_ns > limit_ns)
+                    {
+                        LogError("Benchmark %s REGRESSED: median %.2f ns/op is %+.1f%% over the baseline %.2f ns/op (%s:%u), tolerance is %.1f%%",
+                            name, median_ns, change_percent, baseline_median_ns, baseline_file, line_number, tolerance);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        LogInfo("Benchmark %s: median %.2f ns/op is %+.1f%% against the baseline %.2f ns/op, tolerance is %.1f%%",
+                            name, median_ns, change_percent, baseline_median_ns, tolerance);
+                    }
+                }
+            }
+
+            if (!found)
+            {
+                LogWarning("Benchmark %s has no baseline in %s, run the _update_baseline target of the suite to add it", name, baseline_file);
+            }
+
+            (void)fclose(file);
+        }
+    }
+
+    return result;
+}
+
+int ctrs_perf_baseline_append(const char* baseline_file, const char* name, double median_ns)
+{
+    int result;
+
+    if (
+        (baseline_file == NULL) ||
+        (name == NULL)
+        )
+    {
+        LogError("Invalid arguments const char* baseline_file=%s, const char* name=%s, double median_ns=%f",
+            MU_P_OR_NULL(baseline_file), MU_P_OR_NULL(name), median_ns);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        FILE* file = fopen(baseline_file, "a");
+        if (file == NULL)
+        {
+            LogError("failure in fopen(%s, \"a\")", baseline_file);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if ((fseek(file, 0, SEEK_END) == 0) && (ftell(file) == 0))
+            {
+                (void)fprintf(file, "# <benchmark name> <median ns per iteration> [<tolerance percent>]\n");
+            }
+
+            (void)fprintf(file, "%s %.2f\n", name, median_ns);
+
+            if (ferror(file) != 0)
+            {
+                LogError("failure writing to %s", baseline_file);
+                (void)fclose(file);
+                result = MU_FAILURE;
+            }
+            else if (fclose(file) != 0)
+            {
+                LogError("failure in fclose for %s", baseline_file);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                LogInfo("Benchmark %s: median %.2f ns/op recorded in %s", name, median_ns, baseline_file);
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int ctrs_perf_baseline_apply(const char* name, double median_ns)
+{
+    int result;
+
+    if (name == NULL)
+    {
+        LogError("Invalid arguments const char* name=%s, double median_ns=%f", MU_P_OR_NULL(name), median_ns);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        const char* update_file = getenv(CTRS_PERF_BASELINE_UPDATE_ENV);
+        const char* baseline_file = getenv(CTRS_PERF_BASELINE_ENV);
+
+        if ((update_file != NULL) && (update_file[0] != '\0'))
+        {
+            result = ctrs_perf_baseline_append(update_file, name, median_ns);
+        }
+        else if ((baseline_file != NULL) && (baseline_file[0] != '\0'))
+        {
+            double tolerance_percent = CTRS_PERF_DEFAULT_TOLERANCE_PERCENT;
+            const char* tolerance = getenv(CTRS_PERF_TOLERANCE_PERCENT_ENV);
+
+            if ((tolerance != NULL) && (tolerance[0] != '\0'))
+            {
+                char* end;
+                double parsed = strtod(tolerance, &end);
+                if ((*end != '\0') || (parsed < 0))
+                {
+                    LogWarning("ignoring invalid " CTRS_PERF_TOLERANCE_PERCENT_ENV "=%s, using %.1f", tolerance, tolerance_percent);
+                }
+                else
+                {
+                    tolerance_percent = parsed;
+                }
+            }
+
+            result = ctrs_perf_baseline_check(baseline_file, tolerance_percent, name, median_ns);
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,329 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_perf_counters.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(CTRS_PERF_COUNTER, CTRS_PERF_COUNTER_VALUES)
+
+/*the names in the log and in the reports, in the order of CTRS_PERF_COUNTER*/
+static const char* const g_counter_names[CTRS_PERF_COUNTER_COUNT] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+const char* ctrs_perf_counter_name(CTRS_PERF_COUNTER counter)
+{
+    return ((size_t)counter < CTRS_PERF_COUNTER_COUNT) ? g_counter_names[counter] : "unknown";
+}
+
+bool ctrs_perf_counters_are_requested(void)
+{
+    const char* value = getenv(CTRS_PERF_COUNTERS_ENV);
+    return (value != NULL) && (value[0] != '\0') && (strcmp(value, "0") != 0);
+}
+
+#ifdef __linux__
+
+#define PERF_COUNTERS_STATE_VALUES \
+    PERF_COUNTERS_STATE_NOT_OPENED, \
+    PERF_COUNTERS_STATE_OPENED, \
+    PERF_COUNTERS_STATE_UNAVAILABLE
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(PERF_COUNTERS_STATE, PERF_COUNTERS_STATE_VALUES)
+
+static const uint64_t g_counter_configs[CTRS_PERF_COUNTER_COUNT] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static PERF_COUNTERS_STATE g_state = PERF_COUNTERS_STATE_NOT_OPENED;
+static int g_counter_fds[CTRS_PERF_COUNTER_COUNT] = { -1, -1, -1, -1 };
+/*a forked child inherits the file descriptors, but they keep counting the parent, the child opens its own*/
+static pid_t g_opened_by_pid;
+
+static void log_why_unavailable(int open_errno)
+{
+    char paranoid[16] = "?";
+    FILE* file = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (file != NULL)
+    {
+        if (fgets(paranoid, sizeof(paranoid), file) != NULL)
+        {
+            paranoid[strcspn(paranoid, "\r\n")] = '\0';
+        }
+        (void)fclose(file);
+    }
+
+    LogInfo("hardware performance counters are not available, the tests run without them (perf_event_open failed with errno=%d (%s), perf_event_paranoid=%s)",
+        open_errno, strerror(open_errno), paranoid);
+}
+
+static void close_counters(void)
+{
+    size_t i;
+    for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+    {
+        if (g_counter_fds[i] != -1)
+        {
+            (void)close(g_counter_fds[i]);
+            g_counter_fds[i] = -1;
+        }
+    }
+}
+
+static void open_counters(void)
+{
+    size_t i;
+    size_t opened_count = 0;
+    int first_errno = 0;
+
+    for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attributes;
+        (void)memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = g_counter_configs[i];
+        /*user space only, which perf_event_paranoid=2 (the default of most distributions) still allows*/
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        /*the threads the test starts count too*/
+        attributes.inherit = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        /*not a group: with inherit the kernel cannot read a group, and a counter the CPU does not have should not take the others down*/
+        g_counter_fds[i] = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (g_counter_fds[i] == -1)
+        {
+            if (first_errno == 0)
+            {
+                first_errno = errno;
+            }
+        }
+        else
+        {
+            opened_count++;
+        }
+    }
+
+    if (opened_count == 0)
+    {
+        log_why_unavailable(first_errno);
+        g_state = PERF_COUNTERS_STATE_UNAVAILABLE;
+    }
+    else
+    {
+        for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+        {
+            if (g_counter_fds[i] == -1)
+            {
+                LogInfo("hardware performance counter %s is not available", g_counter_names[i]);
+            }
+        }
+        g_opened_by_pid = getpid();
+        g_state = PERF_COUNTERS_STATE_OPENED;
+    }
+}
+
+bool ctrs_perf_counters_are_available(void)
+{
+    if (g_state == PERF_COUNTERS_STATE_NOT_OPENED)
+    {
+        if (ctrs_perf_counters_are_requested())
+        {
+            open_counters();
+        }
+        else
+        {
+            g_state = PERF_COUNTERS_STATE_UNAVAILABLE;
+        }
+    }
+    else if ((g_state == PERF_COUNTERS_STATE_OPENED) && (g_opened_by_pid != getpid()))
+    {
+        close_counters();
+        open_counters();
+    }
+    else
+    {
+        /*already decided*/
+    }
+
+    return (g_state == PERF_COUNTERS_STATE_OPENED);
+}
+
+void ctrs_perf_counters_read(CTRS_PERF_COUNTS* counts)
+{
+    if (counts == NULL)
+    {
+        LogError("Invalid arguments CTRS_PERF_COUNTS* counts=%p", (void*)counts);
+    }
+    else
+    {
+        (void)memset(counts, 0, sizeof(CTRS_PERF_COUNTS));
+
+        if (ctrs_perf_counters_are_available())
+        {
+            size_t i;
+            for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+            {
+                if (g_counter_fds[i] != -1)
+                {
+                    /*value, time enabled, time running*/
+                    uint64_t read_values[3];
+                    if (read(g_counter_fds[i], read_values, sizeof(read_values)) != (ssize_t)sizeof(read_values))
+                    {
+                        LogError("failure in read of hardware performance counter %s, errno=%d", g_counter_names[i], errno);
+                    }
+                    else
+                    {
+                        counts->counted[i] = true;
+                        counts->values[i] = ((read_values[2] != 0) && (read_values[2] < read_values[1]))
+                            ? (uint64_t)((double)read_values[0] * (double)read_values[1] / (double)read_values[2])
+                            : read_values[0];
+                    }
+                }
+            }
+        }
+    }
+}
+
+#else
+
+bool ctrs_perf_counters_are_available(void)
+{
+    static bool logged = false;
+    if (!logged && ctrs_perf_counters_are_requested())
+    {
+        LogInfo("hardware performance counters are only available on Linux, the tests run without them");
+        logged = true;
+    }
+    return false;
+}
+
+void ctrs_perf_counters_read(CTRS_PERF_COUNTS* counts)
+{
+    if (counts == NULL)
+    {
+        LogError("Invalid arguments CTRS_PERF_COUNTS* counts=%p", (void*)counts);
+    }
+    else
+    {
+        (void)memset(counts, 0, sizeof(CTRS_PERF_COUNTS));
+        (void)ctrs_perf_counters_are_available();
+    }
+}
+
+#endif
+
+void ctrs_perf_counts_delta(const CTRS_PERF_COUNTS* before, const CTRS_PERF_COUNTS* after, CTRS_PERF_COUNTS* delta)
+{
+    if ((before == NULL) || (after == NULL) || (delta == NULL))
+    {
+        LogError("Invalid arguments const CTRS_PERF_COUNTS* before=%p, const CTRS_PERF_COUNTS* after=%p, CTRS_PERF_COUNTS* delta=%p", (void*)before, (void*)after, (void*)delta);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+        {
+            delta->counted[i] = before->counted[i] && after->counted[i];
+            delta->values[i] = delta->counted[i] ? (after->values[i] - before->values[i]) : 0;
+        }
+    }
+}
+
+bool ctrs_perf_counts_any_counted(const CTRS_PERF_COUNTS* counts)
+{
+    bool result = false;
+
+    if (counts == NULL)
+    {
+        LogError("Invalid arguments const CTRS_PERF_COUNTS* counts=%p", (void*)counts);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < CTRS_PERF_COUNTER_COUNT; i++)
+        {
+            if (counts->counted[i])
+            {
+                result = true;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+void ctrs_perf_counts_format(const CTRS_PERF_COUNTS* counts, double divisor, char* buffer, size_t buffer_size)
+{
+    if ((counts == NULL) || (divisor <= 0) || (buffer == NULL) || (buffer_size == 0))
+    {
+        LogError("Invalid arguments const CTRS_PERF_COUNTS* counts=%p, double divisor=%f, char* buffer=%p, size_t buffer_size=%zu", (void*)counts, divisor, (void*)buffer, buffer_size);
+    }
+    else
+    {
+        size_t written = 0;
+        size_t i;
+
+        buffer[0] = '\0';
+        for (i = 0; (i < CTRS_PERF_COUNTER_COUNT) && (written < buffer_size); i++)
+        {
+            if (counts->counted[i])
+            {
+                int result = snprintf(buffer + written, buffer_size - written, "%s%s=%.2f", (written == 0) ? "" : " ", g_counter_names[i], (double)counts->values[i] / divisor);
+                written = (result < 0) ? buffer_size : (written + (size_t)result);
+            }
+
+            /*instructions per cycle right after the 2 of them*/
+            if ((i == CTRS_PERF_COUNTER_INSTRUCTIONS) && (written < buffer_size) &&
+                counts->counted[CTRS_PERF_COUNTER_CYCLES] && counts->counted[CTRS_PERF_COUNTER_INSTRUCTIONS] && (counts->values[CTRS_PERF_COUNTER_CYCLES] != 0))
+            {
+                int result = snprintf(buffer + written, buffer_size - written, " IPC=%.2f", (double)counts->values[CTRS_PERF_COUNTER_INSTRUCTIONS] / (double)counts->values[CTRS_PERF_COUNTER_CYCLES]);
+                written = (result < 0) ? buffer_size : (written + (size_t)result);
+            }
+        }
+    }
+}
+
+void ctrs_perf_counters_log_since(const char* region_name, const CTRS_PERF_COUNTS* start)
+{
+    if ((region_name == NULL) || (start == NULL))
+    {
+        LogError("Invalid arguments const char* region_name=%s, const CTRS_PERF_COUNTS* start=%p", MU_P_OR_NULL(region_name), (void*)start);
+    }
+    else
+    {
+        CTRS_PERF_COUNTS now;
+        CTRS_PERF_COUNTS delta;
+
+        ctrs_perf_counters_read(&now);
+        ctrs_perf_counts_delta(start, &now, &delta);
+
+        if (ctrs_perf_counts_any_counted(&delta))
+        {
+            char formatted[256];
+            ctrs_perf_counts_format(&delta, 1, formatted, sizeof(formatted));
+            LogInfo("Region %s: %s", region_name, formatted);
+        }
+    }
+}
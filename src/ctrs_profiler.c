@@ -0,0 +1,445 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef _WIN32
+/*dladdr and Dl_info*/
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sched.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_profiler.h"
+
+static bool is_file_name_character(char c)
+{
+    return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_') || (c == '-') || (c == '.');
+}
+
+int ctrs_profiler_get_folded_path(const char* directory, const char* suite_name, const char* test_name, char* path, size_t path_size)
+{
+    int result;
+
+    if (
+        (directory == NULL) ||
+        (suite_name == NULL) ||
+        (test_name == NULL) ||
+        (path == NULL)
+        )
+    {
+        LogError("Invalid arguments const char* directory=%s, const char* suite_name=%s, const char* test_name=%s, char* path=%p, size_t path_size=%zu",
+            MU_P_OR_NULL(directory), MU_P_OR_NULL(suite_name), MU_P_OR_NULL(test_name), (void*)path, path_size);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        int written = snprintf(path, path_size, "%s/%s.%s.folded", directory, suite_name, test_name);
+        if ((written < 0) || ((size_t)written >= path_size))
+        {
+            LogError("the profile path of %s in %s does not fit in %zu characters", test_name, directory, path_size);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            /*only the file name, the directory is used as given*/
+            char* file_name = path + strlen(directory) + 1;
+            for (; *file_name != '\0'; file_name++)
+            {
+                if (!is_file_name_character(*file_name))
+                {
+                    *file_name = '_';
+                }
+            }
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+#ifdef _WIN32
+int ctrs_profiler_start(uint32_t frequency_hz)
+{
+    (void)frequency_hz;
+    return MU_FAILURE;
+}
+
+int ctrs_profiler_stop(const char* folded_path, size_t* sample_count)
+{
+    (void)folded_path;
+    if (sample_count != NULL)
+    {
+        *sample_count = 0;
+    }
+    return MU_FAILURE;
+}
+#else
+/*frames kept per sample, deeper stacks lose their outermost frames*/
+#define PROFILER_MAX_FRAMES 64
+/*the frames of the handler and of the signal trampoline, above the interrupted function*/
+#define PROFILER_SKIPPED_FRAMES 2
+/*8 MB of samples, about 16 s of CPU time at 999 Hz with 64 frames per sample, more with shallower stacks*/
+#define PROFILER_BUFFER_SIZE ((size_t)1 << 20)
+#define PROFILER_MAX_FRAME_NAME 256
+
+/*
+The samples are written by the handler of SIGPROF, on whichever thread used the CPU, as [frame count, frames innermost first...] in one
+buffer allocated when the profile starts. A handler reserves its space with an atomic add, so handlers on several threads do not overlap.
+*/
+typedef struct CTRS_PROFILE_TAG
+{
+    uintptr_t* buffer;
+    size_t used; /*can go past PROFILER_BUFFER_SIZE, the samples that did not fit are dropped*/
+    size_t dropped_count;
+    int sampling;
+    int handlers_running; /*the handlers between their check of sampling and their last write*/
+} CTRS_PROFILE;
+
+static CTRS_PROFILE g_profile;
+static bool g_handler_installed;
+
+static void on_profile_signal(int signal_number)
+{
+    void* frames[PROFILER_MAX_FRAMES + PROFILER_SKIPPED_FRAMES];
+    int saved_errno = errno;
+
+    (void)signal_number;
+
+    (void)__atomic_add_fetch(&g_profile.handlers_running, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&g_profile.sampling, __ATOMIC_SEQ_CST))
+    {
+        int frame_count = backtrace(frames, PROFILER_MAX_FRAMES + PROFILER_SKIPPED_FRAMES);
+        if (frame_count > PROFILER_SKIPPED_FRAMES)
+        {
+            size_t kept_count = (size_t)frame_count - PROFILER_SKIPPED_FRAMES;
+            size_t start = __atomic_fetch_add(&g_profile.used, kept_count + 1, __ATOMIC_SEQ_CST);
+
+            if (start + kept_count + 1 > PROFILER_BUFFER_SIZE)
+            {
+                (void)__atomic_add_fetch(&g_profile.dropped_count, 1, __ATOMIC_SEQ_CST);
+            }
+            else
+            {
+                size_t i;
+                for (i = 0; i < kept_count; i++)
+                {
+                    g_profile.buffer[start + 1 + i] = (uintptr_t)frames[PROFILER_SKIPPED_FRAMES + i];
+                }
+                /*the count last: the buffer is zeroed, a reader that sees it 0 stops there*/
+                __atomic_store_n(&g_profile.buffer[start], (uintptr_t)kept_count, __ATOMIC_RELEASE);
+            }
+        }
+    }
+    (void)__atomic_sub_fetch(&g_profile.handlers_running, 1, __ATOMIC_SEQ_CST);
+
+    errno = saved_errno;
+}
+
+static int install_handler(void)
+{
+    int result;
+
+    if (g_handler_installed)
+    {
+        result = 0;
+    }
+    else
+    {
+        struct sigaction action;
+        void* frame;
+
+        (void)memset(&action, 0, sizeof(action));
+        (void)sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        action.sa_handler = on_profile_signal;
+
+        /*the first backtrace loads the unwinder, which is better not done in a signal handler*/
+        (void)backtrace(&frame, 1);
+
+        /*the handler stays installed, a SIGPROF left in flight after a profile is ignored instead of ending the process*/
+        if (sigaction(SIGPROF, &action, NULL) != 0)
+        {
+            LogError("failure in sigaction(SIGPROF), errno=%d", errno);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            g_handler_installed = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int set_timer(uint32_t frequency_hz)
+{
+    int result;
+    struct itimerval timer;
+
+    /*frequency_hz = 0 disarms the timer*/
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = (frequency_hz == 0) ? 0 : (suseconds_t)(1000000 / frequency_hz);
+    timer.it_value = timer.it_interval;
+
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+    {
+        LogError("failure in setitimer(ITIMER_PROF, %" PRIu32 " Hz), errno=%d", frequency_hz, errno);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int ctrs_profiler_start(uint32_t frequency_hz)
+{
+    int result;
+
+    if ((frequency_hz == 0) || (frequency_hz > 1000000))
+    {
+        LogError("Invalid arguments uint32_t frequency_hz=%" PRIu32, frequency_hz);
+        result = MU_FAILURE;
+    }
+    else if (g_profile.buffer != NULL)
+    {
+        LogError("a profile is already running");
+        result = MU_FAILURE;
+    }
+    else if (install_handler() != 0)
+    {
+        LogError("failure installing the handler of SIGPROF");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        g_profile.buffer = calloc(PROFILER_BUFFER_SIZE, sizeof(uintptr_t));
+        if (g_profile.buffer == NULL)
+        {
+            LogError("failure in calloc(%zu, sizeof(uintptr_t))", PROFILER_BUFFER_SIZE);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            g_profile.used = 0;
+            g_profile.dropped_count = 0;
+            __atomic_store_n(&g_profile.sampling, 1, __ATOMIC_SEQ_CST);
+
+            if (set_timer(frequency_hz) != 0)
+            {
+                __atomic_store_n(&g_profile.sampling, 0, __ATOMIC_SEQ_CST);
+                free(g_profile.buffer);
+                g_profile.buffer = NULL;
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*appends ";name" (or "name" for the first frame) of the function at address to line, which has line_size characters*/
+static void append_frame_name(char* line, size_t line_size, const void* address)
+{
+    size_t length = strlen(line);
+    char name[PROFILER_MAX_FRAME_NAME];
+    Dl_info info;
+    bool found = (dladdr(address, &info) != 0);
+    size_t i;
+
+    if (found && (info.dli_sname != NULL))
+    {
+        (void)snprintf(name, sizeof(name), "%s", info.dli_sname);
+    }
+    else if (found && (info.dli_fname != NULL))
+    {
+        /*a static function, or a module without symbols: what addr2line -e module needs*/
+        const char* module_name = strrchr(info.dli_fname, '/');
+        (void)snprintf(name, sizeof(name), "%s+0x%" PRIxPTR, (module_name == NULL) ? info.dli_fname : module_name + 1, (uintptr_t)address - (uintptr_t)info.dli_fbase);
+    }
+    else
+    {
+        (void)snprintf(name, sizeof(name), "0x%" PRIxPTR, (uintptr_t)address);
+    }
+
+    /*';' separates the frames and ' ' the count*/
+    for (i = 0; name[i] != '\0'; i++)
+    {
+        if ((name[i] == ';') || (name[i] == ' ') || (name[i] == '\n'))
+        {
+            name[i] = '_';
+        }
+    }
+
+    (void)snprintf(line + length, line_size - length, "%s%s", (length == 0) ? "" : ";", name);
+}
+
+static int compare_lines(const void* left, const void* right)
+{
+    return strcmp(*(const char* const*)left, *(const char* const*)right);
+}
+
+/*turns the sample_count samples at the start of buffer into lines of folded stacks, sorts them and writes every distinct line with its count*/
+static int write_folded(const char* folded_path, const uintptr_t* buffer, size_t sample_count)
+{
+    int result;
+    char** lines = malloc((sample_count + 1) * sizeof(char*));
+    char* line = malloc(PROFILER_MAX_FRAMES * PROFILER_MAX_FRAME_NAME);
+
+    if ((lines == NULL) || (line == NULL))
+    {
+        LogError("failure allocating the folded stacks of %zu samples", sample_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t line_count = 0;
+        size_t index = 0;
+        FILE* folded_file;
+
+        result = 0;
+        while ((line_count < sample_count) && (result == 0))
+        {
+            size_t frame_count = (size_t)buffer[index];
+            size_t frame;
+
+            line[0] = '\0';
+            /*outermost frame first; the first frame is where the thread was interrupted, the others are return addresses, inside the call*/
+            for (frame = frame_count; frame > 0; frame--)
+            {
+                uintptr_t address = buffer[index + frame];
+                append_frame_name(line, PROFILER_MAX_FRAMES * PROFILER_MAX_FRAME_NAME, (const void*)((frame == 1) ? address : (address - 1)));
+            }
+
+            lines[line_count] = malloc(strlen(line) + 1);
+            if (lines[line_count] == NULL)
+            {
+                LogError("failure in malloc(%zu)", strlen(line) + 1);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                (void)strcpy(lines[line_count], line);
+                line_count++;
+                index += frame_count + 1;
+            }
+        }
+
+        if (result == 0)
+        {
+            qsort(lines, line_count, sizeof(char*), compare_lines);
+
+            folded_file = fopen(folded_path, "w");
+            if (folded_file == NULL)
+            {
+                LogError("failure in fopen(%s, \"w\"), errno=%d", folded_path, errno);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                size_t i = 0;
+                while (i < line_count)
+                {
+                    size_t same_count = 1;
+                    while ((i + same_count < line_count) && (strcmp(lines[i], lines[i + same_count]) == 0))
+                    {
+                        same_count++;
+                    }
+                    (void)fprintf(folded_file, "%s %zu\n", lines[i], same_count);
+                    i += same_count;
+                }
+
+                if (fclose(folded_file) != 0)
+                {
+                    LogError("failure writing %s, errno=%d", folded_path, errno);
+                    result = MU_FAILURE;
+                }
+            }
+        }
+
+        while (line_count > 0)
+        {
+            line_count--;
+            free(lines[line_count]);
+        }
+    }
+
+    free(line);
+    free(lines);
+
+    return result;
+}
+
+int ctrs_profiler_stop(const char* folded_path, size_t* sample_count)
+{
+    int result;
+    size_t count = 0;
+
+    if (g_profile.buffer == NULL)
+    {
+        LogError("no profile is running");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t used;
+        size_t index = 0;
+
+        (void)set_timer(0);
+        __atomic_store_n(&g_profile.sampling, 0, __ATOMIC_SEQ_CST);
+        /*a handler that checked sampling before it was cleared is still writing its sample*/
+        while (__atomic_load_n(&g_profile.handlers_running, __ATOMIC_SEQ_CST) != 0)
+        {
+            (void)sched_yield();
+        }
+
+        used = (g_profile.used < PROFILER_BUFFER_SIZE) ? g_profile.used : PROFILER_BUFFER_SIZE;
+        while ((index < used) && (g_profile.buffer[index] != 0) && (index + g_profile.buffer[index] + 1 <= used))
+        {
+            index += g_profile.buffer[index] + 1;
+            count++;
+        }
+
+        if (g_profile.dropped_count != 0)
+        {
+            LogWarning("the profile kept %zu samples, %zu did not fit in its buffer", count, g_profile.dropped_count);
+        }
+
+        result = (folded_path == NULL) ? 0 : write_folded(folded_path, g_profile.buffer, count);
+
+        free(g_profile.buffer);
+        g_profile.buffer = NULL;
+    }
+
+    if (sample_count != NULL)
+    {
+        *sample_count = count;
+    }
+
+    return result;
+}
+#endif
@@ -0,0 +1,425 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/stat.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_test_result.h"
+
+#include "ctrs_report.h"
+
+/*name of the pseudo test that carries the failures which do not belong to a test (suite fixtures, runner errors)*/
+#define CTRS_REPORT_SUITE_FIXTURES_NAME "suite_fixtures"
+
+#define CTRS_REPORT_FORMAT_JUNIT "junit"
+#define CTRS_REPORT_FORMAT_JSON "json"
+
+static bool is_directory(const char* path)
+{
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path);
+    return (attributes != INVALID_FILE_ATTRIBUTES) && ((attributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+#else
+    struct stat path_stat;
+    return (stat(path, &path_stat) == 0) && S_ISDIR(path_stat.st_mode);
+#endif
+}
+
+static bool ends_with(const char* text, const char* suffix)
+{
+    size_t text_length = strlen(text);
+    size_t suffix_length = strlen(suffix);
+    return (text_length >= suffix_length) && (strcmp(text + text_length - suffix_length, suffix) == 0);
+}
+
+/*the extension of the file name of path, "" when it has none*/
+static const char* get_extension(const char* path)
+{
+    const char* file_name = path;
+    const char* extension;
+    const char* current;
+
+    for (current = path; *current != '\0'; current++)
+    {
+        if ((*current == '/') || (*current == '\\'))
+        {
+            file_name = current + 1;
+        }
+    }
+
+    extension = strrchr(file_name, '.');
+    return ((extension == NULL) || (extension == file_name)) ? (path + strlen(path)) : extension;
+}
+
+static const char* test_status(CTRS_TEST_OUTCOME outcome)
+{
+    const char* result;
+    switch (outcome)
+    {
+        default:
+        case CTRS_TEST_OUTCOME_NOT_EXECUTED:
+            /*the test did not complete (crashed worker, failed suite initialize), that is an error rather than a failure in JUnit terms*/
+            result = "error";
+            break;
+        case CTRS_TEST_OUTCOME_PASSED:
+            result = "passed";
+            break;
+        case CTRS_TEST_OUTCOME_FAILED:
+            result = "failed";
+            break;
+    }
+    return result;
+}
+
+static double ns_to_seconds(uint64_t ns)
+{
+    return (double)ns / 1000000000.0;
+}
+
+static void write_xml_escaped(FILE* file, const char* text)
+{
+    const char* current;
+    for (current = text; *current != '\0'; current++)
+    {
+        switch (*current)
+        {
+            default:
+                (void)fputc(*current, file);
+                break;
+            case '&':
+                (void)fputs("&amp;", file);
+                break;
+            case '<':
+                (void)fputs("&lt;", file);
+                break;
+            case '>':
+                (void)fputs("&gt;", file);
+                break;
+            case '"':
+                (void)fputs("&quot;", file);
+                break;
+            case '\'':
+                (void)fputs("&apos;", file);
+                break;
+        }
+    }
+}
+
+static void write_json_string(FILE* file, const char* text)
+{
+    const char* current;
+    (void)fputc('"', file);
+    for (current = text; *current != '\0'; current++)
+    {
+        unsigned char c = (unsigned char)*current;
+        if ((c == '"') || (c == '\\'))
+        {
+            (void)fputc('\\', file);
+            (void)fputc(c, file);
+        }
+        else if (c < 0x20)
+        {
+            (void)fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            (void)fputc(c, file);
+        }
+    }
+    (void)fputc('"', file);
+}
+
+static void write_junit_metrics(FILE* file, const CTRS_TEST_METRICS* metrics)
+{
+    size_t counter;
+
+    (void)fprintf(file, "      <properties>\n");
+    (void)fprintf(file, "        <property name=\"cpu_time\" value=\"%.6f\"/>\n", ns_to_seconds(metrics->cpu_time_ns));
+    (void)fprintf(file, "        <property name=\"peak_rss_delta_kb\" value=\"%" PRId64 "\"/>\n", metrics->peak_rss_delta_kb);
+    (void)fprintf(file, "        <property name=\"voluntary_context_switches\" value=\"%" PRIu64 "\"/>\n", metrics->voluntary_context_switches);
+    (void)fprintf(file, "        <property name=\"involuntary_context_switches\" value=\"%" PRIu64 "\"/>\n", metrics->involuntary_context_switches);
+    if (metrics->allocations_counted)
+    {
+        (void)fprintf(file, "        <property name=\"allocations\" value=\"%" PRIu64 "\"/>\n", metrics->allocation_count);
+        (void)fprintf(file, "        <property name=\"frees\" value=\"%" PRIu64 "\"/>\n", metrics->free_count);
+        (void)fprintf(file, "        <property name=\"allocated_bytes\" value=\"%" PRIu64 "\"/>\n", metrics->allocated_bytes);
+    }
+    for (counter = 0; counter < CTRS_PERF_COUNTER_COUNT; counter++)
+    {
+        if (metrics->perf_counts.counted[counter])
+        {
+            (void)fprintf(file, "        <property name=\"%s\" value=\"%" PRIu64 "\"/>\n", ctrs_perf_counter_name((CTRS_PERF_COUNTER)counter), metrics->perf_counts.values[counter]);
+        }
+    }
+    (void)fprintf(file, "      </properties>\n");
+}
+
+static void write_junit(FILE* file, const CTRS_REPORT_SUITE* suite)
+{
+    size_t i;
+    size_t failure_count = 0;
+    size_t error_count = (suite->run_failures != 0) ? 1 : 0;
+    uint64_t total_time_ns = 0;
+
+    for (i = 0; i < suite->test_count; i++)
+    {
+        if (suite->test_results[i].outcome == CTRS_TEST_OUTCOME_FAILED)
+        {
+            failure_count++;
+        }
+        else if (suite->test_results[i].outcome == CTRS_TEST_OUTCOME_NOT_EXECUTED)
+        {
+            error_count++;
+        }
+        else
+        {
+            /*passed*/
+        }
+        total_time_ns += suite->test_results[i].metrics.wall_time_ns;
+    }
+
+    (void)fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    (void)fprintf(file, "<testsuites>\n");
+    (void)fprintf(file, "  <testsuite name=\"");
+    write_xml_escaped(file, suite->name);
+    (void)fprintf(file, "\" tests=\"%zu\" failures=\"%zu\" errors=\"%zu\" time=\"%.6f\">\n",
+        suite->test_count + ((suite->run_failures != 0) ? 1 : 0), failure_count, error_count, ns_to_seconds(total_time_ns));
+
+    for (i = 0; i < suite->test_count; i++)
+    {
+        const CTRS_TEST_RESULT* test_result = &suite->test_results[i];
+
+        (void)fprintf(file, "    <testcase classname=\"");
+        write_xml_escaped(file, suite->name);
+        (void)fprintf(file, "\" name=\"");
+        write_xml_escaped(file, suite->test_names[i]);
+        (void)fprintf(file, "\" time=\"%.6f\">\n", ns_to_seconds(test_result->metrics.wall_time_ns));
+
+        write_junit_metrics(file, &test_result->metrics);
+
+        if (test_result->outcome == CTRS_TEST_OUTCOME_FAILED)
+        {
+            (void)fprintf(file, "      <failure message=\"test failed, see the test output\"/>\n");
+        }
+        else if (test_result->outcome == CTRS_TEST_OUTCOME_NOT_EXECUTED)
+        {
+            (void)fprintf(file, "      <error message=\"test did not complete (not executed or its worker process died)\"/>\n");
+        }
+        else
+        {
+            /*passed*/
+        }
+        (void)fprintf(file, "    </testcase>\n");
+    }
+
+    if (suite->run_failures != 0)
+    {
+        (void)fprintf(file, "    <testcase classname=\"");
+        write_xml_escaped(file, suite->name);
+        (void)fprintf(file, "\" name=\"" CTRS_REPORT_SUITE_FIXTURES_NAME "\" time=\"0\">\n");
+        (void)fprintf(file, "      <error message=\"%zu failure(s) outside of tests (suite fixtures, runner errors)\"/>\n", suite->run_failures);
+        (void)fprintf(file, "    </testcase>\n");
+    }
+
+    (void)fprintf(file, "  </testsuite>\n");
+    (void)fprintf(file, "</testsuites>\n");
+}
+
+static void write_json_lines(FILE* file, const CTRS_REPORT_SUITE* suite)
+{
+    size_t i;
+
+    /*one object per line, so that reports of several suites and shards can simply be concatenated*/
+    for (i = 0; i < suite->test_count; i++)
+    {
+        const CTRS_TEST_RESULT* test_result = &suite->test_results[i];
+        size_t counter;
+
+        (void)fprintf(file, "{\"suite\":");
+        write_json_string(file, suite->name);
+        (void)fprintf(file, ",\"test\":");
+        write_json_string(file, suite->test_names[i]);
+        (void)fprintf(file, ",\"status\":\"%s\",\"wall_time_ns\":%" PRIu64 ",\"cpu_time_ns\":%" PRIu64 ",\"peak_rss_delta_kb\":%" PRId64
+            ",\"voluntary_context_switches\":%" PRIu64 ",\"involuntary_context_switches\":%" PRIu64,
+            test_status(test_result->outcome),
+            test_result->metrics.wall_time_ns,
+            test_result->metrics.cpu_time_ns,
+            test_result->metrics.peak_rss_delta_kb,
+            test_result->metrics.voluntary_context_switches,
+            test_result->metrics.involuntary_context_switches);
+        if (test_result->metrics.allocations_counted)
+        {
+            (void)fprintf(file, ",\"allocations\":%" PRIu64 ",\"frees\":%" PRIu64 ",\"allocated_bytes\":%" PRIu64,
+                test_result->metrics.allocation_count,
+                test_result->metrics.free_count,
+                test_result->metrics.allocated_bytes);
+        }
+        for (counter = 0; counter < CTRS_PERF_COUNTER_COUNT; counter++)
+        {
+            if (test_result->metrics.perf_counts.counted[counter])
+            {
+                (void)fprintf(file, ",\"%s\":%" PRIu64, ctrs_perf_counter_name((CTRS_PERF_COUNTER)counter), test_result->metrics.perf_counts.values[counter]);
+            }
+        }
+        (void)fprintf(file, "}\n");
+    }
+
+    if (suite->run_failures != 0)
+    {
+        (void)fprintf(file, "{\"suite\":");
+        write_json_string(file, suite->name);
+        (void)fprintf(file, ",\"test\":\"" CTRS_REPORT_SUITE_FIXTURES_NAME "\",\"status\":\"error\",\"run_failures\":%zu}\n", suite->run_failures);
+    }
+}
+
+int ctrs_report_validate_format(const char* report_format)
+{
+    int result;
+
+    if (
+        (report_format == NULL) ||
+        (strcmp(report_format, CTRS_REPORT_FORMAT_JUNIT) == 0) ||
+        (strcmp(report_format, CTRS_REPORT_FORMAT_JSON) == 0)
+        )
+    {
+        result = 0;
+    }
+    else
+    {
+        LogError("unknown report format %s, expected " CTRS_REPORT_FORMAT_JUNIT " or " CTRS_REPORT_FORMAT_JSON, report_format);
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+int ctrs_report_write(const char* report_path, const char* report_format, const CTRS_REPORT_SUITE* suite)
+{
+    int result;
+
+    if (
+        (report_path == NULL) ||
+        (suite == NULL) ||
+        (suite->name == NULL) ||
+        ((suite->test_count > 0) && ((suite->test_names == NULL) || (suite->test_results == NULL))) ||
+        (ctrs_report_validate_format(report_format) != 0)
+        )
+    {
+        LogError("Invalid arguments const char* report_path=%s, const char* report_format=%s, const CTRS_REPORT_SUITE* suite=%p",
+            MU_P_OR_NULL(report_path), MU_P_OR_NULL(report_format), (void*)suite);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        bool write_as_junit;
+        char* file_name;
+        bool path_is_directory = is_directory(report_path);
+
+        if (report_format != NULL)
+        {
+            write_as_junit = (strcmp(report_format, CTRS_REPORT_FORMAT_JUNIT) == 0);
+        }
+        else
+        {
+            /*a directory gets JSON lines, a file follows its extension*/
+            write_as_junit = !path_is_directory && ends_with(report_path, ".xml");
+        }
+
+        if (!path_is_directory)
+        {
+            /*file_shard_I_of_N.ext, so that the shards given the same file do not overwrite each other*/
+            size_t file_name_size = strlen(report_path) + sizeof("_shard_18446744073709551615_of_18446744073709551615");
+            file_name = malloc(file_name_size);
+            if (file_name != NULL)
+            {
+                if (suite->shard_count > 1)
+                {
+                    const char* extension = get_extension(report_path);
+                    (void)snprintf(file_name, file_name_size, "%.*s_shard_%zu_of_%zu%s", (int)(extension - report_path), report_path, suite->shard_index, suite->shard_count, extension);
+                }
+                else
+                {
+                    (void)strcpy(file_name, report_path);
+                }
+            }
+        }
+        else
+        {
+            /*path/suite[_shard_I_of_N].ext, so that shards and suites writing to the same directory do not overwrite each other*/
+            size_t file_name_size = strlen(report_path) + 1 + strlen(suite->name) + sizeof("_shard_18446744073709551615_of_18446744073709551615.jsonl");
+            file_name = malloc(file_name_size);
+            if (file_name != NULL)
+            {
+                if (suite->shard_count > 1)
+                {
+                    (void)snprintf(file_name, file_name_size, "%s/%s_shard_%zu_of_%zu.%s", report_path, suite->name, suite->shard_index, suite->shard_count, write_as_junit ? "xml" : "jsonl");
+                }
+                else
+                {
+                    (void)snprintf(file_name, file_name_size, "%s/%s.%s", report_path, suite->name, write_as_junit ? "xml" : "jsonl");
+                }
+            }
+        }
+
+        if (file_name == NULL)
+        {
+            LogError("failure allocating the report file name for %s", report_path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            FILE* file = fopen(file_name, "w");
+            if (file == NULL)
+            {
+                LogError("failure in fopen(%s, \"w\")", file_name);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                if (write_as_junit)
+                {
+                    write_junit(file, suite);
+                }
+                else
+                {
+                    write_json_lines(file, suite);
+                }
+
+                if (ferror(file) != 0)
+                {
+                    LogError("failure writing the report to %s", file_name);
+                    (void)fclose(file);
+                    result = MU_FAILURE;
+                }
+                else if (fclose(file) != 0)
+                {
+                    LogError("failure in fclose for %s", file_name);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    LogInfo("%s: report written to %s", suite->name, file_name);
+                    result = 0;
+                }
+            }
+
+            free(file_name);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "testmutex.h"
+
+#include "ctrs_resource_lock.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(CTRS_RESOURCE_LOCK_SCOPE, CTRS_RESOURCE_LOCK_SCOPE_VALUES)
+
+/*more tags than this on one test (or suite) is a sign that the tags are too fine grained*/
+#define CTRS_RESOURCE_LOCK_MAX_HELD 32
+
+/*keeps resource locks apart from the mutexes named by TESTMUTEX_NAME_ENV*/
+#define CTRS_RESOURCE_LOCK_NAME_PREFIX "resource_"
+
+typedef struct CTRS_RESOURCE_LOCKS_HELD_TAG
+{
+    TEST_MUTEX_HANDLE mutexes[CTRS_RESOURCE_LOCK_MAX_HELD];
+    size_t count;
+} CTRS_RESOURCE_LOCKS_HELD;
+
+#ifdef _MSC_VER
+#define CTRS_THREAD_LOCAL __declspec(thread)
+#else
+#define CTRS_THREAD_LOCAL __thread
+#endif
+
+/*
+The locks held are tracked in acquisition order. Those of a test are tracked per thread: a test and its fixtures run on one thread, and
+cppunittest can run the tagged tests of a process on several threads at once (see RESOURCE_LOCKED_TEST_FUNCTION).
+*/
+static CTRS_RESOURCE_LOCKS_HELD g_suite_locks_held;
+static CTRS_THREAD_LOCAL CTRS_RESOURCE_LOCKS_HELD g_test_locks_held;
+
+/*the RESOURCE_LOCKED_TEST_FUNCTIONs of the suite, registered before main*/
+static CTRS_TEST_RESOURCE_LOCKS* g_registered_test_locks;
+
+static CTRS_RESOURCE_LOCKS_HELD* get_locks_held(CTRS_RESOURCE_LOCK_SCOPE scope)
+{
+    return (scope == CTRS_RESOURCE_LOCK_SCOPE_TEST) ? &g_test_locks_held : &g_suite_locks_held;
+}
+
+static int compare_tags(const void* left, const void* right)
+{
+    return strcmp(*(const char* const*)left, *(const char* const*)right);
+}
+
+static void release_held(CTRS_RESOURCE_LOCKS_HELD* held, size_t keep_count)
+{
+    /*reverse order of acquisition*/
+    while (held->count > keep_count)
+    {
+        held->count--;
+        (void)testmutex_release(held->mutexes[held->count]);
+        testmutex_destroy(held->mutexes[held->count]);
+        held->mutexes[held->count] = NULL;
+    }
+}
+
+static int acquire_tag(CTRS_RESOURCE_LOCKS_HELD* held, const char* tag)
+{
+    int result;
+    char name[256];
+    int written = snprintf(name, sizeof(name), CTRS_RESOURCE_LOCK_NAME_PREFIX "%s", tag);
+
+    if ((written < 0) || ((size_t)written >= sizeof(name)))
+    {
+        LogError("resource lock tag %s is too long", tag);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        TEST_MUTEX_HANDLE mutex = testmutex_create_named(name);
+        if (mutex == NULL)
+        {
+            LogError("failure in testmutex_create_named(%s)", name);
+            result = MU_FAILURE;
+        }
+        else if (testmutex_acquire(mutex) != 0)
+        {
+            LogError("failure in testmutex_acquire for resource lock %s", tag);
+            testmutex_destroy(mutex);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            held->mutexes[held->count] = mutex;
+            held->count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE scope, const char* const* tags, size_t tag_count)
+{
+    int result;
+    size_t i;
+
+    if (
+        ((scope != CTRS_RESOURCE_LOCK_SCOPE_TEST) && (scope != CTRS_RESOURCE_LOCK_SCOPE_SUITE)) ||
+        (tags == NULL) ||
+        (tag_count == 0) ||
+        (tag_count > CTRS_RESOURCE_LOCK_MAX_HELD)
+        )
+    {
+        LogError("Invalid arguments CTRS_RESOURCE_LOCK_SCOPE scope=%" PRI_MU_ENUM ", const char* const* tags=%p, size_t tag_count=%zu",
+            MU_ENUM_VALUE(CTRS_RESOURCE_LOCK_SCOPE, scope), (void*)tags, tag_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        for (i = 0; i < tag_count; i++)
+        {
+            if ((tags[i] == NULL) || (tags[i][0] == '\0'))
+            {
+                break;
+            }
+        }
+
+        if (i < tag_count)
+        {
+            LogError("Invalid arguments: tag %zu is NULL or empty", i);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            CTRS_RESOURCE_LOCKS_HELD* held = get_locks_held(scope);
+            const char* sorted_tags[CTRS_RESOURCE_LOCK_MAX_HELD];
+
+            if (scope == CTRS_RESOURCE_LOCK_SCOPE_TEST)
+            {
+                /*a previous test that failed an assertion did not get to release its locks*/
+                release_held(held, 0);
+            }
+
+            if (held->count + tag_count > CTRS_RESOURCE_LOCK_MAX_HELD)
+            {
+                LogError("cannot hold more than %d resource locks in scope %" PRI_MU_ENUM, CTRS_RESOURCE_LOCK_MAX_HELD, MU_ENUM_VALUE(CTRS_RESOURCE_LOCK_SCOPE, scope));
+                result = MU_FAILURE;
+            }
+            else
+            {
+                size_t count_before = held->count;
+
+                (void)memcpy((void*)sorted_tags, tags, tag_count * sizeof(const char*));
+                qsort((void*)sorted_tags, tag_count, sizeof(const char*), compare_tags);
+
+                result = 0;
+                for (i = 0; (i < tag_count) && (result == 0); i++)
+                {
+                    if ((i > 0) && (strcmp(sorted_tags[i - 1], sorted_tags[i]) == 0))
+                    {
+                        /*duplicate tag, already held*/
+                    }
+                    else
+                    {
+                        result = acquire_tag(held, sorted_tags[i]);
+                    }
+                }
+
+                if (result != 0)
+                {
+                    /*all or nothing*/
+                    release_held(held, count_before);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE scope)
+{
+    if ((scope != CTRS_RESOURCE_LOCK_SCOPE_TEST) && (scope != CTRS_RESOURCE_LOCK_SCOPE_SUITE))
+    {
+        LogError("Invalid arguments CTRS_RESOURCE_LOCK_SCOPE scope=%" PRI_MU_ENUM, MU_ENUM_VALUE(CTRS_RESOURCE_LOCK_SCOPE, scope));
+    }
+    else
+    {
+        release_held(get_locks_held(scope), 0);
+    }
+}
+
+void ctrs_resource_lock_register_test_locks(CTRS_TEST_RESOURCE_LOCKS* test_locks)
+{
+    if (test_locks == NULL)
+    {
+        LogError("Invalid arguments CTRS_TEST_RESOURCE_LOCKS* test_locks=%p", (void*)test_locks);
+    }
+    else
+    {
+        test_locks->next_registered = g_registered_test_locks;
+        g_registered_test_locks = test_locks;
+    }
+}
+
+const CTRS_TEST_RESOURCE_LOCKS* ctrs_resource_lock_get_test_locks(const char* test_name)
+{
+    const CTRS_TEST_RESOURCE_LOCKS* result = NULL;
+
+    if (test_name == NULL)
+    {
+        LogError("Invalid arguments const char* test_name=%s", MU_P_OR_NULL(test_name));
+    }
+    else
+    {
+        const CTRS_TEST_RESOURCE_LOCKS* current;
+        for (current = g_registered_test_locks; current != NULL; current = current->next_registered)
+        {
+            if (strcmp(current->test_name, test_name) == 0)
+            {
+                result = current;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,1806 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <setjmp.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctest.h"
+
+#include "ctrs_sprintf.h"
+#include "ctrs_test_result.h"
+#include "ctrs_report.h"
+#include "ctrs_resource_lock.h"
+#include "ctrs_data_table.h"
+#include "ctrs_watchdog.h"
+#include "ctrs_perf_counters.h"
+#include "ctrs_profiler.h"
+#include "ctrs_duration_history.h"
+
+#include "ctrs_runner.h"
+
+/*test_index used in a result record to report a failure of the suite fixtures rather than of a test*/
+#define CTRS_SUITE_FIXTURE_INDEX SIZE_MAX
+
+/*the duration history of a suite when --duration-history is not given: <suite>.durations in the current directory*/
+#define CTRS_DURATION_HISTORY_DEFAULT_EXTENSION ".durations"
+
+/*one test the runner runs: a TEST_FUNCTION, or one row of a table test (see ctrs_data_table.h)*/
+typedef struct CTRS_SUITE_TEST_TAG
+{
+    const TEST_FUNCTION_DATA* test_function;
+    const char* name;
+    CTRS_DATA_TABLE* data_table; /*NULL when test_function is not a table test, or its rows could not be loaded (running it then fails)*/
+    size_t row_index;
+} CTRS_SUITE_TEST;
+
+/*the view of the suite the runner works with, built by walking the list produced by BEGIN_TEST_SUITE/END_TEST_SUITE*/
+typedef struct CTRS_TEST_SUITE_TAG
+{
+    const char* name;
+    const TEST_FUNCTION_DATA* suite_initialize;
+    const TEST_FUNCTION_DATA* suite_cleanup;
+    const TEST_FUNCTION_DATA* function_initialize;
+    const TEST_FUNCTION_DATA* function_cleanup;
+    CTRS_SUITE_TEST* tests;
+    size_t test_count;
+    size_t fork_batch_size; /*0 = the tests run in the process that ran the suite initialize, otherwise in children forked from it, fork_batch_size tests per child (SIZE_MAX = all)*/
+    double test_timeout_seconds; /*deadline of the tests without a TEST_FUNCTION_TIMEOUT, 0 = none*/
+    const char* profile_directory; /*NULL = the tests are not profiled*/
+    uint32_t profile_frequency_hz;
+} CTRS_TEST_SUITE;
+
+typedef struct CTRS_TEST_RESULT_RECORD_TAG
+{
+    size_t test_index;
+    CTRS_TEST_RESULT result;
+} CTRS_TEST_RESULT_RECORD;
+
+typedef void(*ON_TEST_RESULT)(void* context, const CTRS_TEST_RESULT_RECORD* record);
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("usage: %s [test_name...] [options]\n", program_name);
+    (void)printf("    test_name        run only the tests with this name, same as --filter\n");
+    (void)printf("    --filter P       run only the tests matching one of the patterns P, a glob ('*', '?') or a regular expression (re:...)\n");
+    (void)printf("    --exclude P      do not run the tests matching the pattern P\n");
+    (void)printf("    --filter-file F  add the patterns of the file F, one per line ('-' prefix = exclude, '#' = comment)\n");
+    (void)printf("    --list           print the names of the selected tests and exit without running them\n");
+    (void)printf("    --list-properties\n");
+    (void)printf("                     same as --list with \"name<TAB>timeout<TAB>locks<TAB>cost\" per test: the seconds of its TEST_FUNCTION_TIMEOUT\n");
+    (void)printf("                     (0 = none), the tags of its RESOURCE_LOCKED_TEST_FUNCTION (comma separated) and the seconds it took in\n");
+    (void)printf("                     the --duration-history (0 = unknown)\n");
+    (void)printf("    --jobs N         spread the tests across N worker processes (0 = number of processors, default 1 = serial)\n");
+    (void)printf("    --fork           run the suite initialize once, then every test in a child process forked from it\n");
+    (void)printf("    --fork-batch N   same as --fork with N tests per child process\n");
+    (void)printf("    --timeout S      fail a test still running after S seconds, after logging the backtraces of all threads (also " CTRS_TEST_TIMEOUT_ENV ")\n");
+    (void)printf("    --shard I/N      run only the I-th (0 based) of N equal parts of the tests (also " CTRS_RUNNER_SHARD_INDEX_ENV "/" CTRS_RUNNER_SHARD_COUNT_ENV ")\n");
+    (void)printf("    --duration-history FILE\n");
+    (void)printf("                     per test durations of the past runs, --jobs and --shard split the tests by them longest first,\n");
+    (void)printf("                     default <suite>" CTRS_DURATION_HISTORY_DEFAULT_EXTENSION " with --jobs and no --shard, " CTRS_DURATION_HISTORY_OFF " = none (also " CTRS_DURATION_HISTORY_ENV ")\n");
+    (void)printf("    --report PATH    write the results and per test metrics to the file or existing directory PATH (also " CTRS_REPORT_FILE_ENV ")\n");
+    (void)printf("    --report-format junit|json\n");
+    (void)printf("                     format of the report, default: junit for a .xml file, JSON lines otherwise (also " CTRS_REPORT_FORMAT_ENV ")\n");
+    (void)printf("    --profile DIR    sample the stacks of every test and write them as DIR/<suite>.<test>.folded for flame graphs (also " CTRS_PROFILE_DIR_ENV ")\n");
+    (void)printf("    --profile-frequency HZ\n");
+    (void)printf("                     samples per second of CPU time, default %d (also " CTRS_PROFILE_FREQUENCY_ENV ")\n", CTRS_PROFILER_DEFAULT_FREQUENCY_HZ);
+}
+
+static int parse_size_t(const char* text, size_t* value)
+{
+    int result;
+    char* end;
+
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if ((text[0] == '\0') || (text[0] == '-') || (*end != '\0') || (errno != 0) || (parsed > SIZE_MAX))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *value = (size_t)parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+/*a number of seconds, 0 included*/
+static int parse_seconds(const char* text, double* value)
+{
+    int result;
+    char* end;
+
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if ((text[0] == '\0') || (*end != '\0') || (errno != 0) || !(parsed >= 0) || (parsed > 1e9))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *value = parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+/*samples per second, 1 to 1000000*/
+static int parse_frequency(const char* text, uint32_t* value)
+{
+    int result;
+    size_t parsed;
+
+    if ((parse_size_t(text, &parsed) != 0) || (parsed == 0) || (parsed > 1000000))
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *value = (uint32_t)parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_shard(const char* text, size_t* shard_index, size_t* shard_count)
+{
+    int result;
+    const char* separator = strchr(text, '/');
+
+    if (separator == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        char index_text[32];
+        size_t index_length = (size_t)(separator - text);
+
+        if (index_length >= sizeof(index_text))
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)memcpy(index_text, text, index_length);
+            index_text[index_length] = '\0';
+
+            if (
+                (parse_size_t(index_text, shard_index) != 0) ||
+                (parse_size_t(separator + 1, shard_count) != 0)
+                )
+            {
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*returns true when argv[*index] is the option name (as "name value" or "name=value"), *value is set to NULL when the value is missing*/
+static bool is_option_with_value(int argc, char* argv[], int* index, const char* name, const char** value)
+{
+    bool result;
+    const char* argument = argv[*index];
+    size_t name_length = strlen(name);
+
+    if (strncmp(argument, name, name_length) != 0)
+    {
+        result = false;
+    }
+    else if (argument[name_length] == '=')
+    {
+        *value = argument + name_length + 1;
+        result = true;
+    }
+    else if (argument[name_length] == '\0')
+    {
+        if (*index + 1 < argc)
+        {
+            (*index)++;
+            *value = argv[*index];
+        }
+        else
+        {
+            LogError("%s needs a value", name);
+            *value = NULL;
+        }
+        result = true;
+    }
+    else
+    {
+        result = false;
+    }
+
+    return result;
+}
+
+static int read_shard_from_environment(CTRS_RUNNER_OPTIONS* options)
+{
+    int result;
+    const char* shard_index = getenv(CTRS_RUNNER_SHARD_INDEX_ENV);
+    const char* shard_count = getenv(CTRS_RUNNER_SHARD_COUNT_ENV);
+
+    if ((shard_index == NULL) && (shard_count == NULL))
+    {
+        result = 0;
+    }
+    else if (
+        (shard_index == NULL) ||
+        (shard_count == NULL) ||
+        (parse_size_t(shard_index, &options->shard_index) != 0) ||
+        (parse_size_t(shard_count, &options->shard_count) != 0)
+        )
+    {
+        LogError("invalid shard in the environment: " CTRS_RUNNER_SHARD_INDEX_ENV "=%s, " CTRS_RUNNER_SHARD_COUNT_ENV "=%s",
+            MU_P_OR_NULL(shard_index), MU_P_OR_NULL(shard_count));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/*adds pattern to the test filter of options, creating the filter on first use*/
+static int add_test_filter_pattern(CTRS_RUNNER_OPTIONS* options, const char* pattern, bool exclude, bool is_file)
+{
+    int result;
+
+    if ((options->test_filter == NULL) && ((options->test_filter = ctrs_test_filter_create()) == NULL))
+    {
+        LogError("failure in ctrs_test_filter_create");
+        result = MU_FAILURE;
+    }
+    else if (is_file)
+    {
+        result = ctrs_test_filter_add_from_file(options->test_filter, pattern);
+    }
+    else
+    {
+        result = ctrs_test_filter_add(options->test_filter, pattern, exclude);
+    }
+
+    return result;
+}
+
+int ctrs_runner_parse_command_line(int argc, char* argv[], CTRS_RUNNER_OPTIONS* options)
+{
+    int result;
+
+    if (
+        (argc < 0) ||
+        ((argc > 0) && (argv == NULL)) ||
+        (options == NULL)
+        )
+    {
+        LogError("Invalid arguments int argc=%d, char* argv[]=%p, CTRS_RUNNER_OPTIONS* options=%p",
+            argc, (void*)argv, (void*)options);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        int i;
+        const char* program_name = (argc > 0) ? argv[0] : "test";
+        bool shard_given = false;
+        bool timeout_given = false;
+
+        options->test_filter = NULL;
+        options->test_name_filter = NULL;
+        options->list_tests = false;
+        options->list_test_properties = false;
+        options->jobs = 1;
+        options->fork_batch_size = 0;
+        options->test_timeout_seconds = 0;
+        options->shard_index = 0;
+        options->shard_count = 1;
+        options->report_path = NULL;
+        options->report_format = NULL;
+        options->profile_directory = NULL;
+        options->profile_frequency_hz = 0;
+        options->duration_history_path = NULL;
+
+        result = 0;
+        for (i = 1; (i < argc) && (result == 0); i++)
+        {
+            const char* argument = argv[i];
+            const char* value;
+
+            if ((strcmp(argument, "--help") == 0) || (strcmp(argument, "-h") == 0))
+            {
+                print_usage(program_name);
+                result = MU_FAILURE;
+            }
+            else if (
+                is_option_with_value(argc, argv, &i, "--jobs", &value) ||
+                is_option_with_value(argc, argv, &i, "-j", &value)
+                )
+            {
+                if ((value == NULL) || (parse_size_t(value, &options->jobs) != 0))
+                {
+                    LogError("invalid value for %s: %s", argument, MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--fork-batch", &value))
+            {
+                if ((value == NULL) || (parse_size_t(value, &options->fork_batch_size) != 0) || (options->fork_batch_size == 0))
+                {
+                    LogError("invalid value for --fork-batch: %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+            }
+            else if (strcmp(argument, "--fork") == 0)
+            {
+                if (options->fork_batch_size == 0)
+                {
+                    options->fork_batch_size = 1;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--timeout", &value))
+            {
+                if ((value == NULL) || (parse_seconds(value, &options->test_timeout_seconds) != 0))
+                {
+                    LogError("invalid value for --timeout (expected seconds): %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    timeout_given = true;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--shard", &value))
+            {
+                if ((value == NULL) || (parse_shard(value, &options->shard_index, &options->shard_count) != 0))
+                {
+                    LogError("invalid value for --shard (expected I/N): %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    shard_given = true;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--report-format", &value))
+            {
+                if ((value == NULL) || (ctrs_report_validate_format(value) != 0))
+                {
+                    LogError("invalid value for --report-format: %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    options->report_format = value;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--profile-frequency", &value))
+            {
+                if ((value == NULL) || (parse_frequency(value, &options->profile_frequency_hz) != 0))
+                {
+                    LogError("invalid value for --profile-frequency (expected 1 to 1000000 samples per second): %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--profile", &value))
+            {
+                if ((value == NULL) || (value[0] == '\0'))
+                {
+                    LogError("invalid value for --profile: %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    options->profile_directory = value;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--duration-history", &value))
+            {
+                if ((value == NULL) || (value[0] == '\0'))
+                {
+                    LogError("invalid value for --duration-history: %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    options->duration_history_path = value;
+                }
+            }
+            else if (is_option_with_value(argc, argv, &i, "--report", &value))
+            {
+                if ((value == NULL) || (value[0] == '\0'))
+                {
+                    LogError("invalid value for --report: %s", MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    options->report_path = value;
+                }
+            }
+            else if (strcmp(argument, "--list") == 0)
+            {
+                options->list_tests = true;
+            }
+            else if (strcmp(argument, "--list-properties") == 0)
+            {
+                options->list_tests = true;
+                options->list_test_properties = true;
+            }
+            else if (
+                is_option_with_value(argc, argv, &i, "--filter-file", &value) ||
+                is_option_with_value(argc, argv, &i, "--filter", &value) ||
+                is_option_with_value(argc, argv, &i, "--exclude", &value)
+                )
+            {
+                if ((value == NULL) || (add_test_filter_pattern(options, value, (strncmp(argument, "--exclude", 9) == 0), (strncmp(argument, "--filter-file", 13) == 0)) != 0))
+                {
+                    LogError("invalid value for %s: %s", argument, MU_P_OR_NULL(value));
+                    result = MU_FAILURE;
+                }
+            }
+            else if (strncmp(argument, "--", 2) == 0)
+            {
+                LogError("unknown option %s", argument);
+                print_usage(program_name);
+                result = MU_FAILURE;
+            }
+            else if (add_test_filter_pattern(options, argument, false, false) != 0)
+            {
+                LogError("invalid test name %s", argument);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                /*a plain argument is a test name, a lone exact name is still run by RUN_TEST_SUITE as the stock main always did*/
+            }
+        }
+
+        if ((result == 0) && (options->test_filter != NULL))
+        {
+            options->test_name_filter = ctrs_test_filter_get_single_name(options->test_filter);
+        }
+
+        if ((result == 0) && !shard_given)
+        {
+            /*the command line wins over the environment*/
+            result = read_shard_from_environment(options);
+        }
+
+        if ((result == 0) && !timeout_given)
+        {
+            const char* test_timeout = getenv(CTRS_TEST_TIMEOUT_ENV);
+            if ((test_timeout != NULL) && (test_timeout[0] != '\0') && (parse_seconds(test_timeout, &options->test_timeout_seconds) != 0))
+            {
+                LogError("invalid " CTRS_TEST_TIMEOUT_ENV "=%s", test_timeout);
+                result = MU_FAILURE;
+            }
+        }
+
+        if ((result == 0) && (options->report_path == NULL))
+        {
+            const char* report_path = getenv(CTRS_REPORT_FILE_ENV);
+            options->report_path = ((report_path != NULL) && (report_path[0] != '\0')) ? report_path : NULL;
+        }
+
+        if ((result == 0) && (options->report_format == NULL))
+        {
+            const char* report_format = getenv(CTRS_REPORT_FORMAT_ENV);
+            if ((report_format != NULL) && (report_format[0] != '\0'))
+            {
+                if (ctrs_report_validate_format(report_format) != 0)
+                {
+                    LogError("invalid " CTRS_REPORT_FORMAT_ENV "=%s", report_format);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    options->report_format = report_format;
+                }
+            }
+        }
+
+        if ((result == 0) && (options->profile_directory == NULL))
+        {
+            const char* profile_directory = getenv(CTRS_PROFILE_DIR_ENV);
+            options->profile_directory = ((profile_directory != NULL) && (profile_directory[0] != '\0')) ? profile_directory : NULL;
+        }
+
+        if ((result == 0) && (options->profile_frequency_hz == 0))
+        {
+            const char* profile_frequency = getenv(CTRS_PROFILE_FREQUENCY_ENV);
+            if ((profile_frequency == NULL) || (profile_frequency[0] == '\0'))
+            {
+                options->profile_frequency_hz = CTRS_PROFILER_DEFAULT_FREQUENCY_HZ;
+            }
+            else if (parse_frequency(profile_frequency, &options->profile_frequency_hz) != 0)
+            {
+                LogError("invalid " CTRS_PROFILE_FREQUENCY_ENV "=%s", profile_frequency);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                /*the frequency of the environment*/
+            }
+        }
+
+        if ((result == 0) && (options->duration_history_path == NULL))
+        {
+            const char* duration_history_path = getenv(CTRS_DURATION_HISTORY_ENV);
+            options->duration_history_path = ((duration_history_path != NULL) && (duration_history_path[0] != '\0')) ? duration_history_path : NULL;
+        }
+
+        if ((result == 0) && ((options->shard_count == 0) || (options->shard_index >= options->shard_count)))
+        {
+            LogError("invalid shard %zu/%zu, the index must be smaller than the count", options->shard_index, options->shard_count);
+            result = MU_FAILURE;
+        }
+
+        if ((result == 0) && (options->jobs == 0))
+        {
+#ifdef _WIN32
+            options->jobs = 1;
+#else
+            long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+            options->jobs = (processor_count > 0) ? (size_t)processor_count : 1;
+#endif
+        }
+
+#ifdef _WIN32
+        if ((result == 0) && (options->fork_batch_size != 0))
+        {
+            LogWarning("--fork is not supported on this platform, the tests run in the process of the suite fixtures");
+            options->fork_batch_size = 0;
+        }
+
+        if ((result == 0) && (options->test_timeout_seconds != 0))
+        {
+            LogWarning("--timeout is not supported on this platform, the tests run without a deadline");
+            options->test_timeout_seconds = 0;
+        }
+
+        if ((result == 0) && (options->profile_directory != NULL))
+        {
+            LogWarning("--profile is not supported on this platform, the tests run without a profile");
+            options->profile_directory = NULL;
+        }
+#endif
+
+        if (result != 0)
+        {
+            ctrs_runner_options_deinit(options);
+        }
+    }
+
+    return result;
+}
+
+void ctrs_runner_options_deinit(CTRS_RUNNER_OPTIONS* options)
+{
+    if (options == NULL)
+    {
+        LogError("Invalid arguments CTRS_RUNNER_OPTIONS* options=%p", (void*)options);
+    }
+    else
+    {
+        if (options->test_filter != NULL)
+        {
+            ctrs_test_filter_destroy(options->test_filter);
+            options->test_filter = NULL;
+        }
+        options->test_name_filter = NULL;
+    }
+}
+
+bool ctrs_runner_is_stock_run(const CTRS_RUNNER_OPTIONS* options)
+{
+    return (options == NULL) ||
+        (
+            /*a table test row is not a TEST_FUNCTION RUN_TEST_SUITE could find by name*/
+            ((options->test_filter == NULL) || ((options->test_name_filter != NULL) && !ctrs_data_table_any_registered())) &&
+            !options->list_tests &&
+            (options->jobs <= 1) &&
+            (options->fork_batch_size == 0) &&
+            (options->shard_count <= 1) &&
+            (options->test_timeout_seconds == 0) &&
+            !ctrs_watchdog_any_test_timeout_registered() &&
+            /*RUN_TEST_SUITE has no per test metrics, the benchmarks would still log theirs*/
+            !ctrs_perf_counters_are_requested() &&
+            (options->profile_directory == NULL) &&
+            ((options->duration_history_path == NULL) || (strcmp(options->duration_history_path, CTRS_DURATION_HISTORY_OFF) == 0)) &&
+            (options->report_path == NULL)
+        );
+}
+
+/*calls function and turns a failed ctest assertion (which longjmps to g_ExceptionJump) into a non-zero return*/
+static int call_protected(void(*function)(void))
+{
+    int result;
+    jmp_buf saved_exception_jump;
+
+    (void)memcpy(saved_exception_jump, g_ExceptionJump, sizeof(jmp_buf));
+    if (setjmp(g_ExceptionJump) == 0)
+    {
+        function();
+        result = 0;
+    }
+    else
+    {
+        result = MU_FAILURE;
+    }
+    (void)memcpy(g_ExceptionJump, saved_exception_jump, sizeof(jmp_buf));
+
+    return result;
+}
+
+static int call_fixture(const TEST_FUNCTION_DATA* fixture)
+{
+    return (fixture == NULL) ? 0 : call_protected(fixture->TestFunction);
+}
+
+/*appends the test to the suite when the filter selects it*/
+static void add_test_if_selected(CTRS_TEST_SUITE* suite, const CTRS_RUNNER_OPTIONS* options, const TEST_FUNCTION_DATA* test_function, const char* name, CTRS_DATA_TABLE* data_table, size_t row_index)
+{
+    /*the name of a table test selects all its rows*/
+    if (
+        (options->test_filter == NULL) ||
+        ctrs_test_filter_matches(options->test_filter, name) ||
+        ((data_table != NULL) && ctrs_test_filter_matches(options->test_filter, test_function->TestFunctionName))
+        )
+    {
+        CTRS_SUITE_TEST* test = &suite->tests[suite->test_count];
+        test->test_function = test_function;
+        test->name = name;
+        test->data_table = data_table;
+        test->row_index = row_index;
+        suite->test_count++;
+    }
+}
+
+/*returns the expected duration of every test of the suite (the median of the history for a test it does not have), NULL on failure*/
+static double* get_test_costs(const CTRS_TEST_SUITE* suite, CTRS_DURATION_HISTORY_HANDLE duration_history)
+{
+    double* result = malloc(((suite->test_count == 0) ? 1 : suite->test_count) * sizeof(double));
+
+    if (result == NULL)
+    {
+        LogError("failure in malloc(%zu * sizeof(double))", suite->test_count);
+    }
+    else
+    {
+        size_t i;
+        double default_cost = ctrs_duration_history_get_default(duration_history);
+
+        for (i = 0; i < suite->test_count; i++)
+        {
+            if (!ctrs_duration_history_get(duration_history, suite->tests[i].name, &result[i]))
+            {
+                result[i] = default_cost;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*keeps in the suite only the tests of the shard, in the order they were declared in*/
+static int select_shard(CTRS_TEST_SUITE* suite, const CTRS_RUNNER_OPTIONS* options, CTRS_DURATION_HISTORY_HANDLE duration_history)
+{
+    int result;
+    size_t selected_count = suite->test_count;
+    size_t* shards = malloc(((selected_count == 0) ? 1 : selected_count) * sizeof(size_t));
+    double* costs = NULL;
+
+    if (shards == NULL)
+    {
+        LogError("failure in malloc(%zu * sizeof(size_t))", selected_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        size_t kept = 0;
+        double shard_cost = 0;
+
+        if ((duration_history != NULL) && ((costs = get_test_costs(suite, duration_history)) != NULL))
+        {
+            /*every shard computes the same split from the same history*/
+            result = ctrs_duration_history_assign_longest_first(costs, selected_count, options->shard_count, shards);
+        }
+        else
+        {
+            result = MU_FAILURE;
+        }
+
+        if (result != 0)
+        {
+            /*the shard takes every shard_count-th of the selected tests, so shard sizes differ by at most one*/
+            for (i = 0; i < selected_count; i++)
+            {
+                shards[i] = i % options->shard_count;
+            }
+        }
+
+        for (i = 0; i < selected_count; i++)
+        {
+            if (shards[i] == options->shard_index)
+            {
+                suite->tests[kept] = suite->tests[i];
+                shard_cost += (costs != NULL) ? costs[i] : 0;
+                kept++;
+            }
+        }
+        suite->test_count = kept;
+
+        if (costs != NULL)
+        {
+            LogInfo("%s: shard %zu/%zu runs %zu of %zu tests, expected to take %.3f ms", suite->name, options->shard_index, options->shard_count, suite->test_count, selected_count, shard_cost);
+        }
+        else
+        {
+            LogInfo("%s: shard %zu/%zu runs %zu of %zu tests", suite->name, options->shard_index, options->shard_count, suite->test_count, selected_count);
+        }
+
+        result = 0;
+    }
+
+    free(costs);
+    free(shards);
+    return result;
+}
+
+static int build_test_suite(const TEST_FUNCTION_DATA* test_list_head, const char* test_suite_name, const CTRS_RUNNER_OPTIONS* options, CTRS_DURATION_HISTORY_HANDLE duration_history, CTRS_TEST_SUITE* suite)
+{
+    int result;
+    const TEST_FUNCTION_DATA* current;
+    size_t test_function_count = 0;
+
+    suite->name = test_suite_name;
+    suite->suite_initialize = NULL;
+    suite->suite_cleanup = NULL;
+    suite->function_initialize = NULL;
+    suite->function_cleanup = NULL;
+    suite->tests = NULL;
+    suite->test_count = 0;
+    suite->test_timeout_seconds = options->test_timeout_seconds;
+    /*a test past its deadline is killed with its process, so the tests of a run with deadlines run in a forked child, a new one after a timeout*/
+    suite->fork_batch_size = (
+        (options->fork_batch_size == 0) &&
+        ((options->test_timeout_seconds > 0) || ctrs_watchdog_any_test_timeout_registered())
+        ) ? SIZE_MAX : options->fork_batch_size;
+    suite->profile_directory = options->profile_directory;
+    suite->profile_frequency_hz = options->profile_frequency_hz;
+
+    for (current = test_list_head; current != NULL; current = (const TEST_FUNCTION_DATA*)current->NextTestFunctionData)
+    {
+        switch (current->FunctionType)
+        {
+            default:
+                break;
+            case CTEST_TEST_SUITE_INITIALIZE:
+                suite->suite_initialize = current;
+                break;
+            case CTEST_TEST_SUITE_CLEANUP:
+                suite->suite_cleanup = current;
+                break;
+            case CTEST_TEST_FUNCTION_INITIALIZE:
+                suite->function_initialize = current;
+                break;
+            case CTEST_TEST_FUNCTION_CLEANUP:
+                suite->function_cleanup = current;
+                break;
+            case CTEST_TEST_FUNCTION:
+            {
+                /*a table test is a test per row, a table whose rows cannot be loaded stays one test that fails*/
+                CTRS_DATA_TABLE* data_table = ctrs_data_table_find(current->TestFunctionName);
+                test_function_count += ((data_table != NULL) && (ctrs_data_table_load(data_table) == 0)) ? data_table->row_count : 1;
+                break;
+            }
+        }
+    }
+
+    if (test_function_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        suite->tests = malloc(test_function_count * sizeof(CTRS_SUITE_TEST));
+        if (suite->tests == NULL)
+        {
+            LogError("failure in malloc(%zu * sizeof(CTRS_SUITE_TEST))", test_function_count);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            for (current = test_list_head; current != NULL; current = (const TEST_FUNCTION_DATA*)current->NextTestFunctionData)
+            {
+                if (current->FunctionType == CTEST_TEST_FUNCTION)
+                {
+                    CTRS_DATA_TABLE* data_table = ctrs_data_table_find(current->TestFunctionName);
+
+                    if ((data_table == NULL) || (data_table->loaded == NULL))
+                    {
+                        add_test_if_selected(suite, options, current, current->TestFunctionName, NULL, 0);
+                    }
+                    else
+                    {
+                        size_t i;
+                        for (i = 0; i < data_table->row_count; i++)
+                        {
+                            add_test_if_selected(suite, options, current, ctrs_data_table_get_row_name(data_table, i), data_table, i);
+                        }
+                    }
+                }
+            }
+
+            if (options->shard_count > 1)
+            {
+                result = select_shard(suite, options, duration_history);
+            }
+            else
+            {
+                result = 0;
+            }
+
+            if (result != 0)
+            {
+                free(suite->tests);
+                suite->tests = NULL;
+                suite->test_count = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void destroy_test_suite(CTRS_TEST_SUITE* suite)
+{
+    free((void*)suite->tests);
+    suite->tests = NULL;
+    suite->test_count = 0;
+}
+
+static CTRS_TEST_OUTCOME run_test_with_fixtures(const CTRS_TEST_SUITE* suite, const CTRS_SUITE_TEST* test)
+{
+    CTRS_TEST_OUTCOME result;
+
+    if (call_fixture(suite->function_initialize) != 0)
+    {
+        LogError("Test function initialize failed for %s", test->name);
+        result = CTRS_TEST_OUTCOME_FAILED;
+    }
+    else
+    {
+        /*the TEST_FUNCTION of a table test runs the one row selected here*/
+        ctrs_data_table_select_row(test->data_table, test->row_index);
+        result = (call_protected(test->test_function->TestFunction) == 0) ? CTRS_TEST_OUTCOME_PASSED : CTRS_TEST_OUTCOME_FAILED;
+        ctrs_data_table_select_row(NULL, 0);
+
+        if (call_fixture(suite->function_cleanup) != 0)
+        {
+            LogError("Test function cleanup failed for %s", test->name);
+            result = CTRS_TEST_OUTCOME_FAILED;
+        }
+    }
+
+    return result;
+}
+
+/*runs the test and its function fixtures under the watchdog: past timeout_seconds the forked child running them is killed*/
+static CTRS_TEST_OUTCOME run_test_with_deadline(const CTRS_TEST_SUITE* suite, const CTRS_SUITE_TEST* test, double timeout_seconds)
+{
+    CTRS_TEST_OUTCOME result;
+
+    if (ctrs_watchdog_arm(test->name, timeout_seconds) != 0)
+    {
+        LogWarning("no watchdog for test %s, it runs without its %.3f s deadline", test->name, timeout_seconds);
+    }
+    result = run_test_with_fixtures(suite, test);
+    ctrs_watchdog_disarm();
+
+    return result;
+}
+
+/*stops the profile of the test and writes its folded stacks to the profile directory of the suite*/
+static void write_test_profile(const CTRS_TEST_SUITE* suite, const CTRS_SUITE_TEST* test)
+{
+    char folded_path[1024];
+    size_t sample_count;
+
+    if (ctrs_profiler_get_folded_path(suite->profile_directory, suite->name, test->name, folded_path, sizeof(folded_path)) != 0)
+    {
+        LogError("no profile path for test %s", test->name);
+        (void)ctrs_profiler_stop(NULL, NULL);
+    }
+    else if (ctrs_profiler_stop(folded_path, &sample_count) != 0)
+    {
+        LogError("failure writing the profile of test %s to %s", test->name, folded_path);
+    }
+    else
+    {
+        LogInfo("Test %s: %zu profile samples written to %s", test->name, sample_count, folded_path);
+    }
+}
+
+static CTRS_TEST_RESULT run_one_test(const CTRS_TEST_SUITE* suite, const CTRS_SUITE_TEST* test)
+{
+    CTRS_TEST_RESULT result;
+    CTRS_TEST_METRICS_SAMPLE before;
+    CTRS_TEST_METRICS_SAMPLE after;
+    double timeout_seconds = ctrs_watchdog_get_test_timeout(test->test_function->TestFunctionName, suite->test_timeout_seconds);
+    bool profiled = false;
+
+    LogInfo("Executing test %s ...", test->name);
+
+    /*the profile covers the function fixtures like the metrics do, its buffer is allocated before the metrics start and freed after they end*/
+    if (suite->profile_directory != NULL)
+    {
+        profiled = (ctrs_profiler_start(suite->profile_frequency_hz) == 0);
+        if (!profiled)
+        {
+            LogWarning("test %s runs without a profile", test->name);
+        }
+    }
+
+    /*the metrics cover the function fixtures too, they are part of what running the test costs*/
+    ctrs_test_metrics_sample(&before);
+
+    result.outcome = (timeout_seconds > 0) ? run_test_with_deadline(suite, test, timeout_seconds) : run_test_with_fixtures(suite, test);
+
+    ctrs_test_metrics_sample(&after);
+    ctrs_test_metrics_compute(&before, &after, &result.metrics);
+
+    if (profiled)
+    {
+        write_test_profile(suite, test);
+    }
+
+    /*a test that failed an assertion while holding resource locks did not get to release them*/
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+
+    /*a long assertion message of this test should not keep its memory for the rest of the run*/
+    ctrs_sprintf_thread_local_reset();
+
+    if (result.metrics.allocations_counted)
+    {
+        LogInfo("Test %s made %" PRIu64 " allocations (%" PRIu64 " bytes) and %" PRIu64 " frees", test->name, result.metrics.allocation_count, result.metrics.allocated_bytes, result.metrics.free_count);
+    }
+
+    if (ctrs_perf_counts_any_counted(&result.metrics.perf_counts))
+    {
+        char formatted[256];
+        ctrs_perf_counts_format(&result.metrics.perf_counts, 1, formatted, sizeof(formatted));
+        LogInfo("Test %s: %s", test->name, formatted);
+    }
+
+    if (result.outcome == CTRS_TEST_OUTCOME_PASSED)
+    {
+        LogInfo("Test %s result = Succeeded. (%.3f ms)", test->name, (double)result.metrics.wall_time_ns / 1000000.0);
+    }
+    else
+    {
+        LogError("Test %s result = !!! FAILED !!! (%.3f ms)", test->name, (double)result.metrics.wall_time_ns / 1000000.0);
+    }
+
+    return result;
+}
+
+static void run_tests_inline(const CTRS_TEST_SUITE* suite, const size_t* test_indices, size_t test_index_count, ON_TEST_RESULT on_test_result, void* on_test_result_context)
+{
+    size_t i;
+    CTRS_TEST_RESULT_RECORD record;
+
+    for (i = 0; i < test_index_count; i++)
+    {
+        record.test_index = test_indices[i];
+        record.result = run_one_test(suite, &suite->tests[test_indices[i]]);
+        on_test_result(on_test_result_context, &record);
+    }
+}
+
+#ifndef _WIN32
+static void write_test_result_to_pipe(void* context, const CTRS_TEST_RESULT_RECORD* record)
+{
+    int* pipe_write_fd = context;
+    const unsigned char* bytes = (const unsigned char*)record;
+    size_t written = 0;
+
+    /*records are smaller than PIPE_BUF so the write is atomic with respect to the other workers*/
+    while (written < sizeof(CTRS_TEST_RESULT_RECORD))
+    {
+        ssize_t write_result = write(*pipe_write_fd, bytes + written, sizeof(CTRS_TEST_RESULT_RECORD) - written);
+        if (write_result < 0)
+        {
+            if (errno != EINTR)
+            {
+                LogError("failure in write(%d, ...), errno=%d", *pipe_write_fd, errno);
+                break;
+            }
+        }
+        else
+        {
+            written += (size_t)write_result;
+        }
+    }
+}
+
+static void read_test_results_from_pipe(int pipe_read_fd, ON_TEST_RESULT on_test_result, void* on_test_result_context)
+{
+    CTRS_TEST_RESULT_RECORD record;
+    size_t received = 0;
+
+    for (;;)
+    {
+        ssize_t read_result = read(pipe_read_fd, (unsigned char*)&record + received, sizeof(record) - received);
+        if (read_result < 0)
+        {
+            if (errno != EINTR)
+            {
+                LogError("failure in read(%d, ...), errno=%d", pipe_read_fd, errno);
+                break;
+            }
+        }
+        else if (read_result == 0)
+        {
+            /*all workers have closed their end of the pipe*/
+            break;
+        }
+        else
+        {
+            received += (size_t)read_result;
+            if (received == sizeof(record))
+            {
+                on_test_result(on_test_result_context, &record);
+                received = 0;
+            }
+        }
+    }
+}
+
+typedef struct CTRS_FORKED_BATCH_TAG
+{
+    ON_TEST_RESULT on_test_result;
+    void* on_test_result_context;
+    size_t reported_count;
+} CTRS_FORKED_BATCH;
+
+static void forward_forked_test_result(void* context, const CTRS_TEST_RESULT_RECORD* record)
+{
+    CTRS_FORKED_BATCH* batch = context;
+
+    batch->on_test_result(batch->on_test_result_context, record);
+    batch->reported_count++;
+}
+
+/*forks a child of the current process (which ran the suite initialize) for every fork_batch_size tests, the child runs the function fixtures and the tests and reports
+over a pipe. A test that crashes its child fails alone, the rest of its batch goes on in a new child*/
+static void run_tests_in_forked_children(const CTRS_TEST_SUITE* suite, const size_t* test_indices, size_t test_index_count, ON_TEST_RESULT on_test_result, void* on_test_result_context)
+{
+    size_t next = 0;
+
+    while (next < test_index_count)
+    {
+        size_t batch_count = ((test_index_count - next) < suite->fork_batch_size) ? (test_index_count - next) : suite->fork_batch_size;
+        CTRS_FORKED_BATCH batch;
+        int pipe_fds[2];
+        pid_t pid;
+        int status = 0;
+
+        batch.on_test_result = on_test_result;
+        batch.on_test_result_context = on_test_result_context;
+        batch.reported_count = 0;
+
+        if (pipe(pipe_fds) != 0)
+        {
+            LogError("failure in pipe, errno=%d", errno);
+            pid = -1;
+        }
+        else
+        {
+            (void)fflush(stdout);
+            (void)fflush(stderr);
+
+            pid = fork();
+            if (pid < 0)
+            {
+                LogError("failure in fork, errno=%d", errno);
+                (void)close(pipe_fds[0]);
+                (void)close(pipe_fds[1]);
+            }
+            else if (pid == 0)
+            {
+                (void)close(pipe_fds[0]);
+                /*line buffering keeps the output of a test that crashes the child*/
+                (void)setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+                run_tests_inline(suite, test_indices + next, batch_count, write_test_result_to_pipe, &pipe_fds[1]);
+                (void)fflush(stdout);
+                (void)fflush(stderr);
+                (void)close(pipe_fds[1]);
+                _exit(0);
+            }
+            else
+            {
+                (void)close(pipe_fds[1]);
+                read_test_results_from_pipe(pipe_fds[0], forward_forked_test_result, &batch);
+                (void)close(pipe_fds[0]);
+
+                while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR))
+                {
+                }
+            }
+        }
+
+        if (pid < 0)
+        {
+            LogError("running the remaining %zu tests of %s without forking", test_index_count - next, suite->name);
+            run_tests_inline(suite, test_indices + next, test_index_count - next, on_test_result, on_test_result_context);
+            next = test_index_count;
+        }
+        else
+        {
+            next += batch.reported_count;
+
+            if (batch.reported_count < batch_count)
+            {
+                /*the child ended in the test after the last one it reported*/
+                CTRS_TEST_RESULT_RECORD record;
+
+                record.test_index = test_indices[next];
+                (void)memset(&record.result, 0, sizeof(record.result));
+                record.result.outcome = CTRS_TEST_OUTCOME_FAILED;
+
+                if (WIFSIGNALED(status))
+                {
+                    LogError("Test %s result = !!! FAILED !!! (its forked process was terminated by signal %d)", suite->tests[record.test_index].name, WTERMSIG(status));
+                }
+                else if (WIFEXITED(status) && (WEXITSTATUS(status) == CTRS_WATCHDOG_TIMEOUT_EXIT_CODE))
+                {
+                    LogError("Test %s result = !!! FAILED !!! (it timed out and its forked process was killed)", suite->tests[record.test_index].name);
+                }
+                else
+                {
+                    LogError("Test %s result = !!! FAILED !!! (its forked process exited with code %d)", suite->tests[record.test_index].name, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+                }
+
+                on_test_result(on_test_result_context, &record);
+                next++;
+            }
+        }
+    }
+}
+#endif
+
+/*runs suite initialize, the tests at test_indices and suite cleanup in the current process, reporting every outcome to on_test_result*/
+static void run_tests_in_process(const CTRS_TEST_SUITE* suite, const size_t* test_indices, size_t test_index_count, ON_TEST_RESULT on_test_result, void* on_test_result_context)
+{
+    CTRS_TEST_RESULT_RECORD record;
+
+    if (call_fixture(suite->suite_initialize) != 0)
+    {
+        LogError("Test suite initialize failed for %s, %zu tests are not executed", suite->name, test_index_count);
+
+        record.test_index = CTRS_SUITE_FIXTURE_INDEX;
+        (void)memset(&record.result, 0, sizeof(record.result));
+        record.result.outcome = CTRS_TEST_OUTCOME_FAILED;
+        on_test_result(on_test_result_context, &record);
+    }
+    else
+    {
+        if (suite->fork_batch_size == 0)
+        {
+            run_tests_inline(suite, test_indices, test_index_count, on_test_result, on_test_result_context);
+        }
+        else
+        {
+#ifdef _WIN32
+            run_tests_inline(suite, test_indices, test_index_count, on_test_result, on_test_result_context);
+#else
+            run_tests_in_forked_children(suite, test_indices, test_index_count, on_test_result, on_test_result_context);
+#endif
+        }
+
+        if (call_fixture(suite->suite_cleanup) != 0)
+        {
+            LogError("Test suite cleanup failed for %s", suite->name);
+
+            record.test_index = CTRS_SUITE_FIXTURE_INDEX;
+            (void)memset(&record.result, 0, sizeof(record.result));
+            record.result.outcome = CTRS_TEST_OUTCOME_FAILED;
+            on_test_result(on_test_result_context, &record);
+        }
+    }
+
+    /*the suite fixtures may have failed between SUITE_RESOURCE_LOCK_ACQUIRE and SUITE_RESOURCE_LOCK_RELEASE*/
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_SUITE);
+}
+
+typedef struct CTRS_RUN_RESULTS_TAG
+{
+    CTRS_TEST_RESULT* test_results;
+    size_t test_count;
+    size_t run_failures;
+} CTRS_RUN_RESULTS;
+
+static void store_test_result(void* context, const CTRS_TEST_RESULT_RECORD* record)
+{
+    CTRS_RUN_RESULTS* run_results = context;
+
+    if (record->test_index == CTRS_SUITE_FIXTURE_INDEX)
+    {
+        run_results->run_failures++;
+    }
+    else if (record->test_index < run_results->test_count)
+    {
+        run_results->test_results[record->test_index] = record->result;
+    }
+    else
+    {
+        LogError("result for unknown test index %zu (test_count=%zu)", record->test_index, run_results->test_count);
+        run_results->run_failures++;
+    }
+}
+
+static void run_tests_serially(const CTRS_TEST_SUITE* suite, CTRS_RUN_RESULTS* run_results)
+{
+    size_t* test_indices = malloc((suite->test_count + 1) * sizeof(size_t));
+    if (test_indices == NULL)
+    {
+        LogError("failure in malloc((%zu + 1) * sizeof(size_t))", suite->test_count);
+        run_results->run_failures++;
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < suite->test_count; i++)
+        {
+            test_indices[i] = i;
+        }
+
+        run_tests_in_process(suite, test_indices, suite->test_count, store_test_result, run_results);
+
+        free(test_indices);
+    }
+}
+
+#ifndef _WIN32
+typedef struct CTRS_WORKER_TAG
+{
+    pid_t pid;
+    FILE* output;
+    size_t* test_indices;
+    size_t test_index_count;
+} CTRS_WORKER;
+
+static void run_worker(const CTRS_TEST_SUITE* suite, CTRS_WORKER* worker, int pipe_write_fd)
+{
+    if (
+        (dup2(fileno(worker->output), STDOUT_FILENO) < 0) ||
+        (dup2(fileno(worker->output), STDERR_FILENO) < 0)
+        )
+    {
+        LogError("failure redirecting the output of worker %d, errno=%d", (int)getpid(), errno);
+    }
+    else
+    {
+        /*stdout is now a file, line buffering keeps the output of a test that crashes the worker*/
+        (void)setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+    }
+
+    run_tests_in_process(suite, worker->test_indices, worker->test_index_count, write_test_result_to_pipe, &pipe_write_fd);
+
+    (void)fflush(stdout);
+    (void)fflush(stderr);
+}
+
+static void replay_worker_output(FILE* output)
+{
+    char buffer[4096];
+    size_t read_count;
+
+    (void)fflush(output);
+    rewind(output);
+    while ((read_count = fread(buffer, 1, sizeof(buffer), output)) > 0)
+    {
+        (void)fwrite(buffer, 1, read_count, stdout);
+    }
+    (void)fflush(stdout);
+}
+
+static void run_tests_in_workers(const CTRS_TEST_SUITE* suite, size_t jobs, CTRS_DURATION_HISTORY_HANDLE duration_history, CTRS_RUN_RESULTS* run_results)
+{
+    CTRS_WORKER* workers;
+    size_t* all_test_indices;
+    size_t* test_workers;
+    size_t worker_count = (jobs < suite->test_count) ? jobs : suite->test_count;
+
+    workers = calloc(worker_count, sizeof(CTRS_WORKER));
+    all_test_indices = malloc(suite->test_count * sizeof(size_t));
+    test_workers = malloc(suite->test_count * sizeof(size_t));
+    if ((workers == NULL) || (all_test_indices == NULL) || (test_workers == NULL))
+    {
+        LogError("failure allocating %zu workers", worker_count);
+        run_results->run_failures++;
+    }
+    else
+    {
+        int pipe_fds[2];
+
+        if (pipe(pipe_fds) != 0)
+        {
+            LogError("failure in pipe, errno=%d", errno);
+            run_results->run_failures++;
+        }
+        else
+        {
+            size_t i;
+            size_t started_count;
+            size_t next_index = 0;
+            double* costs = (duration_history == NULL) ? NULL : get_test_costs(suite, duration_history);
+
+            if ((costs == NULL) || (ctrs_duration_history_assign_longest_first(costs, suite->test_count, worker_count, test_workers) != 0))
+            {
+                /*round robin, so that tests declared next to each other (and usually of similar cost) end up on different workers*/
+                for (i = 0; i < suite->test_count; i++)
+                {
+                    test_workers[i] = i % worker_count;
+                }
+            }
+            else
+            {
+                /*longest first, so that the workers finish at about the same time rather than one running the slow tests alone at the end*/
+            }
+
+            for (i = 0; i < worker_count; i++)
+            {
+                size_t test_index;
+                double worker_cost = 0;
+
+                workers[i].test_indices = all_test_indices + next_index;
+                workers[i].test_index_count = 0;
+                for (test_index = 0; test_index < suite->test_count; test_index++)
+                {
+                    if (test_workers[test_index] == i)
+                    {
+                        workers[i].test_indices[workers[i].test_index_count] = test_index;
+                        workers[i].test_index_count++;
+                        worker_cost += (costs != NULL) ? costs[test_index] : 0;
+                    }
+                }
+                next_index += workers[i].test_index_count;
+
+                if (costs != NULL)
+                {
+                    LogInfo("worker %zu runs %zu tests, expected to take %.3f ms", i, workers[i].test_index_count, worker_cost);
+                }
+            }
+
+            free(costs);
+
+            LogInfo("Running %zu tests of %s in %zu worker processes", suite->test_count, suite->name, worker_count);
+
+            (void)fflush(stdout);
+            (void)fflush(stderr);
+
+            for (started_count = 0; started_count < worker_count; started_count++)
+            {
+                CTRS_WORKER* worker = &workers[started_count];
+
+                worker->output = tmpfile();
+                if (worker->output == NULL)
+                {
+                    LogError("failure in tmpfile for worker %zu, errno=%d", started_count, errno);
+                    break;
+                }
+
+                worker->pid = fork();
+                if (worker->pid < 0)
+                {
+                    LogError("failure in fork for worker %zu, errno=%d", started_count, errno);
+                    (void)fclose(worker->output);
+                    worker->output = NULL;
+                    break;
+                }
+                else if (worker->pid == 0)
+                {
+                    (void)close(pipe_fds[0]);
+                    run_worker(suite, worker, pipe_fds[1]);
+                    (void)close(pipe_fds[1]);
+                    _exit(0);
+                }
+                else
+                {
+                    /*parent, go on with the next worker*/
+                }
+            }
+
+            (void)close(pipe_fds[1]);
+
+            read_test_results_from_pipe(pipe_fds[0], store_test_result, run_results);
+
+            (void)close(pipe_fds[0]);
+
+            for (i = 0; i < started_count; i++)
+            {
+                int status;
+                while ((waitpid(workers[i].pid, &status, 0) < 0) && (errno == EINTR))
+                {
+                }
+
+                LogInfo("---------- output of worker %zu (pid %d) ----------", i, (int)workers[i].pid);
+                replay_worker_output(workers[i].output);
+                (void)fclose(workers[i].output);
+
+                if (WIFSIGNALED(status))
+                {
+                    LogError("worker %zu (pid %d) was terminated by signal %d", i, (int)workers[i].pid, WTERMSIG(status));
+                }
+                else if (WIFEXITED(status) && (WEXITSTATUS(status) != 0))
+                {
+                    LogError("worker %zu (pid %d) exited with code %d", i, (int)workers[i].pid, WEXITSTATUS(status));
+                }
+                else
+                {
+                    /*tests that did not report (crash, early exit) stay CTRS_TEST_OUTCOME_NOT_EXECUTED and are counted as failed*/
+                }
+            }
+
+            if (started_count < worker_count)
+            {
+                LogError("only %zu of %zu workers could be started", started_count, worker_count);
+            }
+        }
+    }
+
+    free(test_workers);
+    free(all_test_indices);
+    free(workers);
+}
+#endif
+
+/*returns the history the tests are scheduled by, NULL when the options do not ask for one (or it cannot be read, the tests then run round robin)*/
+static CTRS_DURATION_HISTORY_HANDLE load_duration_history(const char* test_suite_name, const CTRS_RUNNER_OPTIONS* options)
+{
+    CTRS_DURATION_HISTORY_HANDLE result;
+
+    if (
+        ((options->duration_history_path != NULL) && (strcmp(options->duration_history_path, CTRS_DURATION_HISTORY_OFF) == 0)) ||
+        ((options->duration_history_path == NULL) && ((options->jobs <= 1) || (options->shard_count > 1)))
+        )
+    {
+        /*
+        no history: a serial run of the whole suite has nothing to schedule, and the shards of a suite split it by history only when asked to,
+        every shard has to load the same history as the others (the runs of other flavors of the exe must not share it)
+        */
+        result = NULL;
+    }
+    else
+    {
+        char* default_path = NULL;
+        const char* path = options->duration_history_path;
+
+        if (path == NULL)
+        {
+            default_path = ctrs_sprintf_char("%s" CTRS_DURATION_HISTORY_DEFAULT_EXTENSION, test_suite_name);
+            path = default_path;
+        }
+
+        if (path == NULL)
+        {
+            LogError("failure making the path of the duration history of %s", test_suite_name);
+            result = NULL;
+        }
+        else
+        {
+            result = ctrs_duration_history_load(path, test_suite_name, options->shard_index, options->shard_count);
+            if (result == NULL)
+            {
+                LogWarning("failure loading the duration history %s, the tests are scheduled without it", path);
+            }
+        }
+
+        ctrs_sprintf_free(default_path);
+    }
+
+    return result;
+}
+
+/*records the durations of the tests that ran, a test that did not run keeps the duration of its past runs*/
+static void save_duration_history(CTRS_DURATION_HISTORY_HANDLE duration_history, const CTRS_TEST_SUITE* suite, const CTRS_RUNNER_OPTIONS* options, const CTRS_RUN_RESULTS* run_results)
+{
+    size_t i;
+    size_t not_executed_count = 0;
+
+    for (i = 0; i < suite->test_count; i++)
+    {
+        if (run_results->test_results[i].outcome == CTRS_TEST_OUTCOME_NOT_EXECUTED)
+        {
+            not_executed_count++;
+        }
+        else
+        {
+            ctrs_duration_history_record(duration_history, suite->tests[i].name, (double)run_results->test_results[i].metrics.wall_time_ns / 1000000.0);
+        }
+    }
+
+    /*only a run of all the tests (of all the tests of every shard) knows which tests are gone from the suite*/
+    if (ctrs_duration_history_save(duration_history, (options->test_filter == NULL) && (not_executed_count == 0)) != 0)
+    {
+        LogWarning("failure saving the duration history of %s", suite->name);
+    }
+}
+
+/*the profiles are CI artifacts, their directory is created when it does not exist yet*/
+static int create_profile_directory(const char* profile_directory)
+{
+    int result;
+
+#ifdef _WIN32
+    (void)profile_directory;
+    result = 0;
+#else
+    if ((mkdir(profile_directory, 0777) != 0) && (errno != EEXIST))
+    {
+        LogError("failure in mkdir(%s), errno=%d", profile_directory, errno);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+#endif
+
+    return result;
+}
+
+static size_t report_results(const CTRS_TEST_SUITE* suite, const CTRS_RUN_RESULTS* run_results)
+{
+    size_t i;
+    size_t passed_count = 0;
+    size_t failed_count = 0;
+    size_t not_executed_count = 0;
+
+    for (i = 0; i < suite->test_count; i++)
+    {
+        switch (run_results->test_results[i].outcome)
+        {
+            default:
+                break;
+            case CTRS_TEST_OUTCOME_PASSED:
+                passed_count++;
+                break;
+            case CTRS_TEST_OUTCOME_FAILED:
+                failed_count++;
+                LogError("%s: test %s FAILED", suite->name, suite->tests[i].name);
+                break;
+            case CTRS_TEST_OUTCOME_NOT_EXECUTED:
+                not_executed_count++;
+                LogError("%s: test %s did not complete (NOT EXECUTED or its worker process died)", suite->name, suite->tests[i].name);
+                break;
+        }
+    }
+
+    if (run_results->run_failures != 0)
+    {
+        LogError("%s: %zu failure(s) outside of tests (suite fixtures, runner errors)", suite->name, run_results->run_failures);
+    }
+
+    LogInfo("%s: %zu tests, %zu failed, %zu succeeded, %zu did not complete.",
+        suite->name, suite->test_count, failed_count, passed_count, not_executed_count);
+
+    /*not executed tests and fixture failures make the run fail the same way failed tests do*/
+    return failed_count + not_executed_count + run_results->run_failures;
+}
+
+static int write_report(const CTRS_TEST_SUITE* suite, const CTRS_RUNNER_OPTIONS* options, const CTRS_RUN_RESULTS* run_results)
+{
+    int result;
+    const char** test_names = malloc((suite->test_count + 1) * sizeof(const char*));
+
+    if (test_names == NULL)
+    {
+        LogError("failure in malloc((%zu + 1) * sizeof(const char*))", suite->test_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        CTRS_REPORT_SUITE report_suite;
+
+        for (i = 0; i < suite->test_count; i++)
+        {
+            test_names[i] = suite->tests[i].name;
+        }
+
+        report_suite.name = suite->name;
+        report_suite.shard_index = options->shard_index;
+        report_suite.shard_count = options->shard_count;
+        report_suite.test_count = suite->test_count;
+        report_suite.test_names = test_names;
+        report_suite.test_results = run_results->test_results;
+        report_suite.run_failures = run_results->run_failures;
+
+        result = ctrs_report_write(options->report_path, options->report_format, &report_suite);
+
+        free((void*)test_names);
+    }
+
+    return result;
+}
+
+/*
+one line of --list-properties, what ctrs_discover_tests.cmake turns into the TIMEOUT, RESOURCE_LOCK and COST of the ctest test: only the
+TEST_FUNCTION_TIMEOUT of the test (the deadline of the suite is the same for every test), the tags of its RESOURCE_LOCKED_TEST_FUNCTION
+and its duration in the history
+*/
+static void print_test_properties(const CTRS_SUITE_TEST* test, CTRS_DURATION_HISTORY_HANDLE duration_history)
+{
+    const CTRS_TEST_RESOURCE_LOCKS* test_locks = ctrs_resource_lock_get_test_locks(test->test_function->TestFunctionName);
+    double duration_ms;
+    size_t i;
+
+    if ((duration_history == NULL) || !ctrs_duration_history_get(duration_history, test->name, &duration_ms))
+    {
+        duration_ms = 0;
+    }
+
+    (void)printf("%s\t%.3f\t", test->name, ctrs_watchdog_get_test_timeout(test->test_function->TestFunctionName, 0));
+    if (test_locks != NULL)
+    {
+        for (i = 0; i < test_locks->tag_count; i++)
+        {
+            (void)printf("%s%s", (i == 0) ? "" : ",", test_locks->tags[i]);
+        }
+    }
+    (void)printf("\t%.3f\n", duration_ms / 1000.0);
+}
+
+size_t ctrs_runner_run_test_suite(const TEST_FUNCTION_DATA* test_list_head, const char* test_suite_name, const CTRS_RUNNER_OPTIONS* options)
+{
+    size_t result;
+    CTRS_TEST_SUITE suite;
+
+    if (
+        (test_list_head == NULL) ||
+        (test_suite_name == NULL) ||
+        (options == NULL)
+        )
+    {
+        LogError("Invalid arguments const TEST_FUNCTION_DATA* test_list_head=%p, const char* test_suite_name=%s, const CTRS_RUNNER_OPTIONS* options=%p",
+            (void*)test_list_head, MU_P_OR_NULL(test_suite_name), (void*)options);
+        result = 1;
+    }
+    else
+    {
+        /*a sharded run splits the tests by the durations, they are read before the list of tests is built*/
+        CTRS_DURATION_HISTORY_HANDLE duration_history = load_duration_history(test_suite_name, options);
+
+        if (build_test_suite(test_list_head, test_suite_name, options, duration_history, &suite) != 0)
+        {
+            LogError("failure building the list of tests for %s", test_suite_name);
+            result = 1;
+        }
+        else if (options->list_tests)
+        {
+            size_t i;
+
+            /*names only (or with their properties), on stdout, so that they can be piped back as a --filter-file; no fixture runs*/
+            for (i = 0; i < suite.test_count; i++)
+            {
+                if (options->list_test_properties)
+                {
+                    print_test_properties(&suite.tests[i], duration_history);
+                }
+                else
+                {
+                    (void)printf("%s\n", suite.tests[i].name);
+                }
+            }
+            result = 0;
+
+            destroy_test_suite(&suite);
+        }
+        else
+        {
+            CTRS_RUN_RESULTS run_results;
+
+            run_results.test_count = suite.test_count;
+            run_results.run_failures = 0;
+            run_results.test_results = malloc((suite.test_count + 1) * sizeof(CTRS_TEST_RESULT));
+            if (run_results.test_results == NULL)
+            {
+                LogError("failure in malloc((%zu + 1) * sizeof(CTRS_TEST_RESULT))", suite.test_count);
+                result = 1;
+            }
+            else
+            {
+                size_t i;
+                for (i = 0; i < suite.test_count; i++)
+                {
+                    (void)memset(&run_results.test_results[i], 0, sizeof(CTRS_TEST_RESULT));
+                    run_results.test_results[i].outcome = CTRS_TEST_OUTCOME_NOT_EXECUTED;
+                }
+
+                if ((options->test_name_filter != NULL) && (suite.test_count == 0) && (options->shard_count <= 1))
+                {
+                    LogError("%s: no test named %s", test_suite_name, options->test_name_filter);
+                    run_results.run_failures++;
+                }
+                else if (suite.test_count == 0)
+                {
+                    /*for example a shard that got no tests, there is no reason to run the suite fixtures*/
+                }
+                else if ((suite.profile_directory != NULL) && (create_profile_directory(suite.profile_directory) != 0))
+                {
+                    LogError("failure creating the profile directory %s, %zu tests are not executed", suite.profile_directory, suite.test_count);
+                    run_results.run_failures++;
+                }
+                else if ((options->jobs <= 1) || (suite.test_count <= 1))
+                {
+                    run_tests_serially(&suite, &run_results);
+                }
+                else
+                {
+#ifdef _WIN32
+                    LogWarning("--jobs is not supported on this platform, running %zu tests serially", suite.test_count);
+                    run_tests_serially(&suite, &run_results);
+#else
+                    run_tests_in_workers(&suite, options->jobs, duration_history, &run_results);
+#endif
+                }
+
+                if ((options->report_path != NULL) && (write_report(&suite, options, &run_results) != 0))
+                {
+                    LogError("failure writing the report of %s to %s", test_suite_name, options->report_path);
+                    run_results.run_failures++;
+                }
+
+                if (duration_history != NULL)
+                {
+                    /*also for a shard without tests, the shards of a run are merged once every one of them saved*/
+                    save_duration_history(duration_history, &suite, options, &run_results);
+                }
+
+                result = report_results(&suite, &run_results);
+
+                free(run_results.test_results);
+            }
+
+            destroy_test_suite(&suite);
+        }
+
+        if (duration_history != NULL)
+        {
+            ctrs_duration_history_destroy(duration_history);
+        }
+    }
+
+    return result;
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "macro_utils/macro_utils.h"
 
@@ -11,15 +12,29 @@
 
 #include "ctrs_sprintf.h"
 
+#ifdef _MSC_VER
+#define CTRS_THREAD_LOCAL __declspec(thread)
+#else
+#define CTRS_THREAD_LOCAL __thread
+#endif
+
+/*most assertion messages fit here, only longer ones need the heap*/
+#define CTRS_SPRINTF_INLINE_SIZE 512
+
+static CTRS_THREAD_LOCAL char g_thread_local_inline_buffer[CTRS_SPRINTF_INLINE_SIZE];
+static CTRS_THREAD_LOCAL char* g_thread_local_heap_buffer;
+static CTRS_THREAD_LOCAL size_t g_thread_local_heap_buffer_size;
+
 static char* ctrs_vsprintf_char(const char* format, va_list va)
 {
     char* result;
+    char first_pass[CTRS_SPRINTF_INLINE_SIZE];
     va_list va_clone;
-    va_copy(va_clone, va); /*passing "va" to vsnprintf twice is undefined behavior, so "va" is passed and then "va_clone"*/
-    int neededSize = vsnprintf(NULL, 0, format, va);
+    va_copy(va_clone, va); /*passing "va" to vsnprintf twice is undefined behavior, so "va" is passed and then "va_clone" (only when the first pass did not fit)*/
+    int neededSize = vsnprintf(first_pass, sizeof(first_pass), format, va);
     if (neededSize < 0)
     {
-        LogError("failure in vsnprintf(NULL, 0, format=%s, va=%p)", format, (void*)&va);
+        LogError("failure in vsnprintf(first_pass, sizeof(first_pass)=%zu, format=%s, va=%p)", sizeof(first_pass), format, (void*)&va);
         result = NULL;
     }
     else
@@ -30,6 +45,11 @@ static char* ctrs_vsprintf_char(const char* format, va_list va)
             LogError("failure in malloc(neededSize=%d + 1);", neededSize);
             /*return as is*/
         }
+        else if ((size_t)neededSize < sizeof(first_pass))
+        {
+            /*the first pass has the whole string already*/
+            (void)memcpy(result, first_pass, (size_t)neededSize + 1);
+        }
         else
         {
             if (vsnprintf(result, neededSize + 1, format, va_clone) != neededSize)
@@ -60,3 +80,71 @@ void ctrs_sprintf_free(char* string)
 {
     free(string);
 }
+
+static const char* ctrs_vsprintf_thread_local(const char* format, va_list va)
+{
+    const char* result;
+    va_list va_clone;
+    va_copy(va_clone, va); /*see ctrs_vsprintf_char*/
+
+    /*single pass into whatever the thread has (the heap buffer once it grew, the inline buffer before)*/
+    char* buffer = (g_thread_local_heap_buffer != NULL) ? g_thread_local_heap_buffer : g_thread_local_inline_buffer;
+    size_t buffer_size = (g_thread_local_heap_buffer != NULL) ? g_thread_local_heap_buffer_size : sizeof(g_thread_local_inline_buffer);
+
+    int neededSize = vsnprintf(buffer, buffer_size, format, va);
+    if (neededSize < 0)
+    {
+        LogError("failure in vsnprintf(buffer, buffer_size=%zu, format=%s, va=%p)", buffer_size, format, (void*)&va);
+        result = NULL;
+    }
+    else if ((size_t)neededSize < buffer_size)
+    {
+        result = buffer;
+    }
+    else
+    {
+        /*grow to at least double, so that a series of growing messages does not realloc every time*/
+        size_t new_size = ((size_t)neededSize + 1 > 2 * buffer_size) ? ((size_t)neededSize + 1) : (2 * buffer_size);
+        char* new_buffer = realloc(g_thread_local_heap_buffer, new_size);
+        if (new_buffer == NULL)
+        {
+            LogError("failure in realloc(g_thread_local_heap_buffer=%p, new_size=%zu)", (void*)g_thread_local_heap_buffer, new_size);
+            result = NULL;
+        }
+        else
+        {
+            g_thread_local_heap_buffer = new_buffer;
+            g_thread_local_heap_buffer_size = new_size;
+
+            if (vsnprintf(new_buffer, new_size, format, va_clone) != neededSize)
+            {
+                LogError("failure in vsnprintf(new_buffer, new_size=%zu, format=%s, va_clone=%p) va=%p ", new_size, format, (void*)&va_clone, (void*)&va);
+                result = NULL;
+            }
+            else
+            {
+                result = new_buffer;
+            }
+        }
+    }
+    va_end(va_clone);
+    return result;
+}
+
+const char* ctrs_sprintf_thread_local(const char* format, ...)
+{
+    const char* result;
+    va_list va;
+    va_start(va, format);
+    result = ctrs_vsprintf_thread_local(format, va);
+    va_end(va);
+    return result;
+}
+
+void ctrs_sprintf_thread_local_reset(void)
+{
+    free(g_thread_local_heap_buffer);
+    g_thread_local_heap_buffer = NULL;
+    g_thread_local_heap_buffer_size = 0;
+    g_thread_local_inline_buffer[0] = '\0';
+}
@@ -0,0 +1,684 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_test_filter.h"
+
+#define CTRS_TEST_FILTER_MAX_LINE 1024
+
+#define CTRS_TEST_FILTER_PATTERN_KIND_VALUES \
+    CTRS_TEST_FILTER_PATTERN_KIND_EXACT, \
+    CTRS_TEST_FILTER_PATTERN_KIND_GLOB, \
+    CTRS_TEST_FILTER_PATTERN_KIND_REGEX
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CTRS_TEST_FILTER_PATTERN_KIND, CTRS_TEST_FILTER_PATTERN_KIND_VALUES)
+
+#define REGEX_QUANTIFIER_VALUES \
+    REGEX_QUANTIFIER_ONE, \
+    REGEX_QUANTIFIER_ZERO_OR_ONE, \
+    REGEX_QUANTIFIER_ZERO_OR_MORE, \
+    REGEX_QUANTIFIER_ONE_OR_MORE
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(REGEX_QUANTIFIER, REGEX_QUANTIFIER_VALUES)
+
+/*every regex atom (a character, '.', a class or an escape) compiles to the set of characters it accepts*/
+typedef struct REGEX_TOKEN_TAG
+{
+    unsigned char accepted[256 / 8];
+    REGEX_QUANTIFIER quantifier;
+} REGEX_TOKEN;
+
+typedef struct CTRS_TEST_FILTER_PATTERN_TAG
+{
+    CTRS_TEST_FILTER_PATTERN_KIND kind;
+    bool exclude;
+    char* text; /*the name or glob, for a regex the expression without its prefix*/
+    REGEX_TOKEN* tokens;
+    size_t token_count;
+    bool anchored_start;
+    bool anchored_end;
+} CTRS_TEST_FILTER_PATTERN;
+
+typedef struct CTRS_TEST_FILTER_TAG
+{
+    CTRS_TEST_FILTER_PATTERN* patterns;
+    size_t pattern_count;
+    size_t pattern_capacity;
+    size_t include_count;
+} CTRS_TEST_FILTER;
+
+static void set_add(unsigned char* accepted, unsigned char c)
+{
+    accepted[c / 8] |= (unsigned char)(1u << (c % 8));
+}
+
+static bool set_contains(const unsigned char* accepted, unsigned char c)
+{
+    return (accepted[c / 8] & (1u << (c % 8))) != 0;
+}
+
+static void set_add_range(unsigned char* accepted, unsigned char first, unsigned char last)
+{
+    unsigned int c;
+    for (c = first; c <= last; c++)
+    {
+        set_add(accepted, (unsigned char)c);
+    }
+}
+
+/*adds the class of "\d", "\w", "\s" or the escaped character itself*/
+static void set_add_escape(unsigned char* accepted, char escaped)
+{
+    switch (escaped)
+    {
+        default:
+            set_add(accepted, (unsigned char)escaped);
+            break;
+        case 'd':
+            set_add_range(accepted, '0', '9');
+            break;
+        case 'w':
+            set_add_range(accepted, '0', '9');
+            set_add_range(accepted, 'a', 'z');
+            set_add_range(accepted, 'A', 'Z');
+            set_add(accepted, '_');
+            break;
+        case 's':
+            set_add(accepted, ' ');
+            set_add_range(accepted, '\t', '\r');
+            break;
+    }
+}
+
+/*compiles the bracket expression starting after '[', returns the position after ']' or NULL when it is not closed or has a reversed range*/
+static const char* compile_class(const char* position, unsigned char* accepted)
+{
+    bool negate = false;
+    bool first = true;
+    size_t i;
+
+    if (*position == '^')
+    {
+        negate = true;
+        position++;
+    }
+
+    while ((position != NULL) && (*position != '\0') && ((*position != ']') || first))
+    {
+        if ((*position == '\\') && (position[1] != '\0'))
+        {
+            set_add_escape(accepted, position[1]);
+            position += 2;
+        }
+        else if ((position[1] == '-') && (position[2] != ']') && (position[2] != '\0'))
+        {
+            if ((unsigned char)position[0] > (unsigned char)position[2])
+            {
+                LogError("reversed range %c-%c", position[0], position[2]);
+                position = NULL;
+            }
+            else
+            {
+                set_add_range(accepted, (unsigned char)position[0], (unsigned char)position[2]);
+                position += 3;
+            }
+        }
+        else
+        {
+            set_add(accepted, (unsigned char)*position);
+            position++;
+        }
+        first = false;
+    }
+
+    if ((position == NULL) || (*position != ']'))
+    {
+        position = NULL;
+    }
+    else
+    {
+        if (negate)
+        {
+            for (i = 0; i < sizeof(((REGEX_TOKEN*)0)->accepted); i++)
+            {
+                accepted[i] = (unsigned char)~accepted[i];
+            }
+        }
+        position++;
+    }
+
+    return position;
+}
+
+static int compile_regex(const char* expression, CTRS_TEST_FILTER_PATTERN* pattern)
+{
+    int result;
+
+    /*every token takes at least one character of the expression*/
+    pattern->tokens = malloc((strlen(expression) + 1) * sizeof(REGEX_TOKEN));
+    if (pattern->tokens == NULL)
+    {
+        LogError("failure in malloc((%zu + 1) * sizeof(REGEX_TOKEN))", strlen(expression));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        const char* position = expression;
+
+        pattern->token_count = 0;
+        pattern->anchored_start = false;
+        pattern->anchored_end = false;
+
+        if (*position == '^')
+        {
+            pattern->anchored_start = true;
+            position++;
+        }
+
+        result = 0;
+        while ((result == 0) && (*position != '\0'))
+        {
+            REGEX_TOKEN* token = &pattern->tokens[pattern->token_count];
+
+            switch (*position)
+            {
+                default:
+                    (void)memset(token, 0, sizeof(REGEX_TOKEN));
+                    set_add(token->accepted, (unsigned char)*position);
+                    pattern->token_count++;
+                    position++;
+                    break;
+                case '$':
+                    if (position[1] != '\0')
+                    {
+                        LogError("'$' is only supported at the end of the regular expression %s", expression);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        pattern->anchored_end = true;
+                        position++;
+                    }
+                    break;
+                case '*':
+                case '+':
+                case '?':
+                    if ((pattern->token_count == 0) || (pattern->tokens[pattern->token_count - 1].quantifier != REGEX_QUANTIFIER_ONE))
+                    {
+                        LogError("'%c' has nothing to repeat in the regular expression %s", *position, expression);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        pattern->tokens[pattern->token_count - 1].quantifier =
+                            (*position == '*') ? REGEX_QUANTIFIER_ZERO_OR_MORE :
+                            (*position == '+') ? REGEX_QUANTIFIER_ONE_OR_MORE :
+                            REGEX_QUANTIFIER_ZERO_OR_ONE;
+                        position++;
+                    }
+                    break;
+                case '(':
+                case ')':
+                case '|':
+                case '{':
+                case '}':
+                    LogError("'%c' is not supported in the regular expression %s, use several patterns instead", *position, expression);
+                    result = MU_FAILURE;
+                    break;
+                case '.':
+                    (void)memset(token, 0xFF, sizeof(token->accepted));
+                    token->accepted[0] &= (unsigned char)~1u; /*but not the terminator*/
+                    token->quantifier = REGEX_QUANTIFIER_ONE;
+                    pattern->token_count++;
+                    position++;
+                    break;
+                case '\\':
+                    if (position[1] == '\0')
+                    {
+                        LogError("trailing '\\' in the regular expression %s", expression);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        (void)memset(token, 0, sizeof(REGEX_TOKEN));
+                        set_add_escape(token->accepted, position[1]);
+                        pattern->token_count++;
+                        position += 2;
+                    }
+                    break;
+                case '[':
+                    (void)memset(token, 0, sizeof(REGEX_TOKEN));
+                    position = compile_class(position + 1, token->accepted);
+                    if (position == NULL)
+                    {
+                        LogError("unterminated '[' or reversed range in the regular expression %s", expression);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        token->accepted[0] &= (unsigned char)~1u;
+                        pattern->token_count++;
+                    }
+                    break;
+            }
+        }
+
+        if (result != 0)
+        {
+            free(pattern->tokens);
+            pattern->tokens = NULL;
+        }
+    }
+
+    return result;
+}
+
+/*backtracking match of the tokens at the start of text, test names are short so the worst case does not matter*/
+static bool regex_match_here(const REGEX_TOKEN* tokens, size_t token_count, bool anchored_end, const char* text)
+{
+    bool result;
+
+    if (token_count == 0)
+    {
+        result = !anchored_end || (*text == '\0');
+    }
+    else
+    {
+        size_t minimum = ((tokens->quantifier == REGEX_QUANTIFIER_ONE) || (tokens->quantifier == REGEX_QUANTIFIER_ONE_OR_MORE)) ? 1 : 0;
+        size_t maximum = ((tokens->quantifier == REGEX_QUANTIFIER_ONE) || (tokens->quantifier == REGEX_QUANTIFIER_ZERO_OR_ONE)) ? 1 : SIZE_MAX;
+        size_t taken = 0;
+
+        while ((taken < maximum) && (text[taken] != '\0') && set_contains(tokens->accepted, (unsigned char)text[taken]))
+        {
+            taken++;
+        }
+
+        if (taken < minimum)
+        {
+            result = false;
+        }
+        else
+        {
+            /*greedy, give characters back until the rest matches*/
+            result = regex_match_here(tokens + 1, token_count - 1, anchored_end, text + taken);
+            while (!result && (taken > minimum))
+            {
+                taken--;
+                result = regex_match_here(tokens + 1, token_count - 1, anchored_end, text + taken);
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool regex_matches(const CTRS_TEST_FILTER_PATTERN* pattern, const char* text)
+{
+    bool result = regex_match_here(pattern->tokens, pattern->token_count, pattern->anchored_end, text);
+
+    if (!pattern->anchored_start)
+    {
+        while (!result && (*text != '\0'))
+        {
+            text++;
+            result = regex_match_here(pattern->tokens, pattern->token_count, pattern->anchored_end, text);
+        }
+    }
+
+    return result;
+}
+
+static bool glob_matches(const char* glob, const char* text)
+{
+    bool result = true;
+    const char* star_glob = NULL;
+    const char* star_text = NULL;
+
+    while ((*text != '\0') && result)
+    {
+        if (*glob == '*')
+        {
+            glob++;
+            star_glob = glob;
+            star_text = text;
+        }
+        else if ((*glob != '\0') && ((*glob == '?') || (*glob == *text)))
+        {
+            glob++;
+            text++;
+        }
+        else if (star_glob != NULL)
+        {
+            /*let the last '*' take one more character*/
+            star_text++;
+            glob = star_glob;
+            text = star_text;
+        }
+        else
+        {
+            result = false;
+        }
+    }
+
+    if (result)
+    {
+        while (*glob == '*')
+        {
+            glob++;
+        }
+        result = (*glob == '\0');
+    }
+
+    return result;
+}
+
+static bool pattern_matches(const CTRS_TEST_FILTER_PATTERN* pattern, const char* test_name)
+{
+    bool result;
+
+    switch (pattern->kind)
+    {
+        default:
+        case CTRS_TEST_FILTER_PATTERN_KIND_EXACT:
+            result = (strcmp(pattern->text, test_name) == 0);
+            break;
+        case CTRS_TEST_FILTER_PATTERN_KIND_GLOB:
+            result = glob_matches(pattern->text, test_name);
+            break;
+        case CTRS_TEST_FILTER_PATTERN_KIND_REGEX:
+            result = regex_matches(pattern, test_name);
+            break;
+    }
+
+    return result;
+}
+
+CTRS_TEST_FILTER_HANDLE ctrs_test_filter_create(void)
+{
+    CTRS_TEST_FILTER_HANDLE result = malloc(sizeof(CTRS_TEST_FILTER));
+    if (result == NULL)
+    {
+        LogError("failure in malloc(sizeof(CTRS_TEST_FILTER))");
+    }
+    else
+    {
+        result->patterns = NULL;
+        result->pattern_count = 0;
+        result->pattern_capacity = 0;
+        result->include_count = 0;
+    }
+
+    return result;
+}
+
+void ctrs_test_filter_destroy(CTRS_TEST_FILTER_HANDLE test_filter)
+{
+    if (test_filter == NULL)
+    {
+        LogError("Invalid arguments CTRS_TEST_FILTER_HANDLE test_filter=%p", (void*)test_filter);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < test_filter->pattern_count; i++)
+        {
+            free(test_filter->patterns[i].text);
+            free(test_filter->patterns[i].tokens);
+        }
+        free(test_filter->patterns);
+        free(test_filter);
+    }
+}
+
+int ctrs_test_filter_add(CTRS_TEST_FILTER_HANDLE test_filter, const char* pattern, bool exclude)
+{
+    int result;
+
+    if (
+        (test_filter == NULL) ||
+        (pattern == NULL) ||
+        (pattern[0] == '\0')
+        )
+    {
+        LogError("Invalid arguments CTRS_TEST_FILTER_HANDLE test_filter=%p, const char* pattern=%s, bool exclude=%" PRI_BOOL "",
+            (void*)test_filter, MU_P_OR_NULL(pattern), MU_BOOL_VALUE(exclude));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        if (test_filter->pattern_count == test_filter->pattern_capacity)
+        {
+            size_t new_capacity = (test_filter->pattern_capacity == 0) ? 8 : test_filter->pattern_capacity * 2;
+            CTRS_TEST_FILTER_PATTERN* new_patterns = realloc(test_filter->patterns, new_capacity * sizeof(CTRS_TEST_FILTER_PATTERN));
+            if (new_patterns == NULL)
+            {
+                LogError("failure in realloc(%p, %zu * sizeof(CTRS_TEST_FILTER_PATTERN))", (void*)test_filter->patterns, new_capacity);
+            }
+            else
+            {
+                test_filter->patterns = new_patterns;
+                test_filter->pattern_capacity = new_capacity;
+            }
+        }
+
+        if (test_filter->pattern_count == test_filter->pattern_capacity)
+        {
+            /*already logged*/
+            result = MU_FAILURE;
+        }
+        else
+        {
+            CTRS_TEST_FILTER_PATTERN* new_pattern = &test_filter->patterns[test_filter->pattern_count];
+            bool is_regex = (strncmp(pattern, CTRS_TEST_FILTER_REGEX_PREFIX, sizeof(CTRS_TEST_FILTER_REGEX_PREFIX) - 1) == 0);
+            const char* text = is_regex ? pattern + sizeof(CTRS_TEST_FILTER_REGEX_PREFIX) - 1 : pattern;
+            size_t text_size = strlen(text) + 1;
+
+            new_pattern->exclude = exclude;
+            new_pattern->tokens = NULL;
+            new_pattern->token_count = 0;
+            new_pattern->anchored_start = false;
+            new_pattern->anchored_end = false;
+            new_pattern->kind =
+                is_regex ? CTRS_TEST_FILTER_PATTERN_KIND_REGEX :
+                (strpbrk(text, "*?") != NULL) ? CTRS_TEST_FILTER_PATTERN_KIND_GLOB :
+                CTRS_TEST_FILTER_PATTERN_KIND_EXACT;
+
+            new_pattern->text = malloc(text_size);
+            if (new_pattern->text == NULL)
+            {
+                LogError("failure in malloc(%zu)", text_size);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                (void)memcpy(new_pattern->text, text, text_size);
+
+                if (is_regex && (compile_regex(text, new_pattern) != 0))
+                {
+                    LogError("failure compiling the test filter pattern %s", pattern);
+                    free(new_pattern->text);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    test_filter->pattern_count++;
+                    if (!exclude)
+                    {
+                        test_filter->include_count++;
+                    }
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int ctrs_test_filter_add_from_file(CTRS_TEST_FILTER_HANDLE test_filter, const char* file_name)
+{
+    int result;
+
+    if (
+        (test_filter == NULL) ||
+        (file_name == NULL)
+        )
+    {
+        LogError("Invalid arguments CTRS_TEST_FILTER_HANDLE test_filter=%p, const char* file_name=%s",
+            (void*)test_filter, MU_P_OR_NULL(file_name));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        FILE* file = fopen(file_name, "r");
+        if (file == NULL)
+        {
+            LogError("failure in fopen(%s, \"r\")", file_name);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            char line[CTRS_TEST_FILTER_MAX_LINE];
+            size_t line_number = 0;
+
+            result = 0;
+            while ((result == 0) && (fgets(line, sizeof(line), file) != NULL))
+            {
+                size_t length = strlen(line);
+                char* pattern = line;
+                bool exclude = false;
+
+                line_number++;
+                if ((length == sizeof(line) - 1) && (line[length - 1] != '\n') && !feof(file))
+                {
+                    LogError("%s:%zu: line is longer than %d characters", file_name, line_number, CTRS_TEST_FILTER_MAX_LINE - 2);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r') || (line[length - 1] == ' ') || (line[length - 1] == '\t')))
+                    {
+                        length--;
+                    }
+                    line[length] = '\0';
+
+                    while ((*pattern == ' ') || (*pattern == '\t'))
+                    {
+                        pattern++;
+                    }
+
+                    if (*pattern == '-')
+                    {
+                        exclude = true;
+                        pattern++;
+                        while ((*pattern == ' ') || (*pattern == '\t'))
+                        {
+                            pattern++;
+                        }
+                    }
+
+                    if ((*pattern == '\0') || (*pattern == '#'))
+                    {
+                        /*empty line or comment*/
+                    }
+                    else if (ctrs_test_filter_add(test_filter, pattern, exclude) != 0)
+                    {
+                        LogError("%s:%zu: failure in ctrs_test_filter_add(%s)", file_name, line_number, pattern);
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        /*added*/
+                    }
+                }
+            }
+
+            if ((result == 0) && ferror(file))
+            {
+                LogError("failure reading %s", file_name);
+                result = MU_FAILURE;
+            }
+
+            (void)fclose(file);
+        }
+    }
+
+    return result;
+}
+
+bool ctrs_test_filter_matches(CTRS_TEST_FILTER_HANDLE test_filter, const char* test_name)
+{
+    bool result;
+
+    if (
+        (test_filter == NULL) ||
+        (test_name == NULL)
+        )
+    {
+        LogError("Invalid arguments CTRS_TEST_FILTER_HANDLE test_filter=%p, const char* test_name=%s",
+            (void*)test_filter, MU_P_OR_NULL(test_name));
+        result = false;
+    }
+    else
+    {
+        size_t i;
+        bool included = (test_filter->include_count == 0);
+        bool excluded = false;
+
+        for (i = 0; (i < test_filter->pattern_count) && !excluded; i++)
+        {
+            const CTRS_TEST_FILTER_PATTERN* pattern = &test_filter->patterns[i];
+
+            if (pattern->exclude)
+            {
+                excluded = pattern_matches(pattern, test_name);
+            }
+            else if (!included)
+            {
+                included = pattern_matches(pattern, test_name);
+            }
+            else
+            {
+                /*already included, only the exclude patterns still matter*/
+            }
+        }
+
+        result = included && !excluded;
+    }
+
+    return result;
+}
+
+const char* ctrs_test_filter_get_single_name(CTRS_TEST_FILTER_HANDLE test_filter)
+{
+    const char* result;
+
+    if (test_filter == NULL)
+    {
+        LogError("Invalid arguments CTRS_TEST_FILTER_HANDLE test_filter=%p", (void*)test_filter);
+        result = NULL;
+    }
+    else if (
+        (test_filter->pattern_count == 1) &&
+        !test_filter->patterns[0].exclude &&
+        (test_filter->patterns[0].kind == CTRS_TEST_FILTER_PATTERN_KIND_EXACT)
+        )
+    {
+        result = test_filter->patterns[0].text;
+    }
+    else
+    {
+        result = NULL;
+    }
+
+    return result;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "c_logging/logger.h"
+
+#include "ctrs_time.h"
+#include "ctrs_alloc_count.h"
+#include "ctrs_perf_counters.h"
+
+#include "ctrs_test_result.h"
+
+void ctrs_test_metrics_sample(CTRS_TEST_METRICS_SAMPLE* sample)
+{
+    (void)memset(sample, 0, sizeof(CTRS_TEST_METRICS_SAMPLE));
+
+    sample->monotonic_ns = ctrs_time_monotonic_ns();
+    ctrs_alloc_count_get(&sample->allocation_counts);
+    ctrs_perf_counters_read(&sample->perf_counts);
+
+#ifdef _WIN32
+    {
+        FILETIME creation_time;
+        FILETIME exit_time;
+        FILETIME kernel_time;
+        FILETIME user_time;
+
+        /*memory and context switches need psapi/performance counters and are left 0 on Windows*/
+        if (GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+        {
+            ULARGE_INTEGER kernel;
+            ULARGE_INTEGER user;
+            kernel.LowPart = kernel_time.dwLowDateTime;
+            kernel.HighPart = kernel_time.dwHighDateTime;
+            user.LowPart = user_time.dwLowDateTime;
+            user.HighPart = user_time.dwHighDateTime;
+            /*FILETIME is in 100 ns units*/
+            sample->cpu_time_ns = (kernel.QuadPart + user.QuadPart) * 100;
+        }
+    }
+#else
+    {
+        struct rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            LogError("failure in getrusage(RUSAGE_SELF, &usage)");
+        }
+        else
+        {
+            sample->cpu_time_ns =
+                (((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * 1000000000) +
+                (((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * 1000);
+            sample->peak_rss_kb = (int64_t)usage.ru_maxrss; /*kilobytes on Linux*/
+            sample->voluntary_context_switches = (uint64_t)usage.ru_nvcsw;
+            sample->involuntary_context_switches = (uint64_t)usage.ru_nivcsw;
+        }
+    }
+#endif
+}
+
+void ctrs_test_metrics_compute(const CTRS_TEST_METRICS_SAMPLE* before, const CTRS_TEST_METRICS_SAMPLE* after, CTRS_TEST_METRICS* metrics)
+{
+    metrics->wall_time_ns = after->monotonic_ns - before->monotonic_ns;
+    metrics->cpu_time_ns = (after->cpu_time_ns >= before->cpu_time_ns) ? (after->cpu_time_ns - before->cpu_time_ns) : 0;
+    metrics->peak_rss_delta_kb = after->peak_rss_kb - before->peak_rss_kb;
+    metrics->voluntary_context_switches = after->voluntary_context_switches - before->voluntary_context_switches;
+    metrics->involuntary_context_switches = after->involuntary_context_switches - before->involuntary_context_switches;
+    metrics->allocations_counted = ctrs_alloc_count_is_enabled();
+    metrics->allocation_count =
+        (after->allocation_counts.malloc_count - before->allocation_counts.malloc_count) +
+        (after->allocation_counts.calloc_count - before->allocation_counts.calloc_count) +
+        (after->allocation_counts.realloc_count - before->allocation_counts.realloc_count);
+    metrics->free_count = after->allocation_counts.free_count - before->allocation_counts.free_count;
+    metrics->allocated_bytes = after->allocation_counts.allocated_bytes - before->allocation_counts.allocated_bytes;
+    ctrs_perf_counts_delta(&before->perf_counts, &after->perf_counts, &metrics->perf_counts);
+}
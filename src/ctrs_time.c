@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <time.h>
+#endif
+
+#include "ctrs_time.h"
+
+uint64_t ctrs_time_monotonic_ns(void)
+{
+    uint64_t result;
+#ifdef _WIN32
+    static LARGE_INTEGER frequency; /*constant for the lifetime of the system, racing on the first call only writes the same value*/
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+    {
+        (void)QueryPerformanceFrequency(&frequency);
+    }
+    (void)QueryPerformanceCounter(&counter);
+
+    /*split in seconds and remainder so that the multiplication does not overflow*/
+    result = ((uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000) +
+        (((uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000) / (uint64_t)frequency.QuadPart);
+#else
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    result = ((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec;
+#endif
+    return result;
+}
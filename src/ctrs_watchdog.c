@@ -0,0 +1,662 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <dirent.h>
+#include <execinfo.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#endif
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_time.h"
+
+#include "ctrs_watchdog.h"
+
+/*the TEST_FUNCTION_TIMEOUTs of the suite, registered before main*/
+static CTRS_TEST_TIMEOUT* g_registered_test_timeouts;
+
+void ctrs_watchdog_register_test_timeout(CTRS_TEST_TIMEOUT* test_timeout)
+{
+    if (test_timeout == NULL)
+    {
+        LogError("Invalid arguments CTRS_TEST_TIMEOUT* test_timeout=%p", (void*)test_timeout);
+    }
+    else
+    {
+        test_timeout->next_registered = g_registered_test_timeouts;
+        g_registered_test_timeouts = test_timeout;
+    }
+}
+
+bool ctrs_watchdog_any_test_timeout_registered(void)
+{
+    return (g_registered_test_timeouts != NULL);
+}
+
+double ctrs_watchdog_get_test_timeout(const char* test_name, double default_timeout_seconds)
+{
+    double result = default_timeout_seconds;
+
+    if (test_name == NULL)
+    {
+        LogError("Invalid arguments const char* test_name=%s, double default_timeout_seconds=%f", MU_P_OR_NULL(test_name), default_timeout_seconds);
+    }
+    else
+    {
+        const CTRS_TEST_TIMEOUT* current;
+        for (current = g_registered_test_timeouts; current != NULL; current = current->next_registered)
+        {
+            if (strcmp(current->test_name, test_name) == 0)
+            {
+                result = current->timeout_seconds;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+#ifdef _WIN32
+int ctrs_watchdog_arm(const char* test_name, double timeout_seconds)
+{
+    (void)test_name;
+    (void)timeout_seconds;
+    return MU_FAILURE;
+}
+
+void ctrs_watchdog_disarm(void)
+{
+}
+
+void ctrs_watchdog_log_all_thread_backtraces(void)
+{
+    LogWarning("thread backtraces are not available on this platform");
+}
+
+void ctrs_watchdog_add_test_process(int process_id)
+{
+    (void)process_id;
+}
+
+void ctrs_watchdog_remove_test_process(int process_id)
+{
+    (void)process_id;
+}
+
+void ctrs_watchdog_stop(void)
+{
+}
+#else
+/*how long a thread has to log its backtrace*/
+#define BACKTRACE_WAIT_NS 1000000000
+#define BACKTRACE_MAX_FRAMES 64
+
+/*
+Signals sent by the thread of the watchdog: every thread logs its own backtrace from the handler of BACKTRACE_SIGNAL, the thread of a test
+that timed out stops in the handler of STOP_SIGNAL until the process ends. The real time signals at the top of the range are left alone by
+the test code and by the sanitizers.
+*/
+#define BACKTRACE_SIGNAL (SIGRTMAX - 1)
+#define STOP_SIGNAL (SIGRTMAX - 2)
+
+/*
+One thread per process waits for the deadline of the test being run. Tests run on one thread of the process (a forked child of the
+runner), the watchdog watches one test at a time. A test that times out cannot be taken out of its process safely, a longjmp from a signal
+handler would leave locks, allocations and threads of the test behind, so the watchdog ends the process and the runner goes on in a new one.
+*/
+typedef struct CTRS_WATCHDOG_TAG
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed; /*on CLOCK_MONOTONIC, the clock of ctrs_time_monotonic_ns*/
+    pthread_t thread;
+    bool thread_started;
+    bool stopping;
+    bool armed;
+    uint64_t arm_count; /*tells the test that timed out from the next one, when the test ends while its backtraces are logged*/
+    bool timed_out;
+    const char* test_name;
+    double timeout_seconds;
+    uint64_t deadline_ns;
+    pthread_t test_thread;
+    pid_t test_thread_id;
+    pid_t* test_processes; /*the processes the test forked and has not collected yet, killed with it*/
+    size_t test_process_count;
+    size_t test_process_capacity;
+} CTRS_WATCHDOG;
+
+static pthread_once_t g_watchdog_once = PTHREAD_ONCE_INIT;
+static bool g_watchdog_initialized;
+static CTRS_WATCHDOG g_watchdog;
+
+/*one thread logs backtraces at a time, the handler of BACKTRACE_SIGNAL posts g_backtrace_logged when its thread is done*/
+static pthread_mutex_t g_backtrace_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t g_backtrace_logged;
+
+/*posted by the handler of STOP_SIGNAL once the thread of the test stopped*/
+static sem_t g_test_thread_stopped;
+
+static struct timespec get_realtime_deadline(uint64_t wait_ns)
+{
+    struct timespec result;
+
+    (void)clock_gettime(CLOCK_REALTIME, &result);
+    result.tv_nsec += (long)(wait_ns % 1000000000);
+    result.tv_sec += (time_t)(wait_ns / 1000000000) + (result.tv_nsec / 1000000000);
+    result.tv_nsec %= 1000000000;
+
+    return result;
+}
+
+/*
+stops the thread of the test, so that it cannot report a result or go on with the next test, kills and collects the processes of the
+test (the worker processes of a concurrent table test), then ends the process, called with g_watchdog.lock held
+*/
+static void exit_on_timeout(void)
+{
+    size_t i;
+
+    if (pthread_kill(g_watchdog.test_thread, STOP_SIGNAL) != 0)
+    {
+        LogError("cannot stop the thread of test %s", g_watchdog.test_name);
+    }
+    else
+    {
+        struct timespec deadline = get_realtime_deadline(BACKTRACE_WAIT_NS);
+        int wait_result;
+
+        while (((wait_result = sem_timedwait(&g_test_thread_stopped, &deadline)) != 0) && (errno == EINTR))
+        {
+        }
+
+        if (wait_result != 0)
+        {
+            LogError("the thread of test %s did not stop (it blocks the signal, or is stuck in the kernel)", g_watchdog.test_name);
+        }
+    }
+
+    for (i = 0; i < g_watchdog.test_process_count; i++)
+    {
+        if (kill(g_watchdog.test_processes[i], SIGKILL) != 0)
+        {
+            LogError("failure in kill(%d, SIGKILL) for a process of test %s, errno=%d", (int)g_watchdog.test_processes[i], g_watchdog.test_name, errno);
+        }
+        else
+        {
+            /*the thread of the test may be collecting it at the same time, then this one fails with ECHILD*/
+            while ((waitpid(g_watchdog.test_processes[i], NULL, 0) < 0) && (errno == EINTR))
+            {
+            }
+        }
+    }
+
+    (void)fflush(stdout);
+    (void)fflush(stderr);
+    _exit(CTRS_WATCHDOG_TIMEOUT_EXIT_CODE);
+}
+
+static void on_backtrace_signal(int signal_number)
+{
+    void* frames[BACKTRACE_MAX_FRAMES];
+    int saved_errno = errno;
+    int frame_count;
+
+    (void)signal_number;
+
+    frame_count = backtrace(frames, BACKTRACE_MAX_FRAMES);
+    backtrace_symbols_fd(frames, frame_count, STDERR_FILENO);
+    (void)sem_post(&g_backtrace_logged);
+
+    errno = saved_errno;
+}
+
+static void on_stop_signal(int signal_number)
+{
+    (void)signal_number;
+
+    (void)sem_post(&g_test_thread_stopped);
+    for (;;)
+    {
+        (void)pause();
+    }
+}
+
+static int init_watchdog_sync(void)
+{
+    int result;
+    pthread_condattr_t condition_attributes;
+
+    if (pthread_condattr_init(&condition_attributes) != 0)
+    {
+        LogError("failure in pthread_condattr_init");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        if (
+            (pthread_condattr_setclock(&condition_attributes, CLOCK_MONOTONIC) != 0) ||
+            (pthread_cond_init(&g_watchdog.changed, &condition_attributes) != 0)
+            )
+        {
+            LogError("failure initializing the condition variable of the watchdog");
+            result = MU_FAILURE;
+        }
+        else if (pthread_mutex_init(&g_watchdog.lock, NULL) != 0)
+        {
+            LogError("failure in pthread_mutex_init");
+            (void)pthread_cond_destroy(&g_watchdog.changed);
+            result = MU_FAILURE;
+        }
+        else if (sem_init(&g_backtrace_logged, 0, 0) != 0)
+        {
+            LogError("failure in sem_init, errno=%d", errno);
+            (void)pthread_mutex_destroy(&g_watchdog.lock);
+            (void)pthread_cond_destroy(&g_watchdog.changed);
+            result = MU_FAILURE;
+        }
+        else if (sem_init(&g_test_thread_stopped, 0, 0) != 0)
+        {
+            LogError("failure in sem_init, errno=%d", errno);
+            (void)sem_destroy(&g_backtrace_logged);
+            (void)pthread_mutex_destroy(&g_watchdog.lock);
+            (void)pthread_cond_destroy(&g_watchdog.changed);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+        (void)pthread_condattr_destroy(&condition_attributes);
+    }
+
+    return result;
+}
+
+/*
+a forked child (a --fork child, a --jobs worker, a worker of a concurrent table test) has no watchdog thread, the first test it arms starts
+its own, and the processes of the test of its parent are not its own
+*/
+static void reset_watchdog_in_child(void)
+{
+    if (init_watchdog_sync() != 0)
+    {
+        g_watchdog_initialized = false;
+    }
+    (void)pthread_mutex_init(&g_backtrace_lock, NULL);
+    g_watchdog.thread_started = false;
+    g_watchdog.stopping = false;
+    g_watchdog.armed = false;
+    g_watchdog.test_process_count = 0;
+}
+
+static void init_watchdog(void)
+{
+    struct sigaction backtrace_action;
+    struct sigaction stop_action;
+    void* frame;
+
+    (void)memset(&backtrace_action, 0, sizeof(backtrace_action));
+    (void)sigemptyset(&backtrace_action.sa_mask);
+    backtrace_action.sa_flags = SA_RESTART;
+    backtrace_action.sa_handler = on_backtrace_signal;
+
+    (void)memset(&stop_action, 0, sizeof(stop_action));
+    (void)sigemptyset(&stop_action.sa_mask);
+    stop_action.sa_handler = on_stop_signal;
+
+    if (init_watchdog_sync() != 0)
+    {
+        LogError("failure initializing the watchdog");
+    }
+    else if (sigaction(BACKTRACE_SIGNAL, &backtrace_action, NULL) != 0)
+    {
+        LogError("failure in sigaction(BACKTRACE_SIGNAL), errno=%d", errno);
+    }
+    else if (sigaction(STOP_SIGNAL, &stop_action, NULL) != 0)
+    {
+        LogError("failure in sigaction(STOP_SIGNAL), errno=%d", errno);
+    }
+    else if (pthread_atfork(NULL, NULL, reset_watchdog_in_child) != 0)
+    {
+        LogError("failure in pthread_atfork");
+    }
+    else
+    {
+        /*the first backtrace loads the unwinder, which is better not done in a signal handler*/
+        (void)backtrace(&frame, 1);
+        g_watchdog_initialized = true;
+    }
+}
+
+static pid_t get_thread_id(void)
+{
+    return (pid_t)syscall(SYS_gettid);
+}
+
+static void read_thread_name(pid_t thread_id, char* name, size_t name_size)
+{
+    char path[64];
+    FILE* comm;
+
+    (void)snprintf(path, sizeof(path), "/proc/self/task/%d/comm", (int)thread_id);
+    comm = fopen(path, "r");
+    if ((comm == NULL) || (fgets(name, (int)name_size, comm) == NULL))
+    {
+        (void)snprintf(name, name_size, "?");
+    }
+    else
+    {
+        name[strcspn(name, "\n")] = '\0';
+    }
+
+    if (comm != NULL)
+    {
+        (void)fclose(comm);
+    }
+}
+
+static void log_thread_backtrace(pid_t thread_id, pid_t calling_thread_id, pid_t test_thread_id)
+{
+    char name[32];
+
+    read_thread_name(thread_id, name, sizeof(name));
+    (void)fprintf(stderr, "---------- thread %d (%s)%s ----------\n", (int)thread_id, name,
+        (thread_id == test_thread_id) ? ", running the test" : (thread_id == calling_thread_id) ? ", logging the backtraces" : "");
+    (void)fflush(stderr);
+
+    if (thread_id == calling_thread_id)
+    {
+        void* frames[BACKTRACE_MAX_FRAMES];
+        int frame_count = backtrace(frames, BACKTRACE_MAX_FRAMES);
+        backtrace_symbols_fd(frames, frame_count, STDERR_FILENO);
+    }
+    else
+    {
+        /*a late post of a thread that did not answer in time belongs to no one*/
+        while (sem_trywait(&g_backtrace_logged) == 0)
+        {
+        }
+
+        if (syscall(SYS_tgkill, getpid(), thread_id, BACKTRACE_SIGNAL) != 0)
+        {
+            (void)fprintf(stderr, "cannot signal thread %d, errno=%d\n", (int)thread_id, errno);
+        }
+        else
+        {
+            struct timespec deadline = get_realtime_deadline(BACKTRACE_WAIT_NS);
+            int wait_result;
+
+            while (((wait_result = sem_timedwait(&g_backtrace_logged, &deadline)) != 0) && (errno == EINTR))
+            {
+            }
+
+            if (wait_result != 0)
+            {
+                (void)fprintf(stderr, "thread %d did not log its backtrace (it blocks the signal, or is stuck in the kernel)\n", (int)thread_id);
+            }
+        }
+    }
+    (void)fflush(stderr);
+}
+
+/*test_thread_id is the thread marked as running the test, 0 for none*/
+static void log_all_thread_backtraces(pid_t test_thread_id)
+{
+    (void)pthread_once(&g_watchdog_once, init_watchdog);
+
+    if (!g_watchdog_initialized)
+    {
+        LogError("the watchdog could not be initialized, no backtraces");
+    }
+    else
+    {
+        DIR* tasks;
+
+        /*the backtraces go to stderr, what was logged before them should be printed before them*/
+        (void)fflush(stdout);
+
+        (void)pthread_mutex_lock(&g_backtrace_lock);
+
+        tasks = opendir("/proc/self/task");
+        if (tasks == NULL)
+        {
+            LogError("failure in opendir(\"/proc/self/task\"), errno=%d, only the backtrace of the calling thread is logged", errno);
+            log_thread_backtrace(get_thread_id(), get_thread_id(), test_thread_id);
+        }
+        else
+        {
+            pid_t calling_thread_id = get_thread_id();
+            struct dirent* task;
+
+            while ((task = readdir(tasks)) != NULL)
+            {
+                if (task->d_name[0] != '.')
+                {
+                    log_thread_backtrace((pid_t)atoi(task->d_name), calling_thread_id, test_thread_id);
+                }
+            }
+            (void)closedir(tasks);
+        }
+
+        (void)pthread_mutex_unlock(&g_backtrace_lock);
+    }
+}
+
+void ctrs_watchdog_log_all_thread_backtraces(void)
+{
+    log_all_thread_backtraces(0);
+}
+
+static struct timespec to_monotonic_timespec(uint64_t time_ns)
+{
+    struct timespec result;
+    result.tv_sec = (time_t)(time_ns / 1000000000);
+    result.tv_nsec = (long)(time_ns % 1000000000);
+    return result;
+}
+
+static void* watchdog_thread(void* arg)
+{
+    (void)arg;
+
+    (void)pthread_mutex_lock(&g_watchdog.lock);
+    while (!g_watchdog.stopping)
+    {
+        if (!g_watchdog.armed)
+        {
+            (void)pthread_cond_wait(&g_watchdog.changed, &g_watchdog.lock);
+        }
+        else if (ctrs_time_monotonic_ns() < g_watchdog.deadline_ns)
+        {
+            struct timespec deadline = to_monotonic_timespec(g_watchdog.deadline_ns);
+            (void)pthread_cond_timedwait(&g_watchdog.changed, &g_watchdog.lock, &deadline);
+        }
+        else if (!g_watchdog.timed_out)
+        {
+            uint64_t arm_count = g_watchdog.arm_count;
+            const char* test_name = g_watchdog.test_name;
+            pid_t test_thread_id = g_watchdog.test_thread_id;
+
+            g_watchdog.timed_out = true;
+            (void)pthread_mutex_unlock(&g_watchdog.lock);
+
+            LogError("Test %s timed out after %.3f s, backtraces of all the threads of process %d:", test_name, g_watchdog.timeout_seconds, (int)getpid());
+            log_all_thread_backtraces(test_thread_id);
+
+            (void)pthread_mutex_lock(&g_watchdog.lock);
+            if (g_watchdog.armed && (g_watchdog.arm_count == arm_count))
+            {
+                /*the runner reports the test from the exit code and goes on with the next tests in a new child*/
+                LogError("Test %s timed out, killing its process", test_name);
+                exit_on_timeout();
+            }
+            else
+            {
+                /*its result is already reported, ending the process now would fail the next test instead*/
+                LogWarning("Test %s ended while its backtraces were logged, past its deadline", test_name);
+            }
+        }
+        else
+        {
+            /*the test that timed out ended, the next one arms the watchdog again*/
+            (void)pthread_cond_wait(&g_watchdog.changed, &g_watchdog.lock);
+        }
+    }
+    (void)pthread_mutex_unlock(&g_watchdog.lock);
+
+    return NULL;
+}
+
+int ctrs_watchdog_arm(const char* test_name, double timeout_seconds)
+{
+    int result;
+
+    if (
+        (test_name == NULL) ||
+        !(timeout_seconds > 0)
+        )
+    {
+        LogError("Invalid arguments const char* test_name=%s, double timeout_seconds=%f", MU_P_OR_NULL(test_name), timeout_seconds);
+        result = MU_FAILURE;
+    }
+    else if ((pthread_once(&g_watchdog_once, init_watchdog) != 0) || !g_watchdog_initialized)
+    {
+        LogError("the watchdog could not be initialized");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+
+        if (!g_watchdog.thread_started && (pthread_create(&g_watchdog.thread, NULL, watchdog_thread, NULL) != 0))
+        {
+            LogError("failure in pthread_create for the watchdog thread");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            g_watchdog.thread_started = true;
+            g_watchdog.armed = true;
+            g_watchdog.arm_count++;
+            g_watchdog.timed_out = false;
+            g_watchdog.test_name = test_name;
+            g_watchdog.timeout_seconds = timeout_seconds;
+            g_watchdog.deadline_ns = ctrs_time_monotonic_ns() + (uint64_t)(timeout_seconds * 1000000000.0);
+            g_watchdog.test_thread = pthread_self();
+            g_watchdog.test_thread_id = get_thread_id();
+            (void)pthread_cond_signal(&g_watchdog.changed);
+            result = 0;
+        }
+
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+    }
+
+    return result;
+}
+
+void ctrs_watchdog_disarm(void)
+{
+    if (g_watchdog_initialized)
+    {
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+        g_watchdog.armed = false;
+        (void)pthread_cond_signal(&g_watchdog.changed);
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+    }
+}
+
+void ctrs_watchdog_add_test_process(int process_id)
+{
+    /*without a deadline there is no watchdog to kill the process*/
+    if (g_watchdog_initialized)
+    {
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+        if (g_watchdog.test_process_count == g_watchdog.test_process_capacity)
+        {
+            size_t new_capacity = (g_watchdog.test_process_capacity == 0) ? 16 : (2 * g_watchdog.test_process_capacity);
+            pid_t* new_test_processes = realloc(g_watchdog.test_processes, new_capacity * sizeof(pid_t));
+            if (new_test_processes == NULL)
+            {
+                LogError("failure in realloc(%zu), process %d is not killed when the test times out", new_capacity * sizeof(pid_t), process_id);
+            }
+            else
+            {
+                g_watchdog.test_processes = new_test_processes;
+                g_watchdog.test_process_capacity = new_capacity;
+            }
+        }
+
+        if (g_watchdog.test_process_count < g_watchdog.test_process_capacity)
+        {
+            g_watchdog.test_processes[g_watchdog.test_process_count] = (pid_t)process_id;
+            g_watchdog.test_process_count++;
+        }
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+    }
+}
+
+void ctrs_watchdog_remove_test_process(int process_id)
+{
+    if (g_watchdog_initialized)
+    {
+        size_t i;
+
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+        for (i = 0; i < g_watchdog.test_process_count; i++)
+        {
+            if (g_watchdog.test_processes[i] == (pid_t)process_id)
+            {
+                g_watchdog.test_process_count--;
+                g_watchdog.test_processes[i] = g_watchdog.test_processes[g_watchdog.test_process_count];
+                break;
+            }
+        }
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+    }
+}
+
+void ctrs_watchdog_stop(void)
+{
+    if (g_watchdog_initialized)
+    {
+        bool thread_started;
+
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+        thread_started = g_watchdog.thread_started;
+        g_watchdog.stopping = true;
+        (void)pthread_cond_signal(&g_watchdog.changed);
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+
+        if (thread_started)
+        {
+            (void)pthread_join(g_watchdog.thread, NULL);
+        }
+
+        (void)pthread_mutex_lock(&g_watchdog.lock);
+        g_watchdog.thread_started = false;
+        g_watchdog.stopping = false;
+        free(g_watchdog.test_processes);
+        g_watchdog.test_processes = NULL;
+        g_watchdog.test_process_count = 0;
+        g_watchdog.test_process_capacity = 0;
+        (void)pthread_mutex_unlock(&g_watchdog.lock);
+    }
+}
+#endif
@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stddef.h>
+#include <stdio.h>
 #include "testmutex.h"
 
 #include "windows.h"
@@ -11,6 +12,25 @@ TEST_MUTEX_HANDLE testmutex_create(void)
     return (TEST_MUTEX_HANDLE)CreateMutexW(NULL, FALSE, NULL);
 }
 
+TEST_MUTEX_HANDLE testmutex_create_named(const char* name)
+{
+    TEST_MUTEX_HANDLE result;
+    char mutex_name[MAX_PATH];
+
+    /*Local\ is the namespace of the session, where all the test processes of a build run*/
+    int written = (name == NULL) ? -1 : snprintf(mutex_name, sizeof(mutex_name), "Local\\testrunnerswitcher_%s", name);
+    if ((written < 0) || (written >= (int)sizeof(mutex_name)))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = (TEST_MUTEX_HANDLE)CreateMutexA(NULL, FALSE, mutex_name);
+    }
+
+    return result;
+}
+
 int testmutex_acquire(TEST_MUTEX_HANDLE mutex)
 {
     return (WaitForSingleObject(mutex, INFINITE) == WAIT_OBJECT_0) ? 0 : 1;
@@ -0,0 +1,477 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*F_OFD_SETLKW*/
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "macro_utils/macro_utils.h"
+
+#include "c_logging/logger.h"
+
+#include "testmutex.h"
+
+/*
+Without a name (TESTMUTEX_NAME_ENV not set) the mutex only serializes the threads of the process, which is what suites taking it around
+every test need, and keeps ctest -j running such suites in parallel.
+With a name the mutex is also a write lock (fcntl) on the file ${TMPDIR:-/tmp}/testrunnerswitcher_<name>.lock, so it serializes all the
+processes using that name, and the kernel drops it when the processes holding it die (a crashing test does not leave the other test
+processes waiting forever). Every name has one recursive pthread mutex that serializes the threads of the process, shared by all the
+handles created for that name (like the Windows mutex, the same thread can acquire it again).
+
+The lock is an open file description lock (F_OFD_SETLKW), which a forked child shares with its parent through the inherited fd. A child
+(a --fork or --jobs worker, a concurrent case) forked while its parent holds a name runs on behalf of that holder: it enters the mutex
+without waiting for the file lock, and leaves the file lock alone when it releases it. It would otherwise wait for a parent that waits
+for it, for example for the tags a suite took with SUITE_RESOURCE_LOCK_ACQUIRE. For the names its parent did not hold the child opens the
+lock file again, so that it serializes with its parent like with any other process. Without open file description locks (the lock then
+belongs to the process and is not inherited) acquiring a name held by the parent fails at once instead of waiting forever.
+*/
+#ifdef F_OFD_SETLKW
+#define TEST_MUTEX_SET_LOCK_WAIT F_OFD_SETLKW
+#define TEST_MUTEX_LOCK_IS_INHERITED true
+#else
+#define TEST_MUTEX_SET_LOCK_WAIT F_SETLKW
+#define TEST_MUTEX_LOCK_IS_INHERITED false
+#endif
+
+typedef struct TEST_MUTEX_LINUX_TAG
+{
+    struct TEST_MUTEX_LINUX_TAG* next;
+    char* name; /*the name of the lock file, NULL for a mutex that is private to the process*/
+    char* path; /*the path of the lock file, NULL for a mutex that is private to the process*/
+    size_t ref_count;
+    int fd; /*-1 for a mutex that is private to the process*/
+    pthread_mutex_t thread_lock;
+    size_t acquire_depth; /*only touched by the thread holding thread_lock*/
+    bool held_by_parent; /*the process was forked while its parent (or an ancestor) held the file lock*/
+} TEST_MUTEX_LINUX;
+
+static pthread_mutex_t g_test_mutexes_lock = PTHREAD_MUTEX_INITIALIZER;
+static TEST_MUTEX_LINUX* g_test_mutexes;
+static pthread_once_t g_at_fork_once = PTHREAD_ONCE_INIT;
+
+/*
+a forked child (for example a worker of --jobs) starts with every test mutex released by its threads, the file locks its parent held are
+remembered as held_by_parent and the others get a lock file description of the child's own
+*/
+static void reset_test_mutexes_in_child(void)
+{
+    TEST_MUTEX_LINUX* current;
+
+    (void)pthread_mutex_init(&g_test_mutexes_lock, NULL);
+    for (current = g_test_mutexes; current != NULL; current = current->next)
+    {
+        pthread_mutexattr_t attributes;
+        (void)pthread_mutexattr_init(&attributes);
+        (void)pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        (void)pthread_mutex_init(&current->thread_lock, &attributes);
+        (void)pthread_mutexattr_destroy(&attributes);
+
+        if (current->fd >= 0)
+        {
+            current->held_by_parent = current->held_by_parent || (current->acquire_depth > 0);
+            if (!current->held_by_parent)
+            {
+                /*when the file cannot be opened again the child keeps sharing the lock of its parent*/
+                int fd = open(current->path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+                if (fd >= 0)
+                {
+                    (void)close(current->fd);
+                    current->fd = fd;
+                }
+            }
+        }
+        current->acquire_depth = 0;
+    }
+}
+
+static void register_at_fork(void)
+{
+    if (pthread_atfork(NULL, NULL, reset_test_mutexes_in_child) != 0)
+    {
+        LogError("failure in pthread_atfork, test mutexes are not usable in forked processes");
+    }
+}
+
+/*opens the lock file of name and returns its fd, *path is the path of the file (the child of a fork opens it again)*/
+static int open_lock_file(const char* name, char** path)
+{
+    int result;
+    const char* directory = getenv("TMPDIR");
+    size_t path_size;
+
+    if ((directory == NULL) || (directory[0] == '\0'))
+    {
+        directory = "/tmp";
+    }
+
+    path_size = strlen(directory) + sizeof("/testrunnerswitcher_.lock") + strlen(name);
+    *path = malloc(path_size);
+    if (*path == NULL)
+    {
+        LogError("failure in malloc(%zu)", path_size);
+        result = -1;
+    }
+    else
+    {
+        (void)snprintf(*path, path_size, "%s/testrunnerswitcher_%s.lock", directory, name);
+
+        result = open(*path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (result < 0)
+        {
+            LogError("failure in open(%s, O_RDWR | O_CREAT | O_CLOEXEC, 0666), errno=%d", *path, errno);
+            free(*path);
+            *path = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int lock_file(int fd, short lock_type)
+{
+    int result;
+    struct flock file_lock;
+
+    (void)memset(&file_lock, 0, sizeof(file_lock));
+    file_lock.l_type = lock_type;
+    file_lock.l_whence = SEEK_SET;
+    file_lock.l_start = 0;
+    file_lock.l_len = 0; /*whole file*/
+
+    while (((result = fcntl(fd, TEST_MUTEX_SET_LOCK_WAIT, &file_lock)) != 0) && (errno == EINTR))
+    {
+    }
+
+    if (result != 0)
+    {
+        LogError("failure in fcntl(%d, %s, l_type=%d), errno=%d", fd, TEST_MUTEX_LOCK_IS_INHERITED ? "F_OFD_SETLKW" : "F_SETLKW", (int)lock_type, errno);
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+static TEST_MUTEX_LINUX* create_test_mutex(const char* name)
+{
+    TEST_MUTEX_LINUX* result = malloc(sizeof(TEST_MUTEX_LINUX));
+    if (result == NULL)
+    {
+        LogError("failure in malloc(sizeof(TEST_MUTEX_LINUX))");
+    }
+    else
+    {
+        result->name = (name == NULL) ? NULL : malloc(strlen(name) + 1);
+        if ((name != NULL) && (result->name == NULL))
+        {
+            LogError("failure in malloc(%zu)", strlen(name) + 1);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            pthread_mutexattr_t attributes;
+            bool thread_lock_initialized = false;
+
+            if (name != NULL)
+            {
+                (void)strcpy(result->name, name);
+            }
+
+            if (pthread_mutexattr_init(&attributes) != 0)
+            {
+                LogError("failure in pthread_mutexattr_init for %s", MU_P_OR_NULL(name));
+            }
+            else
+            {
+                if (pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE) != 0)
+                {
+                    LogError("failure in pthread_mutexattr_settype(PTHREAD_MUTEX_RECURSIVE) for %s", MU_P_OR_NULL(name));
+                }
+                else if (pthread_mutex_init(&result->thread_lock, &attributes) != 0)
+                {
+                    LogError("failure in pthread_mutex_init for %s", MU_P_OR_NULL(name));
+                }
+                else
+                {
+                    thread_lock_initialized = true;
+                }
+                (void)pthread_mutexattr_destroy(&attributes);
+            }
+
+            if (!thread_lock_initialized)
+            {
+                free(result->name);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->path = NULL;
+                result->fd = (name == NULL) ? -1 : open_lock_file(name, &result->path);
+                if ((name != NULL) && (result->fd < 0))
+                {
+                    /*already logged*/
+                    (void)pthread_mutex_destroy(&result->thread_lock);
+                    free(result->name);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->ref_count = 1;
+                    result->acquire_depth = 0;
+                    result->held_by_parent = false;
+                    result->next = NULL;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+The name comes from the environment, it is kept from escaping the lock directory by turning '/' into '_'. The mutexes of the process are
+looked up by that file name too: two handles on the same lock file must share one fd, because closing any fd of a file drops the fcntl
+lock the process holds on it.
+*/
+static char* get_lock_file_name(const char* name)
+{
+    char* result = malloc(strlen(name) + 1);
+    if (result == NULL)
+    {
+        LogError("failure in malloc(%zu)", strlen(name) + 1);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; name[i] != '\0'; i++)
+        {
+            result[i] = (name[i] == '/') ? '_' : name[i];
+        }
+        result[i] = '\0';
+    }
+    return result;
+}
+
+/*name NULL creates a mutex private to the process*/
+static TEST_MUTEX_HANDLE create_or_reference_test_mutex(const char* name)
+{
+    TEST_MUTEX_LINUX* result;
+    char* lock_file_name = NULL;
+
+    (void)pthread_once(&g_at_fork_once, register_at_fork);
+
+    if ((name != NULL) && ((lock_file_name = get_lock_file_name(name)) == NULL))
+    {
+        LogError("failure making the lock file name of test mutex %s", name);
+        result = NULL;
+    }
+    else if (pthread_mutex_lock(&g_test_mutexes_lock) != 0)
+    {
+        LogError("failure in pthread_mutex_lock(&g_test_mutexes_lock)");
+        result = NULL;
+    }
+    else
+    {
+        result = NULL;
+        if (lock_file_name != NULL)
+        {
+            for (result = g_test_mutexes; result != NULL; result = result->next)
+            {
+                if ((result->name != NULL) && (strcmp(result->name, lock_file_name) == 0))
+                {
+                    break;
+                }
+            }
+        }
+
+        if (result != NULL)
+        {
+            result->ref_count++;
+        }
+        else
+        {
+            result = create_test_mutex(lock_file_name);
+            if (result != NULL)
+            {
+                result->next = g_test_mutexes;
+                g_test_mutexes = result;
+            }
+        }
+
+        (void)pthread_mutex_unlock(&g_test_mutexes_lock);
+    }
+
+    free(lock_file_name);
+    return (TEST_MUTEX_HANDLE)result;
+}
+
+TEST_MUTEX_HANDLE testmutex_create(void)
+{
+    const char* name = getenv(TESTMUTEX_NAME_ENV);
+    return create_or_reference_test_mutex(((name != NULL) && (name[0] != '\0')) ? name : NULL);
+}
+
+TEST_MUTEX_HANDLE testmutex_create_named(const char* name)
+{
+    TEST_MUTEX_HANDLE result;
+
+    if ((name == NULL) || (name[0] == '\0'))
+    {
+        LogError("Invalid arguments const char* name=%s", MU_P_OR_NULL(name));
+        result = NULL;
+    }
+    else
+    {
+        result = create_or_reference_test_mutex(name);
+    }
+
+    return result;
+}
+
+int testmutex_acquire(TEST_MUTEX_HANDLE mutex)
+{
+    int result;
+    TEST_MUTEX_LINUX* test_mutex = (TEST_MUTEX_LINUX*)mutex;
+
+    if (test_mutex == NULL)
+    {
+        LogError("Invalid arguments TEST_MUTEX_HANDLE mutex=%p", mutex);
+        result = MU_FAILURE;
+    }
+    else if (pthread_mutex_lock(&test_mutex->thread_lock) != 0)
+    {
+        LogError("failure in pthread_mutex_lock for test mutex %s", MU_P_OR_NULL(test_mutex->name));
+        result = MU_FAILURE;
+    }
+    else
+    {
+        if (test_mutex->acquire_depth > 0)
+        {
+            /*this thread already holds the file lock*/
+            test_mutex->acquire_depth++;
+            result = 0;
+        }
+        else if (test_mutex->held_by_parent && !TEST_MUTEX_LOCK_IS_INHERITED)
+        {
+            LogError("test mutex %s is held by the parent of this forked process, which would wait for it forever", MU_P_OR_NULL(test_mutex->name));
+            (void)pthread_mutex_unlock(&test_mutex->thread_lock);
+            result = MU_FAILURE;
+        }
+        else if (test_mutex->held_by_parent)
+        {
+            /*the file lock of the parent is the lock of this process too*/
+            test_mutex->acquire_depth = 1;
+            result = 0;
+        }
+        else if ((test_mutex->fd >= 0) && (lock_file(test_mutex->fd, F_WRLCK) != 0))
+        {
+            LogError("failure locking the file of test mutex %s", MU_P_OR_NULL(test_mutex->name));
+            (void)pthread_mutex_unlock(&test_mutex->thread_lock);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            test_mutex->acquire_depth = 1;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int testmutex_release(TEST_MUTEX_HANDLE mutex)
+{
+    int result;
+    TEST_MUTEX_LINUX* test_mutex = (TEST_MUTEX_LINUX*)mutex;
+
+    if (test_mutex == NULL)
+    {
+        LogError("Invalid arguments TEST_MUTEX_HANDLE mutex=%p", mutex);
+        result = MU_FAILURE;
+    }
+    else if (pthread_mutex_trylock(&test_mutex->thread_lock) != 0)
+    {
+        /*another thread holds it, acquire_depth is not this thread's to change (ReleaseMutex fails the same way on Windows)*/
+        LogError("test mutex %s is released by a thread that does not hold it", MU_P_OR_NULL(test_mutex->name));
+        result = MU_FAILURE;
+    }
+    else if (test_mutex->acquire_depth == 0)
+    {
+        LogError("test mutex %s is released without being acquired", MU_P_OR_NULL(test_mutex->name));
+        (void)pthread_mutex_unlock(&test_mutex->thread_lock);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        /*the trylock above only added one to the recursion count of this thread*/
+        (void)pthread_mutex_unlock(&test_mutex->thread_lock);
+
+        test_mutex->acquire_depth--;
+        /*the file lock of the parent stays with the parent*/
+        if ((test_mutex->acquire_depth == 0) && (test_mutex->fd >= 0) && !test_mutex->held_by_parent && (lock_file(test_mutex->fd, F_UNLCK) != 0))
+        {
+            LogError("failure unlocking the file of test mutex %s", MU_P_OR_NULL(test_mutex->name));
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+        (void)pthread_mutex_unlock(&test_mutex->thread_lock);
+    }
+
+    return result;
+}
+
+void testmutex_destroy(TEST_MUTEX_HANDLE mutex)
+{
+    TEST_MUTEX_LINUX* test_mutex = (TEST_MUTEX_LINUX*)mutex;
+
+    if (test_mutex == NULL)
+    {
+        LogError("Invalid arguments TEST_MUTEX_HANDLE mutex=%p", mutex);
+    }
+    else if (pthread_mutex_lock(&g_test_mutexes_lock) != 0)
+    {
+        LogError("failure in pthread_mutex_lock(&g_test_mutexes_lock)");
+    }
+    else
+    {
+        test_mutex->ref_count--;
+        if (test_mutex->ref_count == 0)
+        {
+            TEST_MUTEX_LINUX** current;
+            for (current = &g_test_mutexes; *current != NULL; current = &(*current)->next)
+            {
+                if (*current == test_mutex)
+                {
+                    *current = test_mutex->next;
+                    break;
+                }
+            }
+
+            if (test_mutex->fd >= 0)
+            {
+                /*closing the file drops the lock if it is still held*/
+                (void)close(test_mutex->fd);
+            }
+            (void)pthread_mutex_destroy(&test_mutex->thread_lock);
+            free(test_mutex->path);
+            free(test_mutex->name);
+            free(test_mutex);
+        }
+
+        (void)pthread_mutex_unlock(&g_test_mutexes_lock);
+    }
+}
@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "testrunnerswitcher.h"
+
+/*the allocations are stored here so that the compiler cannot drop a malloc/free pair*/
+static void* volatile g_allocated[3];
+
+#ifndef CPP_UNITTEST
+/*
+makes malloc_count allocations of 8 bytes and checks them with ASSERT_ALLOCATIONS_AT_MOST(max_allocations), returns true when the assertion failed.
+A failed assertion of ctest longjmps to g_ExceptionJump, it is caught here to check that it happens (cppunittest throws instead)
+*/
+static bool allocations_at_most_fails(size_t malloc_count, uint64_t max_allocations)
+{
+    jmp_buf saved_exception_jump;
+    volatile bool failed = false;
+    size_t i;
+    ALLOCATION_REGION_BEGIN();
+
+    for (i = 0; i < malloc_count; i++)
+    {
+        g_allocated[i] = malloc(8);
+    }
+
+    (void)memcpy(saved_exception_jump, g_ExceptionJump, sizeof(jmp_buf));
+    if (setjmp(g_ExceptionJump) == 0)
+    {
+        ASSERT_ALLOCATIONS_AT_MOST(max_allocations);
+    }
+    else
+    {
+        failed = true;
+    }
+    (void)memcpy(g_ExceptionJump, saved_exception_jump, sizeof(jmp_buf));
+
+    for (i = 0; i < malloc_count; i++)
+    {
+        free(g_allocated[i]);
+    }
+
+    return failed;
+}
+#endif
+
+BEGIN_TEST_SUITE(alloc_count_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+}
+
+TEST_FUNCTION(alloc_count_counts_malloc_calloc_realloc_and_free)
+{
+    ///arrange
+    CTRS_ALLOCATION_COUNTS before;
+    CTRS_ALLOCATION_COUNTS after;
+    ctrs_alloc_count_get(&before);
+
+    ///act
+    g_allocated[0] = malloc(16);
+    g_allocated[1] = calloc(2, 8);
+    g_allocated[0] = realloc(g_allocated[0], 32);
+    free(g_allocated[0]);
+    free(g_allocated[1]);
+    ctrs_alloc_count_get(&after);
+
+    ///assert
+    if (ctrs_alloc_count_is_enabled())
+    {
+        ASSERT_IS_TRUE(after.malloc_count - before.malloc_count == 1);
+        ASSERT_IS_TRUE(after.calloc_count - before.calloc_count == 1);
+        ASSERT_IS_TRUE(after.realloc_count - before.realloc_count == 1);
+        ASSERT_IS_TRUE(after.free_count - before.free_count == 2);
+        ASSERT_IS_TRUE(after.allocated_bytes - before.allocated_bytes == 16 + 2 * 8 + 32);
+    }
+    else
+    {
+        ASSERT_IS_TRUE(after.malloc_count == before.malloc_count);
+        ASSERT_IS_TRUE(after.allocated_bytes == before.allocated_bytes);
+    }
+}
+
+TEST_FUNCTION(alloc_count_free_of_NULL_is_not_counted)
+{
+    ///arrange
+    CTRS_ALLOCATION_COUNTS before;
+    CTRS_ALLOCATION_COUNTS after;
+    ctrs_alloc_count_get(&before);
+
+    ///act
+    g_allocated[0] = NULL;
+    free(g_allocated[0]);
+    ctrs_alloc_count_get(&after);
+
+    ///assert
+    ASSERT_IS_TRUE(after.free_count == before.free_count);
+}
+
+TEST_FUNCTION(ASSERT_ALLOCATIONS_AT_MOST_passes_within_the_budget)
+{
+    ///arrange
+    ALLOCATION_REGION_BEGIN();
+
+    ///act
+    g_allocated[0] = malloc(100);
+    g_allocated[1] = malloc(28);
+    free(g_allocated[1]);
+    free(g_allocated[0]);
+
+    ///assert
+    ASSERT_ALLOCATIONS_AT_MOST(2);
+    ASSERT_ALLOCATED_BYTES_AT_MOST(128);
+}
+
+TEST_FUNCTION(alloc_count_counts_every_malloc_of_the_region)
+{
+    ///arrange
+    CTRS_ALLOCATION_COUNTS before;
+    CTRS_ALLOCATION_COUNTS after;
+    size_t i;
+    ctrs_alloc_count_get(&before);
+
+    ///act
+    for (i = 0; i < 3; i++)
+    {
+        g_allocated[i] = malloc(10 * (i + 1));
+    }
+    ctrs_alloc_count_get(&after);
+    for (i = 0; i < 3; i++)
+    {
+        free(g_allocated[i]);
+    }
+
+    ///assert
+    ASSERT_IS_TRUE(after.malloc_count - before.malloc_count == (ctrs_alloc_count_is_enabled() ? 3 : 0));
+    ASSERT_IS_TRUE(after.calloc_count == before.calloc_count);
+    ASSERT_IS_TRUE(after.realloc_count == before.realloc_count);
+    ASSERT_IS_TRUE(after.allocated_bytes - before.allocated_bytes == (ctrs_alloc_count_is_enabled() ? 10 + 20 + 30 : 0));
+}
+
+#ifndef CPP_UNITTEST
+TEST_FUNCTION(ASSERT_ALLOCATIONS_AT_MOST_fails_over_the_budget)
+{
+    ///arrange
+
+    ///act
+    bool failed = allocations_at_most_fails(3, 2);
+
+    ///assert
+    /*an exe that does not count allocations passes every budget*/
+    ASSERT_IS_TRUE(failed == ctrs_alloc_count_is_enabled());
+}
+
+TEST_FUNCTION(ASSERT_ALLOCATIONS_AT_MOST_passes_at_exactly_the_budget)
+{
+    ///arrange
+
+    ///act
+    bool failed = allocations_at_most_fails(3, 3);
+
+    ///assert
+    ASSERT_IS_FALSE(failed);
+}
+#endif
+
+TEST_FUNCTION(ASSERT_ALLOCATIONS_AT_MOST_0_passes_for_code_that_does_not_allocate)
+{
+    ///arrange
+    int values[8] = { 5, 3, 8, 1, 9, 2, 7, 4 };
+    int max = values[0];
+    size_t i;
+    ALLOCATION_REGION_BEGIN();
+
+    ///act
+    for (i = 1; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        if (values[i] > max)
+        {
+            max = values[i];
+        }
+    }
+
+    ///assert
+    ASSERT_ALLOCATIONS_AT_MOST(0);
+    ASSERT_ALLOCATED_BYTES_AT_MOST(0);
+    ASSERT_ARE_EQUAL(int, 9, max);
+}
+
+TEST_FUNCTION(alloc_count_allocations_since_counts_only_the_region)
+{
+    ///arrange
+    ALLOCATION_REGION_BEGIN();
+
+    ///act
+    g_allocated[0] = malloc(8);
+    free(g_allocated[0]);
+
+    ///assert
+    ASSERT_IS_TRUE(ctrs_alloc_count_allocations_since(&ctrs_allocation_region_start) == (ctrs_alloc_count_is_enabled() ? 1 : 0));
+    ASSERT_IS_TRUE(ctrs_alloc_count_allocated_bytes_since(&ctrs_allocation_region_start) == (ctrs_alloc_count_is_enabled() ? 8 : 0));
+}
+
+END_TEST_SUITE(alloc_count_ut)
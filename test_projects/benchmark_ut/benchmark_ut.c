@@ -0,0 +1,291 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_perf_baseline.h"
+
+#define TEST_BASELINE_FILE "benchmark_ut_test_baseline.txt"
+
+static uint64_t g_loop_iterations;
+
+static void write_test_baseline(const char* content)
+{
+    FILE* file = fopen(TEST_BASELINE_FILE, "w");
+    ASSERT_IS_NOT_NULL(file);
+    (void)fputs(content, file);
+    (void)fclose(file);
+}
+
+static uint32_t hash_bytes(const unsigned char* bytes, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+BEGIN_TEST_SUITE(benchmark_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    g_loop_iterations = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+}
+
+BENCHMARK_FUNCTION(benchmark_function_runs_the_loop) // no-srs // no-aaa
+{
+    unsigned char buffer[64] = { 0 };
+
+    BENCHMARK_LOOP
+    {
+        uint32_t hash = hash_bytes(buffer, sizeof(buffer));
+        BENCHMARK_DO_NOT_OPTIMIZE(hash);
+        g_loop_iterations++;
+    }
+
+    /*warmup + at least CTRS_BENCHMARK_MIN_SAMPLES samples of at least 1 iteration*/
+    ASSERT_IS_TRUE(g_loop_iterations > CTRS_BENCHMARK_MIN_SAMPLES);
+}
+
+PARAMETERIZED_BENCHMARK_FUNCTION(parameterized_benchmark_function_gets_its_arguments, // no-srs // no-aaa
+    ARGS(int, length),
+    CASE((16), length_16),
+    CASE((256), length_256))
+{
+    unsigned char buffer[256] = { 0 };
+
+    BENCHMARK_LOOP
+    {
+        uint32_t hash = hash_bytes(buffer, (size_t)length);
+        BENCHMARK_DO_NOT_OPTIMIZE(hash);
+    }
+
+    ASSERT_IS_TRUE((length == 16) || (length == 256));
+}
+
+TEST_FUNCTION(ctrs_benchmark_statistics_are_ordered) // no-srs
+{
+    ///arrange
+    CTRS_BENCHMARK benchmark;
+    unsigned char buffer[32] = { 0 };
+    ctrs_benchmark_begin(&benchmark, "ctrs_benchmark_statistics_are_ordered");
+
+    ///act
+    while (ctrs_benchmark_keep_running(&benchmark))
+    {
+        uint32_t hash = hash_bytes(buffer, sizeof(buffer));
+        BENCHMARK_DO_NOT_OPTIMIZE(hash);
+    }
+    int result = ctrs_benchmark_end(&benchmark);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(benchmark.statistics.sample_count >= CTRS_BENCHMARK_MIN_SAMPLES);
+    ASSERT_IS_TRUE(benchmark.statistics.iterations_per_sample >= 1);
+    ASSERT_IS_TRUE(benchmark.statistics.min_ns <= benchmark.statistics.median_ns);
+    ASSERT_IS_TRUE(benchmark.statistics.median_ns <= benchmark.statistics.p99_ns);
+    ASSERT_IS_TRUE(benchmark.statistics.min_ns <= benchmark.statistics.mean_ns);
+    ASSERT_IS_TRUE(benchmark.statistics.mean_ns <= benchmark.statistics.p99_ns);
+    ASSERT_IS_TRUE(benchmark.statistics.stddev_ns >= 0);
+    ASSERT_IS_TRUE(benchmark.statistics.ops_per_second > 0);
+}
+
+TEST_FUNCTION(ctrs_benchmark_end_fails_when_the_loop_did_not_run) // no-srs
+{
+    ///arrange
+    CTRS_BENCHMARK benchmark;
+    ctrs_benchmark_begin(&benchmark, "ctrs_benchmark_end_fails_when_the_loop_did_not_run");
+
+    ///act
+    int result = ctrs_benchmark_end(&benchmark);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_benchmark_counts_the_hardware_events_of_the_measured_iterations) // no-srs
+{
+    ///arrange
+    CTRS_BENCHMARK benchmark;
+    unsigned char buffer[32] = { 0 };
+
+    /*the kernel forbids the counters (or CTRS_PERF_COUNTERS is not set), nothing to check*/
+    if (!ctrs_perf_counters_are_available())
+    {
+        return;
+    }
+
+    ctrs_benchmark_begin(&benchmark, "ctrs_benchmark_counts_the_hardware_events_of_the_measured_iterations");
+
+    ///act
+    while (ctrs_benchmark_keep_running(&benchmark))
+    {
+        uint32_t hash = hash_bytes(buffer, sizeof(buffer));
+        BENCHMARK_DO_NOT_OPTIMIZE(hash);
+    }
+    int result = ctrs_benchmark_end(&benchmark);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(ctrs_perf_counts_any_counted(&benchmark.statistics.perf_counts));
+    ASSERT_IS_TRUE(benchmark.statistics.measured_iterations == benchmark.statistics.sample_count * benchmark.statistics.iterations_per_sample);
+    if (benchmark.statistics.perf_counts.counted[CTRS_PERF_COUNTER_INSTRUCTIONS])
+    {
+        /*hashing 32 bytes takes more than 32 instructions*/
+        ASSERT_IS_TRUE(benchmark.statistics.perf_counts.values[CTRS_PERF_COUNTER_INSTRUCTIONS] > 32 * benchmark.statistics.measured_iterations);
+    }
+}
+
+TEST_FUNCTION(ctrs_perf_counts_delta_keeps_the_counters_counted_in_both) // no-srs
+{
+    ///arrange
+    CTRS_PERF_COUNTS before = { { true, true, false, true }, { 100, 1000, 0, 5 } };
+    CTRS_PERF_COUNTS after = { { true, true, true, false }, { 300, 1500, 7, 0 } };
+    CTRS_PERF_COUNTS delta;
+
+    ///act
+    ctrs_perf_counts_delta(&before, &after, &delta);
+
+    ///assert
+    ASSERT_IS_TRUE(delta.counted[CTRS_PERF_COUNTER_CYCLES]);
+    ASSERT_IS_TRUE(delta.values[CTRS_PERF_COUNTER_CYCLES] == 200);
+    ASSERT_IS_TRUE(delta.counted[CTRS_PERF_COUNTER_INSTRUCTIONS]);
+    ASSERT_IS_TRUE(delta.values[CTRS_PERF_COUNTER_INSTRUCTIONS] == 500);
+    ASSERT_IS_FALSE(delta.counted[CTRS_PERF_COUNTER_CACHE_MISSES]);
+    ASSERT_IS_FALSE(delta.counted[CTRS_PERF_COUNTER_BRANCH_MISSES]);
+}
+
+TEST_FUNCTION(ctrs_perf_counts_format_divides_and_adds_the_IPC) // no-srs
+{
+    ///arrange
+    CTRS_PERF_COUNTS counts = { { true, true, false, true }, { 400, 1000, 0, 8 } };
+    char formatted[256];
+
+    ///act
+    ctrs_perf_counts_format(&counts, 4, formatted, sizeof(formatted));
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "cycles=100.00 instructions=250.00 IPC=2.50 branch_misses=2.00", formatted);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_check_passes_within_the_tolerance) // no-srs
+{
+    ///arrange
+    write_test_baseline("# comment\n\nsome_benchmark 100.0\n");
+
+    ///act
+    int result = ctrs_perf_baseline_check(TEST_BASELINE_FILE, 10.0, "some_benchmark", 109.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    (void)remove(TEST_BASELINE_FILE);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_check_fails_over_the_tolerance) // no-srs
+{
+    ///arrange
+    write_test_baseline("other_benchmark 1.0\nsome_benchmark 100.0\n");
+
+    ///act
+    int result = ctrs_perf_baseline_check(TEST_BASELINE_FILE, 10.0, "some_benchmark", 111.0);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    (void)remove(TEST_BASELINE_FILE);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_check_uses_the_tolerance_of_the_line) // no-srs
+{
+    ///arrange
+    write_test_baseline("some_benchmark 100.0 50\n");
+
+    ///act
+    int result = ctrs_perf_baseline_check(TEST_BASELINE_FILE, 10.0, "some_benchmark", 140.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    (void)remove(TEST_BASELINE_FILE);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_check_passes_a_benchmark_without_baseline) // no-srs
+{
+    ///arrange
+    write_test_baseline("other_benchmark 1.0\n");
+
+    ///act
+    int result = ctrs_perf_baseline_check(TEST_BASELINE_FILE, 10.0, "some_benchmark", 1000.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    (void)remove(TEST_BASELINE_FILE);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_check_fails_when_the_file_is_missing) // no-srs
+{
+    ///arrange
+    (void)remove(TEST_BASELINE_FILE);
+
+    ///act
+    int result = ctrs_perf_baseline_check(TEST_BASELINE_FILE, 10.0, "some_benchmark", 1.0);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_perf_baseline_append_writes_lines_that_check_reads) // no-srs
+{
+    ///arrange
+    (void)remove(TEST_BASELINE_FILE);
+
+    ///act
+    int result_1 = ctrs_perf_baseline_append(TEST_BASELINE_FILE, "first_benchmark", 10.0);
+    int result_2 = ctrs_perf_baseline_append(TEST_BASELINE_FILE, "second_benchmark", 20.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_perf_baseline_check(TEST_BASELINE_FILE, 0.0, "first_benchmark", 10.0));
+    ASSERT_ARE_NOT_EQUAL(int, 0, ctrs_perf_baseline_check(TEST_BASELINE_FILE, 0.0, "second_benchmark", 21.0));
+
+    ///cleanup
+    (void)remove(TEST_BASELINE_FILE);
+}
+
+END_TEST_SUITE(benchmark_ut)
@@ -0,0 +1,271 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_data_table.h"
+
+#define CASE_COUNT 4
+
+typedef struct SUM_ROW_TAG
+{
+    int a;
+    int b;
+    int sum;
+} SUM_ROW;
+
+static const SUM_ROW sum_rows[] =
+{
+    { 0, 0, 0 },
+    { 1, 2, 3 },
+    { -5, 3, -2 },
+    { 10, 20, 30 }
+};
+
+/*set by the function initialize, the cases see it in their worker, what they change stays in their worker*/
+static int g_fixture_value;
+static int g_rows_run;
+
+static void sleep_ms(unsigned int milliseconds)
+{
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    (void)usleep(milliseconds * 1000);
+#endif
+}
+
+static void count_row(const void* row)
+{
+    (void)row;
+    g_rows_run++;
+}
+
+static void fail_row_with_negative_a(const void* row)
+{
+    const SUM_ROW* sum_row = (const SUM_ROW*)row;
+    g_rows_run++;
+    ASSERT_IS_TRUE(sum_row->a >= 0);
+}
+
+static CTRS_DATA_TABLE make_concurrent_table(void(*run_row)(const void* row))
+{
+    CTRS_DATA_TABLE table;
+    (void)memset(&table, 0, sizeof(table));
+    table.test_name = "hand_made";
+    table.source = CTRS_DATA_TABLE_SOURCE_ARRAY;
+    table.rows = sum_rows;
+    table.row_count = sizeof(sum_rows) / sizeof(sum_rows[0]);
+    table.row_size = sizeof(SUM_ROW);
+    table.concurrent = true;
+    table.run_row = run_row;
+    return table;
+}
+
+#ifndef _WIN32
+/*one file per case of cases_run_at_the_same_time, named after the test process the workers are forked from*/
+static void get_marker_file_name(char* file_name, size_t file_name_size, pid_t test_process_id, int case_index)
+{
+    (void)snprintf(file_name, file_name_size, "concurrent_cases_ut_%d_%d.marker", (int)test_process_id, case_index);
+}
+#endif
+
+BEGIN_TEST_SUITE(concurrent_cases_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+#ifndef _WIN32
+    /*the cases wait for each other, they need as many workers as there are cases whatever the number of processors*/
+    ASSERT_ARE_EQUAL(int, 0, setenv(CTRS_CONCURRENT_JOBS_ENV, MU_TOSTRING(CASE_COUNT), 1));
+#endif
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    g_fixture_value = 42;
+    g_rows_run = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+#ifndef _WIN32
+    char file_name[128];
+    int i;
+
+    for (i = 0; i < CASE_COUNT; i++)
+    {
+        get_marker_file_name(file_name, sizeof(file_name), getpid(), i);
+        (void)remove(file_name);
+    }
+#endif
+}
+
+CONCURRENT_PARAMETERIZED_TEST_FUNCTION(cases_get_their_arguments,
+    ARGS(int, a, int, b, int, sum),
+    CASE((1, 2, 3), small),
+    CASE((10, 20, 30), large),
+    CASE((-1, 1, 0), zero))
+{
+    ASSERT_ARE_EQUAL(int, sum, a + b);
+}
+
+CONCURRENT_PARAMETERIZED_TEST_FUNCTION(cases_finish_in_any_order,
+    ARGS(int, delay_ms, const char*, name),
+    CASE((150, "first"), first),
+    CASE((100, "second"), second),
+    CASE((50, "third"), third),
+    CASE((0, "fourth"), fourth))
+{
+    sleep_ms((unsigned int)delay_ms);
+    (void)printf("case %s done\n", name);
+}
+
+CONCURRENT_TABLE_TEST_FUNCTION(table_rows_add_up, SUM_ROW, sum_rows)
+{
+    ASSERT_ARE_EQUAL(int, row->sum, row->a + row->b);
+}
+
+#ifndef _WIN32
+CONCURRENT_PARAMETERIZED_TEST_FUNCTION(cases_start_from_the_fixture_and_do_not_see_each_other,
+    ARGS(int, value),
+    CASE((1), one),
+    CASE((2), two),
+    CASE((3), three))
+{
+    ASSERT_ARE_EQUAL(int, 42, g_fixture_value);
+    g_fixture_value = value;
+    sleep_ms(50);
+    ASSERT_ARE_EQUAL(int, value, g_fixture_value);
+}
+
+/*every case waits until all the cases have started, which only ends when they run at the same time*/
+CONCURRENT_PARAMETERIZED_TEST_FUNCTION(cases_run_at_the_same_time,
+    ARGS(int, case_index),
+    CASE((0), case_0),
+    CASE((1), case_1),
+    CASE((2), case_2),
+    CASE((3), case_3))
+{
+    char file_name[128];
+    int started_count = 0;
+    int i;
+    time_t give_up = time(NULL) + 30;
+    FILE* marker;
+
+    get_marker_file_name(file_name, sizeof(file_name), getppid(), case_index);
+    marker = fopen(file_name, "w");
+    ASSERT_IS_NOT_NULL(marker);
+    (void)fclose(marker);
+
+    while ((started_count < CASE_COUNT) && (time(NULL) < give_up))
+    {
+        started_count = 0;
+        for (i = 0; i < CASE_COUNT; i++)
+        {
+            get_marker_file_name(file_name, sizeof(file_name), getppid(), i);
+            marker = fopen(file_name, "r");
+            if (marker != NULL)
+            {
+                (void)fclose(marker);
+                started_count++;
+            }
+        }
+        sleep_ms(10);
+    }
+
+    ASSERT_ARE_EQUAL(int, CASE_COUNT, started_count);
+}
+
+/* ctrs_data_table_run */
+
+TEST_FUNCTION(ctrs_data_table_run_of_a_concurrent_table_runs_the_rows_in_workers)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_concurrent_table(count_row);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, g_rows_run); /*each row counted in its own worker*/
+}
+#endif
+
+TEST_FUNCTION(ctrs_data_table_run_of_a_concurrent_table_fails_when_a_row_fails)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_concurrent_table(fail_row_with_negative_a);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_of_a_concurrent_table_runs_only_the_selected_row_in_the_test_process)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_concurrent_table(count_row);
+    ctrs_data_table_select_row(&table, 2);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 1, g_rows_run);
+
+    ///cleanup
+    ctrs_data_table_select_row(NULL, 0);
+}
+
+TEST_FUNCTION(concurrent_cases_are_named_after_their_suffix)
+{
+    ///arrange
+    CTRS_DATA_TABLE* table = ctrs_data_table_find("cases_get_their_arguments");
+    ASSERT_IS_NOT_NULL(table);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_data_table_load(table));
+
+    ///act
+    const char* first_name = ctrs_data_table_get_row_name(table, 0);
+    const char* last_name = ctrs_data_table_get_row_name(table, 2);
+
+    ///assert
+    ASSERT_IS_TRUE(table->concurrent);
+    ASSERT_ARE_EQUAL(int, 3, (int)table->row_count);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("cases_get_their_arguments_small", first_name));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("cases_get_their_arguments_zero", last_name));
+
+    ///cleanup
+    ctrs_data_table_unload(table);
+}
+
+END_TEST_SUITE(concurrent_cases_ut)
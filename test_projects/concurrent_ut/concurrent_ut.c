@@ -0,0 +1,247 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_concurrent.h"
+
+#define SLOT_COUNT 64
+#define ITERATIONS 100000
+
+/*every thread only writes its own slot, so the threads need no synchronization*/
+static uint64_t g_slots[SLOT_COUNT];
+static size_t g_seen_thread_count;
+
+static void increment_own_slot(void)
+{
+    size_t thread_index = CONCURRENT_THREAD_INDEX();
+    CONCURRENT_ASSERT_IS_TRUE(thread_index < SLOT_COUNT, "thread %zu has no slot", thread_index);
+    g_slots[thread_index]++;
+}
+
+static void fail_on_thread_1(void)
+{
+    CONCURRENT_ASSERT_IS_TRUE(CONCURRENT_THREAD_INDEX() != 1, "thread 1 always fails");
+    g_slots[CONCURRENT_THREAD_INDEX()]++;
+}
+
+static void record_thread_count(void)
+{
+    if (CONCURRENT_THREAD_INDEX() == 0)
+    {
+        g_seen_thread_count = CONCURRENT_THREAD_COUNT();
+    }
+}
+
+BEGIN_TEST_SUITE(concurrent_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    (void)memset(g_slots, 0, sizeof(g_slots));
+    g_seen_thread_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+}
+
+TEST_FUNCTION_CONCURRENT(concurrent_threads_fill_their_own_slots, 4)
+{
+    size_t thread_index = CONCURRENT_THREAD_INDEX();
+    uint64_t i;
+
+    CONCURRENT_ASSERT_IS_TRUE(thread_index < CONCURRENT_THREAD_COUNT());
+    CONCURRENT_ASSERT_IS_TRUE(thread_index < SLOT_COUNT, "thread %zu has no slot", thread_index);
+
+    for (i = 0; i < ITERATIONS; i++)
+    {
+        g_slots[thread_index]++;
+    }
+    CONCURRENT_ADD_OPERATIONS(ITERATIONS);
+}
+
+/*CONCURRENT_UT_HANG is only set for the run that checks the watchdog (see CMakeLists.txt), which kills the child running the test after
+2 seconds, threads and all*/
+TEST_FUNCTION_TIMEOUT(concurrent_threads_stuck_past_their_deadline_fail_the_test, 2)
+TEST_FUNCTION_CONCURRENT(concurrent_threads_stuck_past_their_deadline_fail_the_test, 2)
+{
+#ifndef _WIN32
+    while (getenv("CONCURRENT_UT_HANG") != NULL)
+    {
+        (void)sleep(1);
+    }
+#endif
+}
+
+TEST_FUNCTION(ctrs_concurrent_run_runs_the_body_once_on_every_thread)
+{
+    ///arrange
+    size_t i;
+
+    ///act
+    int result = ctrs_concurrent_run("increment_own_slot", 3, increment_own_slot);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    for (i = 0; i < 3; i++)
+    {
+        ASSERT_IS_TRUE(g_slots[i] == 1, "slot %zu", i);
+    }
+    ASSERT_IS_TRUE(g_slots[3] == 0);
+}
+
+TEST_FUNCTION(ctrs_concurrent_run_fails_when_one_thread_fails)
+{
+    ///arrange
+
+    ///act
+    int result = ctrs_concurrent_run("fail_on_thread_1", 3, fail_on_thread_1);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    /*the failure ends the body of its thread only*/
+    ASSERT_IS_TRUE(g_slots[0] == 1);
+    ASSERT_IS_TRUE(g_slots[1] == 0);
+    ASSERT_IS_TRUE(g_slots[2] == 1);
+}
+
+TEST_FUNCTION(ctrs_concurrent_run_with_0_threads_runs_on_every_processor)
+{
+    ///arrange
+
+    ///act
+    int result = ctrs_concurrent_run("record_thread_count", 0, record_thread_count);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(g_seen_thread_count >= 1);
+}
+
+TEST_FUNCTION(ctrs_concurrent_run_with_NULL_body_fails)
+{
+    ///arrange
+
+    ///act
+    int result = ctrs_concurrent_run("NULL", 2, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+#ifndef CPP_UNITTEST
+/*a failed assertion of ctest longjmps to g_ExceptionJump, this one is caught to check that it happens (cppunittest throws instead)*/
+static bool concurrent_assert_fails_the_test(void)
+{
+    jmp_buf saved_exception_jump;
+    volatile bool failed = false;
+
+    (void)memcpy(saved_exception_jump, g_ExceptionJump, sizeof(jmp_buf));
+    if (setjmp(g_ExceptionJump) == 0)
+    {
+        CONCURRENT_ASSERT_IS_TRUE(CONCURRENT_THREAD_COUNT() == 1, "called on the test thread");
+    }
+    else
+    {
+        failed = true;
+    }
+    (void)memcpy(g_ExceptionJump, saved_exception_jump, sizeof(jmp_buf));
+
+    return failed;
+}
+
+TEST_FUNCTION(concurrent_assert_outside_of_a_body_fails_the_test)
+{
+    ///arrange
+
+    ///act
+    bool failed = concurrent_assert_fails_the_test();
+
+    ///assert
+    ASSERT_IS_TRUE(failed);
+}
+#endif
+
+TEST_FUNCTION(ctrs_concurrent_thread_index_is_0_outside_of_a_body)
+{
+    ///arrange
+
+    ///act
+    size_t thread_index = CONCURRENT_THREAD_INDEX();
+    size_t thread_count = CONCURRENT_THREAD_COUNT();
+
+    ///assert
+    ASSERT_IS_TRUE(thread_index == 0);
+    ASSERT_IS_TRUE(thread_count == 0);
+}
+
+TEST_FUNCTION(ctrs_concurrent_get_sweep_thread_counts_doubles_up_to_the_processor_count)
+{
+    ///arrange
+    size_t thread_counts[8];
+
+    ///act
+    size_t count = ctrs_concurrent_get_sweep_thread_counts(6, thread_counts, 8);
+
+    ///assert
+    ASSERT_IS_TRUE(count == 4);
+    ASSERT_IS_TRUE(thread_counts[0] == 1);
+    ASSERT_IS_TRUE(thread_counts[1] == 2);
+    ASSERT_IS_TRUE(thread_counts[2] == 4);
+    ASSERT_IS_TRUE(thread_counts[3] == 6);
+}
+
+TEST_FUNCTION(ctrs_concurrent_get_sweep_thread_counts_ends_on_a_power_of_2_processor_count)
+{
+    ///arrange
+    size_t thread_counts[8];
+
+    ///act
+    size_t count = ctrs_concurrent_get_sweep_thread_counts(8, thread_counts, 8);
+
+    ///assert
+    ASSERT_IS_TRUE(count == 4);
+    ASSERT_IS_TRUE(thread_counts[3] == 8);
+}
+
+TEST_FUNCTION(ctrs_concurrent_get_sweep_thread_counts_with_1_processor_is_1_thread)
+{
+    ///arrange
+    size_t thread_counts[8];
+
+    ///act
+    size_t count = ctrs_concurrent_get_sweep_thread_counts(1, thread_counts, 8);
+
+    ///assert
+    ASSERT_IS_TRUE(count == 1);
+    ASSERT_IS_TRUE(thread_counts[0] == 1);
+}
+
+END_TEST_SUITE(concurrent_ut)
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_sprintf.h"
+
+/*longer than the inline buffer of ctrs_sprintf_thread_local and than the first pass of ctrs_sprintf_char*/
+#define LONG_TEXT_LENGTH 3000
+
+static char g_long_text[LONG_TEXT_LENGTH + 1];
+
+BEGIN_TEST_SUITE(ctrs_sprintf_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    (void)memset(g_long_text, 'x', LONG_TEXT_LENGTH);
+    g_long_text[LONG_TEXT_LENGTH] = '\0';
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    ctrs_sprintf_thread_local_reset();
+}
+
+TEST_FUNCTION(ctrs_sprintf_char_formats_a_short_string) // no-srs
+{
+    ///act
+    char* result = ctrs_sprintf_char("%d-%s", 42, "abc");
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("42-abc", result));
+
+    ///cleanup
+    ctrs_sprintf_free(result);
+}
+
+TEST_FUNCTION(ctrs_sprintf_char_formats_a_long_string) // no-srs
+{
+    ///act
+    char* result = ctrs_sprintf_char("<%s>", g_long_text);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, LONG_TEXT_LENGTH + 2, strlen(result));
+    ASSERT_ARE_EQUAL(int, 0, strncmp(result + 1, g_long_text, LONG_TEXT_LENGTH));
+    ASSERT_ARE_EQUAL(int, '>', result[LONG_TEXT_LENGTH + 1]);
+
+    ///cleanup
+    ctrs_sprintf_free(result);
+}
+
+TEST_FUNCTION(ctrs_sprintf_thread_local_formats_a_short_string) // no-srs
+{
+    ///act
+    const char* result = ctrs_sprintf_thread_local("%d-%s", 42, "abc");
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("42-abc", result));
+}
+
+TEST_FUNCTION(ctrs_sprintf_thread_local_reuses_its_buffer) // no-srs
+{
+    ///arrange
+    const char* first = ctrs_sprintf_thread_local("%s", "first");
+
+    ///act
+    const char* second = ctrs_sprintf_thread_local("%s", "second");
+
+    ///assert
+    ASSERT_IS_TRUE(first == second);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("second", second));
+}
+
+TEST_FUNCTION(ctrs_sprintf_thread_local_grows_for_a_long_string) // no-srs
+{
+    ///act
+    const char* result = ctrs_sprintf_thread_local("<%s>", g_long_text);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, LONG_TEXT_LENGTH + 2, strlen(result));
+    ASSERT_ARE_EQUAL(int, 0, strncmp(result + 1, g_long_text, LONG_TEXT_LENGTH));
+}
+
+TEST_FUNCTION(ctrs_sprintf_thread_local_formats_short_strings_after_growing) // no-srs
+{
+    ///arrange
+    (void)ctrs_sprintf_thread_local("<%s>", g_long_text);
+
+    ///act
+    const char* result = ctrs_sprintf_thread_local("%d", 7);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("7", result));
+}
+
+TEST_FUNCTION(ctrs_sprintf_thread_local_works_after_reset) // no-srs
+{
+    ///arrange
+    (void)ctrs_sprintf_thread_local("<%s>", g_long_text);
+    ctrs_sprintf_thread_local_reset();
+
+    ///act
+    const char* result = ctrs_sprintf_thread_local("%s", "after reset");
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("after reset", result));
+}
+
+END_TEST_SUITE(ctrs_sprintf_ut)
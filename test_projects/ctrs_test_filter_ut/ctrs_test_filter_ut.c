@@ -0,0 +1,447 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_test_filter.h"
+
+#define FILTER_FILE_NAME "ctrs_test_filter_ut_filter.txt"
+
+static CTRS_TEST_FILTER_HANDLE create_filter(const char* pattern, bool exclude)
+{
+    CTRS_TEST_FILTER_HANDLE result = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_test_filter_add(result, pattern, exclude));
+    return result;
+}
+
+/*whether the regular expression pattern (with its "re:" prefix) selects test_name*/
+static bool regex_selects(const char* pattern, const char* test_name)
+{
+    CTRS_TEST_FILTER_HANDLE filter = create_filter(pattern, false);
+    bool result = ctrs_test_filter_matches(filter, test_name);
+    ctrs_test_filter_destroy(filter);
+    return result;
+}
+
+/*whether ctrs_test_filter_add refuses the regular expression pattern*/
+static bool regex_is_rejected(const char* pattern)
+{
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    bool result;
+    ASSERT_IS_NOT_NULL(filter);
+    result = (ctrs_test_filter_add(filter, pattern, false) != 0);
+    ctrs_test_filter_destroy(filter);
+    return result;
+}
+
+BEGIN_TEST_SUITE(ctrs_test_filter_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+}
+
+TEST_FUNCTION(ctrs_test_filter_without_patterns_matches_everything) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(filter);
+
+    ///act
+    bool result = ctrs_test_filter_matches(filter, "any_test");
+
+    ///assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_IS_NULL(ctrs_test_filter_get_single_name(filter));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_with_empty_pattern_fails) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(filter);
+
+    ///act
+    int result = ctrs_test_filter_add(filter, "", false);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_exact_name_matches_only_that_name) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("test_1", false);
+
+    ///act
+    bool matches_1 = ctrs_test_filter_matches(filter, "test_1");
+    bool matches_10 = ctrs_test_filter_matches(filter, "test_10");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_1);
+    ASSERT_IS_FALSE(matches_10);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("test_1", ctrs_test_filter_get_single_name(filter)));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_glob_matches_star_and_question_mark) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("*_fails_wh?n_*", false);
+
+    ///act
+    bool matches_when = ctrs_test_filter_matches(filter, "create_fails_when_malloc_fails");
+    bool matches_whan = ctrs_test_filter_matches(filter, "create_fails_whan_x");
+    bool matches_succeeds = ctrs_test_filter_matches(filter, "create_succeeds");
+    bool matches_no_suffix = ctrs_test_filter_matches(filter, "create_fails_when");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_when);
+    ASSERT_IS_TRUE(matches_whan);
+    ASSERT_IS_FALSE(matches_succeeds);
+    ASSERT_IS_FALSE(matches_no_suffix);
+    ASSERT_IS_NULL(ctrs_test_filter_get_single_name(filter));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_is_searched_anywhere_in_the_name) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("re:test_\\d+_w[a-z]+", false);
+
+    ///act
+    bool matches_middle = ctrs_test_filter_matches(filter, "my_test_42_with_fixtures");
+    bool matches_no_digit = ctrs_test_filter_matches(filter, "my_test_x_with_fixtures");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_middle);
+    ASSERT_IS_FALSE(matches_no_digit);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_honors_anchors_and_quantifiers) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("re:^a[^_]?b*c+$", false);
+
+    ///act
+    bool matches_short = ctrs_test_filter_matches(filter, "ac");
+    bool matches_long = ctrs_test_filter_matches(filter, "axbbbccc");
+    bool matches_prefix = ctrs_test_filter_matches(filter, "xac");
+    bool matches_suffix = ctrs_test_filter_matches(filter, "acx");
+    bool matches_class = ctrs_test_filter_matches(filter, "a_c");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_short);
+    ASSERT_IS_TRUE(matches_long);
+    ASSERT_IS_FALSE(matches_prefix);
+    ASSERT_IS_FALSE(matches_suffix);
+    ASSERT_IS_FALSE(matches_class);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_backtracks) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("re:^.*_fails$", false);
+
+    ///act
+    bool result = ctrs_test_filter_matches(filter, "x_fails_when_y_fails");
+
+    ///assert
+    ASSERT_IS_TRUE(result);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_rejects_unsupported_regex) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(filter);
+
+    ///act
+    int result_group = ctrs_test_filter_add(filter, "re:(a|b)", false);
+    int result_class = ctrs_test_filter_add(filter, "re:[ab", false);
+    int result_repeat = ctrs_test_filter_add(filter, "re:*a", false);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_group);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_class);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_repeat);
+    ASSERT_IS_TRUE(ctrs_test_filter_matches(filter, "any_test"));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_empty_regex_matches_everything_and_anchors_alone_match_only_the_empty_name) // no-srs
+{
+    ///act
+    bool empty_matches = regex_selects("re:", "any_test");
+    bool anchors_match = regex_selects("re:^$", "any_test");
+
+    ///assert
+    ASSERT_IS_TRUE(empty_matches);
+    ASSERT_IS_FALSE(anchors_match);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_dot_matches_exactly_one_character) // no-srs
+{
+    ///act
+    bool matches_one = regex_selects("re:^a.c$", "abc");
+    bool matches_none = regex_selects("re:^a.c$", "ac");
+    bool matches_two = regex_selects("re:^a.c$", "abbc");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_one);
+    ASSERT_IS_FALSE(matches_none);
+    ASSERT_IS_FALSE(matches_two);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_escaped_metacharacters_are_literal) // no-srs
+{
+    ///act
+    bool dot_matches_dot = regex_selects("re:^a\\.c$", "a.c");
+    bool dot_matches_other = regex_selects("re:^a\\.c$", "abc");
+    bool star_matches_star = regex_selects("re:^a\\*$", "a*");
+    bool star_repeats = regex_selects("re:^a\\*$", "aa");
+    bool bracket_matches_bracket = regex_selects("re:^\\[x\\]$", "[x]");
+
+    ///assert
+    ASSERT_IS_TRUE(dot_matches_dot);
+    ASSERT_IS_FALSE(dot_matches_other);
+    ASSERT_IS_TRUE(star_matches_star);
+    ASSERT_IS_FALSE(star_repeats);
+    ASSERT_IS_TRUE(bracket_matches_bracket);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_digit_word_and_space_escapes) // no-srs
+{
+    ///act
+    bool digit_matches_digit = regex_selects("re:^\\d$", "7");
+    bool digit_matches_letter = regex_selects("re:^\\d$", "x");
+    bool word_matches_word = regex_selects("re:^\\w+$", "Test_42");
+    bool word_matches_dash = regex_selects("re:^\\w+$", "test-42");
+    bool space_matches_space = regex_selects("re:^a\\sb$", "a b");
+    bool space_matches_tab = regex_selects("re:^a\\sb$", "a\tb");
+    bool space_matches_letter = regex_selects("re:^a\\sb$", "axb");
+
+    ///assert
+    ASSERT_IS_TRUE(digit_matches_digit);
+    ASSERT_IS_FALSE(digit_matches_letter);
+    ASSERT_IS_TRUE(word_matches_word);
+    ASSERT_IS_FALSE(word_matches_dash);
+    ASSERT_IS_TRUE(space_matches_space);
+    ASSERT_IS_TRUE(space_matches_tab);
+    ASSERT_IS_FALSE(space_matches_letter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_bracket_expressions) // no-srs
+{
+    ///act
+    bool range_inside = regex_selects("re:^[a-c]$", "b");
+    bool range_outside = regex_selects("re:^[a-c]$", "d");
+    bool leading_bracket = regex_selects("re:^[]a]$", "]");
+    bool trailing_dash = regex_selects("re:^[a-]$", "-");
+    bool escape_in_class = regex_selects("re:^[\\d_]+$", "_1_2");
+    bool negated_inside = regex_selects("re:^[^\\d]$", "1");
+    bool negated_outside = regex_selects("re:^[^\\d]$", "x");
+
+    ///assert
+    ASSERT_IS_TRUE(range_inside);
+    ASSERT_IS_FALSE(range_outside);
+    ASSERT_IS_TRUE(leading_bracket);
+    ASSERT_IS_TRUE(trailing_dash);
+    ASSERT_IS_TRUE(escape_in_class);
+    ASSERT_IS_FALSE(negated_inside);
+    ASSERT_IS_TRUE(negated_outside);
+}
+
+TEST_FUNCTION(ctrs_test_filter_regex_quantifiers_allow_their_counts) // no-srs
+{
+    ///act
+    bool optional_absent = regex_selects("re:^a?b$", "b");
+    bool optional_twice = regex_selects("re:^a?b$", "aab");
+    bool star_absent = regex_selects("re:^a*b$", "b");
+    bool star_many = regex_selects("re:^a*b$", "aaaab");
+    bool plus_absent = regex_selects("re:^a+b$", "b");
+    bool plus_many = regex_selects("re:^a+b$", "aaab");
+
+    ///assert
+    ASSERT_IS_TRUE(optional_absent);
+    ASSERT_IS_FALSE(optional_twice);
+    ASSERT_IS_TRUE(star_absent);
+    ASSERT_IS_TRUE(star_many);
+    ASSERT_IS_FALSE(plus_absent);
+    ASSERT_IS_TRUE(plus_many);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_rejects_nested_quantifiers) // no-srs
+{
+    ///act
+    bool star_star = regex_is_rejected("re:a**");
+    bool plus_question = regex_is_rejected("re:a+?");
+    bool question_star = regex_is_rejected("re:a?*");
+    bool quantified_anchor = regex_is_rejected("re:^*a");
+
+    ///assert
+    ASSERT_IS_TRUE(star_star);
+    ASSERT_IS_TRUE(plus_question);
+    ASSERT_IS_TRUE(question_star);
+    ASSERT_IS_TRUE(quantified_anchor);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_rejects_empty_alternations_groups_and_counted_repetition) // no-srs
+{
+    ///act
+    bool trailing_alternation = regex_is_rejected("re:a|");
+    bool leading_alternation = regex_is_rejected("re:|a");
+    bool empty_group = regex_is_rejected("re:()");
+    bool counted = regex_is_rejected("re:a{2}");
+
+    ///assert
+    ASSERT_IS_TRUE(trailing_alternation);
+    ASSERT_IS_TRUE(leading_alternation);
+    ASSERT_IS_TRUE(empty_group);
+    ASSERT_IS_TRUE(counted);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_rejects_misplaced_anchors_bad_escapes_and_reversed_ranges) // no-srs
+{
+    ///act
+    bool dollar_in_the_middle = regex_is_rejected("re:a$b");
+    bool trailing_backslash = regex_is_rejected("re:a\\");
+    bool reversed_range = regex_is_rejected("re:[z-a]");
+
+    ///assert
+    ASSERT_IS_TRUE(dollar_in_the_middle);
+    ASSERT_IS_TRUE(trailing_backslash);
+    ASSERT_IS_TRUE(reversed_range);
+}
+
+TEST_FUNCTION(ctrs_test_filter_matches_any_include_and_no_exclude) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("a_*", false);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_test_filter_add(filter, "b_*", false));
+    ASSERT_ARE_EQUAL(int, 0, ctrs_test_filter_add(filter, "re:_slow$", true));
+
+    ///act
+    bool matches_a = ctrs_test_filter_matches(filter, "a_test");
+    bool matches_b = ctrs_test_filter_matches(filter, "b_test");
+    bool matches_c = ctrs_test_filter_matches(filter, "c_test");
+    bool matches_b_slow = ctrs_test_filter_matches(filter, "b_test_slow");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_a);
+    ASSERT_IS_TRUE(matches_b);
+    ASSERT_IS_FALSE(matches_c);
+    ASSERT_IS_FALSE(matches_b_slow);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_with_only_excludes_matches_the_rest) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = create_filter("*_slow", true);
+
+    ///act
+    bool matches_fast = ctrs_test_filter_matches(filter, "test_fast");
+    bool matches_slow = ctrs_test_filter_matches(filter, "test_slow");
+
+    ///assert
+    ASSERT_IS_TRUE(matches_fast);
+    ASSERT_IS_FALSE(matches_slow);
+    ASSERT_IS_NULL(ctrs_test_filter_get_single_name(filter));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_from_file_adds_includes_and_excludes) // no-srs
+{
+    ///arrange
+    FILE* file = fopen(FILTER_FILE_NAME, "w");
+    ASSERT_IS_NOT_NULL(file);
+    (void)fputs("# tests of the parser\r\n\n  parser_*  \n- parser_*_slow\nre:^lexer_\n", file);
+    (void)fclose(file);
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(filter);
+
+    ///act
+    int result = ctrs_test_filter_add_from_file(filter, FILTER_FILE_NAME);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(ctrs_test_filter_matches(filter, "parser_handles_empty_input"));
+    ASSERT_IS_TRUE(ctrs_test_filter_matches(filter, "lexer_skips_comments"));
+    ASSERT_IS_FALSE(ctrs_test_filter_matches(filter, "parser_big_input_slow"));
+    ASSERT_IS_FALSE(ctrs_test_filter_matches(filter, "# tests of the parser"));
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+    (void)remove(FILTER_FILE_NAME);
+}
+
+TEST_FUNCTION(ctrs_test_filter_add_from_file_with_missing_file_fails) // no-srs
+{
+    ///arrange
+    CTRS_TEST_FILTER_HANDLE filter = ctrs_test_filter_create();
+    ASSERT_IS_NOT_NULL(filter);
+
+    ///act
+    int result = ctrs_test_filter_add_from_file(filter, "ctrs_test_filter_ut_does_not_exist.txt");
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    ctrs_test_filter_destroy(filter);
+}
+
+END_TEST_SUITE(ctrs_test_filter_ut)
@@ -0,0 +1,416 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_data_table.h"
+
+#define TEST_CSV_FILE_NAME "data_table_ut_generated.csv"
+
+typedef struct SUM_ROW_TAG
+{
+    int a;
+    int b;
+    int sum;
+} SUM_ROW;
+
+static const SUM_ROW sum_rows[] =
+{
+    { 0, 0, 0 },
+    { 1, 2, 3 },
+    { -5, 3, -2 },
+    { 10, 20, 30 }
+};
+
+typedef struct DIGITS_ROW_TAG
+{
+    char digits[4];
+} DIGITS_ROW;
+
+/*what the bodies of the hand made tables below saw*/
+static int g_rows_run;
+static int g_sum_of_a;
+
+static void count_row(const void* row)
+{
+    const SUM_ROW* sum_row = (const SUM_ROW*)row;
+    g_rows_run++;
+    g_sum_of_a += sum_row->a;
+}
+
+static void fail_row_with_negative_a(const void* row)
+{
+    const SUM_ROW* sum_row = (const SUM_ROW*)row;
+    g_rows_run++;
+    ASSERT_IS_TRUE(sum_row->a >= 0);
+}
+
+static void count_csv_row(const void* row)
+{
+    (void)row;
+    g_rows_run++;
+}
+
+static void write_test_file(const char* content)
+{
+    FILE* file = fopen(TEST_CSV_FILE_NAME, "wb");
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_EQUAL(int, 1, (int)fwrite(content, strlen(content), 1, file));
+    ASSERT_ARE_EQUAL(int, 0, fclose(file));
+}
+
+static CTRS_DATA_TABLE make_table(CTRS_DATA_TABLE_SOURCE source, const char* file_name, size_t row_size, void(*run_row)(const void* row))
+{
+    CTRS_DATA_TABLE table;
+    (void)memset(&table, 0, sizeof(table));
+    table.test_name = "hand_made";
+    table.source = source;
+    table.file_name = file_name;
+    table.row_size = row_size;
+    table.run_row = run_row;
+    if (source == CTRS_DATA_TABLE_SOURCE_ARRAY)
+    {
+        table.rows = sum_rows;
+        table.row_count = sizeof(sum_rows) / sizeof(sum_rows[0]);
+    }
+    return table;
+}
+
+BEGIN_TEST_SUITE(data_table_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    g_rows_run = 0;
+    g_sum_of_a = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    (void)remove(TEST_CSV_FILE_NAME);
+}
+
+TABLE_TEST_FUNCTION(array_rows_add_up, SUM_ROW, sum_rows)
+{
+    ASSERT_ARE_EQUAL(int, row->sum, row->a + row->b);
+}
+
+CSV_TEST_FUNCTION(csv_rows_add_up, "data_table_ut.csv")
+{
+    const char* a = ctrs_data_table_csv_get(row, "a");
+    const char* b = ctrs_data_table_csv_get(row, "b");
+    const char* sum = ctrs_data_table_csv_get(row, "sum");
+
+    ASSERT_IS_NOT_NULL(a);
+    ASSERT_IS_NOT_NULL(b);
+    ASSERT_IS_NOT_NULL(sum);
+    ASSERT_IS_NOT_NULL(ctrs_data_table_csv_get(row, "label"));
+    ASSERT_IS_NULL(ctrs_data_table_csv_get(row, "no_such_column"));
+    ASSERT_ARE_EQUAL(int, atoi(sum), atoi(a) + atoi(b));
+}
+
+BINARY_TABLE_TEST_FUNCTION(binary_rows_are_palindromes, DIGITS_ROW, "data_table_ut.bin")
+{
+    ASSERT_IS_TRUE(row->digits[0] == row->digits[3]);
+    ASSERT_IS_TRUE(row->digits[1] == row->digits[2]);
+}
+
+/* ctrs_data_table_find */
+
+TEST_FUNCTION(ctrs_data_table_find_returns_the_registered_tables)
+{
+    ///act
+    CTRS_DATA_TABLE* array_table = ctrs_data_table_find("array_rows_add_up");
+    CTRS_DATA_TABLE* csv_table = ctrs_data_table_find("csv_rows_add_up");
+
+    ///assert
+    ASSERT_IS_NOT_NULL(array_table);
+    ASSERT_IS_NOT_NULL(csv_table);
+    ASSERT_ARE_EQUAL(int, (int)CTRS_DATA_TABLE_SOURCE_ARRAY, (int)array_table->source);
+    ASSERT_ARE_EQUAL(int, (int)CTRS_DATA_TABLE_SOURCE_CSV_FILE, (int)csv_table->source);
+    ASSERT_IS_TRUE(ctrs_data_table_any_registered());
+}
+
+TEST_FUNCTION(ctrs_data_table_find_returns_NULL_for_a_test_that_is_not_a_table)
+{
+    ///act
+    CTRS_DATA_TABLE* table = ctrs_data_table_find("ctrs_data_table_find_returns_NULL_for_a_test_that_is_not_a_table");
+
+    ///assert
+    ASSERT_IS_NULL(table);
+}
+
+/* ctrs_data_table_run */
+
+TEST_FUNCTION(ctrs_data_table_run_runs_all_the_rows)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_ARRAY, NULL, sizeof(SUM_ROW), count_row);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 4, g_rows_run);
+    ASSERT_ARE_EQUAL(int, 6, g_sum_of_a);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_goes_on_after_a_failed_row_and_fails)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_ARRAY, NULL, sizeof(SUM_ROW), fail_row_with_negative_a);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 4, g_rows_run);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_runs_only_the_selected_row)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_ARRAY, NULL, sizeof(SUM_ROW), count_row);
+    ctrs_data_table_select_row(&table, 3);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ctrs_data_table_select_row(NULL, 0);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 1, g_rows_run);
+    ASSERT_ARE_EQUAL(int, 10, g_sum_of_a);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_fails_for_a_selected_row_past_the_end)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_ARRAY, NULL, sizeof(SUM_ROW), count_row);
+    ctrs_data_table_select_row(&table, 4);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ctrs_data_table_select_row(NULL, 0);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, g_rows_run);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_with_NULL_table_fails)
+{
+    ///act
+    int result = ctrs_data_table_run(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_data_table_run_with_a_missing_file_fails)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, "data_table_ut_does_not_exist.csv", sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+
+    ///act
+    int result = ctrs_data_table_run(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, g_rows_run);
+}
+
+/* ctrs_data_table_load */
+
+TEST_FUNCTION(ctrs_data_table_load_names_array_rows_by_index)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_ARRAY, NULL, sizeof(SUM_ROW), count_row);
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("hand_made_0", ctrs_data_table_get_row_name(&table, 0)));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("hand_made_3", ctrs_data_table_get_row_name(&table, 3)));
+    ASSERT_IS_NULL(ctrs_data_table_get_row_name(&table, 4));
+
+    ///cleanup
+    ctrs_data_table_unload(&table);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_parses_quoted_csv_fields)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    const CTRS_DATA_TABLE_CSV_ROW* rows;
+    write_test_file("# comment\r\nname,text,empty\r\n\r\nfirst,\"a, b\",\r\n\"second\",\"say \"\"hi\"\"\",\"\"\r\n,last line,x");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, table.row_count);
+    rows = (const CTRS_DATA_TABLE_CSV_ROW*)table.rows;
+    ASSERT_ARE_EQUAL(size_t, 3, rows[0].field_count);
+    ASSERT_ARE_EQUAL(int, 0, strcmp("a, b", ctrs_data_table_csv_get(&rows[0], "text")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("", ctrs_data_table_csv_get(&rows[0], "empty")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("say \"hi\"", ctrs_data_table_csv_get(&rows[1], "text")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("", ctrs_data_table_csv_get(&rows[1], "empty")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("last line", ctrs_data_table_csv_get(&rows[2], "text")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("x", ctrs_data_table_csv_get(&rows[2], "empty")));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("hand_made_first", ctrs_data_table_get_row_name(&table, 0)));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("hand_made_second", ctrs_data_table_get_row_name(&table, 1)));
+    ASSERT_ARE_EQUAL(int, 0, strcmp("hand_made_2", ctrs_data_table_get_row_name(&table, 2)));
+    ASSERT_ARE_EQUAL(int, 0, ctrs_data_table_run(&table));
+    ASSERT_ARE_EQUAL(int, 3, g_rows_run);
+
+    ///cleanup
+    ctrs_data_table_unload(&table);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_a_csv_row_with_a_missing_field)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("a,b\n1,2\n3\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_an_unterminated_quoted_field)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("a,b\n1,\"2\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_a_row_name_that_is_not_an_identifier)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("name,a\nok,1\na b,2\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_two_rows_with_the_same_name)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("name,a\nsame,1\nother,2\nsame,3\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_a_row_named_like_the_index_of_another_row)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("name,a\n1,1\n,2\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(table.loaded);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_an_empty_csv_file)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_CSV_FILE, TEST_CSV_FILE_NAME, sizeof(CTRS_DATA_TABLE_CSV_ROW), count_csv_row);
+    write_test_file("# only a comment\n");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_fails_for_a_binary_file_of_partial_rows)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_BINARY_FILE, TEST_CSV_FILE_NAME, sizeof(DIGITS_ROW), count_csv_row);
+    write_test_file("123456");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, table.row_count);
+}
+
+TEST_FUNCTION(ctrs_data_table_load_splits_a_binary_file_in_rows)
+{
+    ///arrange
+    CTRS_DATA_TABLE table = make_table(CTRS_DATA_TABLE_SOURCE_BINARY_FILE, TEST_CSV_FILE_NAME, sizeof(DIGITS_ROW), count_csv_row);
+    write_test_file("12345678");
+
+    ///act
+    int result = ctrs_data_table_load(&table);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, table.row_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp("5678", ((const DIGITS_ROW*)table.rows)[1].digits, 4));
+    ASSERT_ARE_EQUAL(int, 0, ctrs_data_table_run(&table));
+    ASSERT_ARE_EQUAL(int, 2, g_rows_run);
+
+    ///cleanup
+    ctrs_data_table_unload(&table);
+}
+
+END_TEST_SUITE(data_table_ut)
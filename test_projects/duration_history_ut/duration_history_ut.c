@@ -0,0 +1,334 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_duration_history.h"
+
+#define TEST_HISTORY_FILE_NAME "duration_history_ut_generated.durations"
+#define TEST_SHARD_0_FILE_NAME TEST_HISTORY_FILE_NAME ".shard_0_of_2"
+#define TEST_SHARD_1_FILE_NAME TEST_HISTORY_FILE_NAME ".shard_1_of_2"
+
+static void remove_history_files(void)
+{
+    (void)remove(TEST_HISTORY_FILE_NAME);
+    (void)remove(TEST_SHARD_0_FILE_NAME);
+    (void)remove(TEST_SHARD_1_FILE_NAME);
+}
+
+static bool file_exists(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return (file != NULL);
+}
+
+BEGIN_TEST_SUITE(duration_history_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    remove_history_files();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    remove_history_files();
+}
+
+TEST_FUNCTION(ctrs_duration_history_assign_longest_first_with_equal_costs_is_round_robin)
+{
+    ///arrange
+    double costs[7] = { 1, 1, 1, 1, 1, 1, 1 };
+    size_t bins[7];
+    size_t i;
+
+    ///act
+    int result = ctrs_duration_history_assign_longest_first(costs, 7, 3, bins);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    for (i = 0; i < 7; i++)
+    {
+        ASSERT_ARE_EQUAL(size_t, i % 3, bins[i]);
+    }
+}
+
+TEST_FUNCTION(ctrs_duration_history_assign_longest_first_balances_the_bins)
+{
+    ///arrange
+    /*round robin gives 2+7+5+3=17 and 3+4+5+1=13, the best is 15 and 15*/
+    double costs[8] = { 2, 3, 7, 4, 5, 5, 3, 1 };
+    size_t bins[8];
+    double bin_costs[2] = { 0, 0 };
+    size_t i;
+
+    ///act
+    int result = ctrs_duration_history_assign_longest_first(costs, 8, 2, bins);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    for (i = 0; i < 8; i++)
+    {
+        ASSERT_IS_TRUE(bins[i] < 2);
+        bin_costs[bins[i]] += costs[i];
+    }
+    ASSERT_ARE_EQUAL(double, 15, bin_costs[0]);
+    ASSERT_ARE_EQUAL(double, 15, bin_costs[1]);
+    /*the longest item is placed first, in the first bin*/
+    ASSERT_ARE_EQUAL(size_t, 0, bins[2]);
+}
+
+TEST_FUNCTION(ctrs_duration_history_assign_longest_first_with_more_bins_than_items_uses_one_bin_per_item)
+{
+    ///arrange
+    double costs[2] = { 1, 5 };
+    size_t bins[2];
+
+    ///act
+    int result = ctrs_duration_history_assign_longest_first(costs, 2, 4, bins);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, bins[0]);
+    ASSERT_ARE_EQUAL(size_t, 0, bins[1]);
+}
+
+TEST_FUNCTION(ctrs_duration_history_assign_longest_first_with_0_bins_fails)
+{
+    ///arrange
+    double costs[1] = { 1 };
+    size_t bins[1];
+
+    ///act
+    int result = ctrs_duration_history_assign_longest_first(costs, 1, 0, bins);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_duration_history_load_without_a_file_is_empty_and_defaults_to_1_ms)
+{
+    ///arrange
+    double duration_ms;
+
+    ///act
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_FALSE(ctrs_duration_history_get(history, "some_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 1, ctrs_duration_history_get_default(history));
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_save_and_load_round_trip_and_average_with_the_last_run)
+{
+    ///arrange
+    double duration_ms;
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "test with spaces", 10);
+    ctrs_duration_history_record(history, "a_test", 2);
+    ctrs_duration_history_record(history, "c_test", 4);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+
+    ///act
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "test with spaces", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 10, duration_ms);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "a_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 2, duration_ms);
+    /*the median of 2, 4 and 10*/
+    ASSERT_ARE_EQUAL(double, 4, ctrs_duration_history_get_default(history));
+
+    ctrs_duration_history_record(history, "test with spaces", 20);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "test with spaces", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 15, duration_ms);
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_save_with_prune_drops_the_tests_that_did_not_run)
+{
+    ///arrange
+    double duration_ms;
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "kept_test", 2);
+    ctrs_duration_history_record(history, "removed_test", 4);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "kept_test", 2);
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+
+    ///assert
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "kept_test", &duration_ms));
+    ASSERT_IS_FALSE(ctrs_duration_history_get(history, "removed_test", &duration_ms));
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_merges_the_shard_files_once_all_shards_saved)
+{
+    ///arrange
+    double duration_ms;
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 2);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "shard_0_test", 3);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, false));
+    ctrs_duration_history_destroy(history);
+
+    /*only one shard saved, the history stays as it was*/
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 1, 2);
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_FALSE(ctrs_duration_history_get(history, "shard_0_test", &duration_ms));
+    ctrs_duration_history_record(history, "shard_1_test", 7);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, false));
+    ctrs_duration_history_destroy(history);
+
+    ///act
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "shard_0_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 3, duration_ms);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "shard_1_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 7, duration_ms);
+    ASSERT_IS_TRUE(file_exists(TEST_HISTORY_FILE_NAME));
+    ASSERT_IS_FALSE(file_exists(TEST_SHARD_0_FILE_NAME));
+    ASSERT_IS_FALSE(file_exists(TEST_SHARD_1_FILE_NAME));
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_load_keeps_the_last_duration_of_a_test_written_twice)
+{
+    ///arrange
+    double duration_ms;
+    FILE* file = fopen(TEST_HISTORY_FILE_NAME, "w");
+    ASSERT_IS_NOT_NULL(file);
+    (void)fprintf(file, "5 a_test\n1 b_test\n7 a_test\n2 c_test\n9 a_test\n");
+    ASSERT_ARE_EQUAL(int, 0, fclose(file));
+
+    ///act
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "a_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 9, duration_ms);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "b_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 1, duration_ms);
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+static void save_both_shards(bool first_shard_ran_all_tests)
+{
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 2);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "shard_0_test", 3);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, first_shard_ran_all_tests));
+    ctrs_duration_history_destroy(history);
+
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 1, 2);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "shard_1_test", 7);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_merge_drops_the_tests_no_shard_ran_when_all_shards_ran_all_their_tests)
+{
+    ///arrange
+    double duration_ms;
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "removed_test", 4);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+    save_both_shards(true);
+
+    ///act
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "shard_0_test", &duration_ms));
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "shard_1_test", &duration_ms));
+    ASSERT_IS_FALSE(ctrs_duration_history_get(history, "removed_test", &duration_ms));
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+TEST_FUNCTION(ctrs_duration_history_merge_keeps_the_tests_no_shard_ran_when_a_shard_did_not_run_all_its_tests)
+{
+    ///arrange
+    double duration_ms;
+    CTRS_DURATION_HISTORY_HANDLE history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 1);
+    ASSERT_IS_NOT_NULL(history);
+    ctrs_duration_history_record(history, "filtered_out_test", 4);
+    ASSERT_ARE_EQUAL(int, 0, ctrs_duration_history_save(history, true));
+    ctrs_duration_history_destroy(history);
+    save_both_shards(false);
+
+    ///act
+    history = ctrs_duration_history_load(TEST_HISTORY_FILE_NAME, "duration_history_ut", 0, 2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(history);
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "shard_1_test", &duration_ms));
+    ASSERT_IS_TRUE(ctrs_duration_history_get(history, "filtered_out_test", &duration_ms));
+    ASSERT_ARE_EQUAL(double, 4, duration_ms);
+
+    ///cleanup
+    ctrs_duration_history_destroy(history);
+}
+
+END_TEST_SUITE(duration_history_ut)
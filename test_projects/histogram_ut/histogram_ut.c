@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "testrunnerswitcher.h"
+
+#include "ctrs_histogram.h"
+
+static CTRS_HISTOGRAM_HANDLE g_histogram;
+
+/*the value at percentile is never below the real one and at most 1/128 above it*/
+static void assert_percentile_is_within_precision(double percentile, uint64_t expected)
+{
+    uint64_t value = ctrs_histogram_get_percentile(g_histogram, percentile);
+    ASSERT_IS_TRUE(value >= expected, "p%g is %llu, below %llu", percentile, (unsigned long long)value, (unsigned long long)expected);
+    ASSERT_IS_TRUE(value - expected <= expected / 128, "p%g is %llu, too far above %llu", percentile, (unsigned long long)value, (unsigned long long)expected);
+}
+
+BEGIN_TEST_SUITE(histogram_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    g_histogram = ctrs_histogram_create();
+    ASSERT_IS_NOT_NULL(g_histogram);
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    ctrs_histogram_destroy(g_histogram);
+}
+
+TEST_FUNCTION(ctrs_histogram_percentiles_are_within_the_precision)
+{
+    ///arrange
+    uint64_t i;
+
+    ///act
+    for (i = 1; i <= 100000; i++)
+    {
+        ctrs_histogram_record(g_histogram, i * 1000);
+    }
+
+    ///assert
+    ASSERT_IS_TRUE(ctrs_histogram_get_count(g_histogram) == 100000);
+    assert_percentile_is_within_precision(50, 50000 * 1000);
+    assert_percentile_is_within_precision(90, 90000 * 1000);
+    assert_percentile_is_within_precision(99, 99000 * 1000);
+    assert_percentile_is_within_precision(99.9, 99900 * 1000);
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 100) == 100000 * 1000);
+}
+
+TEST_FUNCTION(ctrs_histogram_values_below_256_are_exact)
+{
+    ///arrange
+    uint64_t i;
+
+    ///act
+    for (i = 0; i < 256; i++)
+    {
+        ctrs_histogram_record(g_histogram, i);
+    }
+
+    ///assert
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 50) == 127);
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 75) == 191);
+    ASSERT_IS_TRUE(ctrs_histogram_get_min(g_histogram) == 0);
+    ASSERT_IS_TRUE(ctrs_histogram_get_max(g_histogram) == 255);
+}
+
+TEST_FUNCTION(ctrs_histogram_percentile_0_and_100_are_the_min_and_the_max)
+{
+    ///arrange
+    ctrs_histogram_record(g_histogram, 123456789);
+    ctrs_histogram_record(g_histogram, 1000);
+    ctrs_histogram_record(g_histogram, UINT64_MAX);
+
+    ///act
+    uint64_t p0 = ctrs_histogram_get_percentile(g_histogram, 0);
+    uint64_t p100 = ctrs_histogram_get_percentile(g_histogram, 100);
+
+    ///assert
+    ASSERT_IS_TRUE(p0 == 1000);
+    ASSERT_IS_TRUE(p100 == UINT64_MAX);
+}
+
+TEST_FUNCTION(ctrs_histogram_record_count_records_the_value_count_times)
+{
+    ///arrange
+    ctrs_histogram_record(g_histogram, 10);
+
+    ///act
+    ctrs_histogram_record_count(g_histogram, 5000, 99);
+
+    ///assert
+    ASSERT_IS_TRUE(ctrs_histogram_get_count(g_histogram) == 100);
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 1) == 10);
+    assert_percentile_is_within_precision(2, 5000);
+    ASSERT_IS_TRUE(ctrs_histogram_get_mean(g_histogram) == (10.0 + 99 * 5000.0) / 100);
+}
+
+TEST_FUNCTION(ctrs_histogram_add_merges_the_values)
+{
+    ///arrange
+    CTRS_HISTOGRAM_HANDLE other = ctrs_histogram_create();
+    ASSERT_IS_NOT_NULL(other);
+    ctrs_histogram_record(g_histogram, 100);
+    ctrs_histogram_record(other, 50);
+    ctrs_histogram_record(other, 200);
+
+    ///act
+    int result = ctrs_histogram_add(g_histogram, other);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(ctrs_histogram_get_count(g_histogram) == 3);
+    ASSERT_IS_TRUE(ctrs_histogram_get_min(g_histogram) == 50);
+    ASSERT_IS_TRUE(ctrs_histogram_get_max(g_histogram) == 200);
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 50) == 100);
+
+    ///cleanup
+    ctrs_histogram_destroy(other);
+}
+
+TEST_FUNCTION(ctrs_histogram_reset_forgets_the_values)
+{
+    ///arrange
+    ctrs_histogram_record(g_histogram, 100);
+
+    ///act
+    ctrs_histogram_reset(g_histogram);
+
+    ///assert
+    ASSERT_IS_TRUE(ctrs_histogram_get_count(g_histogram) == 0);
+    ASSERT_IS_TRUE(ctrs_histogram_get_percentile(g_histogram, 99) == 0);
+    ASSERT_IS_TRUE(ctrs_histogram_get_max(g_histogram) == 0);
+}
+
+TEST_FUNCTION(ctrs_histogram_record_does_not_allocate)
+{
+    ///arrange
+    uint64_t i;
+    ALLOCATION_REGION_BEGIN();
+
+    ///act
+    for (i = 0; i < 10000; i++)
+    {
+        ctrs_histogram_record(g_histogram, i * i);
+    }
+
+    ///assert
+    ASSERT_ALLOCATIONS_AT_MOST(0);
+}
+
+TEST_FUNCTION(ASSERT_PERCENTILE_AT_MOST_passes_within_the_budget)
+{
+    ///arrange
+    uint64_t i;
+    for (i = 0; i < 1000; i++)
+    {
+        ctrs_histogram_record(g_histogram, (i == 999) ? 1000000 : 1000 + i);
+    }
+
+    ///act
+    ///assert
+    ASSERT_PERCENTILE_AT_MOST(g_histogram, 50, 1500 + 1500 / 128);
+    ASSERT_PERCENTILE_AT_MOST(g_histogram, 99.9, 2000);
+    ASSERT_PERCENTILE_AT_MOST(g_histogram, 100, 1000000);
+}
+
+TEST_FUNCTION(ctrs_histogram_check_percentile_fails_above_the_budget)
+{
+    ///arrange
+    uint64_t i;
+    for (i = 0; i < 1000; i++)
+    {
+        ctrs_histogram_record(g_histogram, (i == 999) ? 1000000 : 1000);
+    }
+
+    ///act
+    int result = ctrs_histogram_check_percentile(g_histogram, "g_histogram", 99.95, 2000);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_histogram_check_percentile_fails_when_nothing_was_recorded)
+{
+    ///arrange
+
+    ///act
+    int result = ctrs_histogram_check_percentile(g_histogram, "g_histogram", 99, UINT64_MAX);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+END_TEST_SUITE(histogram_ut)
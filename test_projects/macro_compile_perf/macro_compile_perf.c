@@ -0,0 +1,253 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "testrunnerswitcher.h"
+
+#include "c_logging/logger.h"
+
+#include "ctrs_time.h"
+#include "ctrs_perf_baseline.h"
+
+/*
+Every case generates a synthetic suite of N tests (plain TEST_FUNCTIONs when M is 0, otherwise PARAMETERIZED_TEST_FUNCTIONs with
+M cases of K arguments each) and measures how long the compiler of this build takes to preprocess, compile and link it, and how big
+the preprocessed output and the object are. Each number is checked against (or recorded in) the baseline of the suite, so that a
+change of testrunnerswitcher.h/ctest.h/macro_utils.h that makes the macros more expensive to expand shows up here.
+
+The link is a shared library that leaves the framework symbols unresolved: it measures the cost of the symbols and relocations
+of the suite, not the link of the framework libraries.
+*/
+
+/*the best of a few runs, the first one pays for loading the compiler and the headers from disk*/
+#define MACRO_COMPILE_PERF_REPETITIONS 3
+
+#define MACRO_COMPILE_PERF_MAX_COMMAND 4096
+#define MACRO_COMPILE_PERF_MAX_PATH 1024
+
+#ifdef _MSC_VER
+#define OBJECT_EXTENSION ".obj"
+#define LIBRARY_EXTENSION ".dll"
+#define PREPROCESS_COMMAND_FORMAT "\"%s\" /nologo @\"%s\" /P /Fi\"%s\" \"%s\" >nul"
+#define COMPILE_COMMAND_FORMAT "\"%s\" /nologo @\"%s\" /c /Fo\"%s\" \"%s\" >nul"
+#define LINK_COMMAND_FORMAT "\"%s\" /nologo \"%s\" /LD /link /NOENTRY /FORCE:UNRESOLVED /OUT:\"%s\" >nul"
+#else
+#define OBJECT_EXTENSION ".o"
+#define LIBRARY_EXTENSION ".so"
+#define PREPROCESS_COMMAND_FORMAT "\"%s\" @\"%s\" -E -o \"%s\" \"%s\""
+#define COMPILE_COMMAND_FORMAT "\"%s\" @\"%s\" -fPIC -c -o \"%s\" \"%s\""
+#define LINK_COMMAND_FORMAT "\"%s\" \"%s\" -shared -o \"%s\""
+#endif
+
+static int generate_suite(const char* file_name, const char* suite_name, int tests, int cases, int arguments)
+{
+    int result;
+    FILE* file = fopen(file_name, "w");
+
+    if (file == NULL)
+    {
+        LogError("failure in fopen(%s, \"w\")", file_name);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        int test;
+        int test_case;
+        int argument;
+
+        (void)fprintf(file, "#include \"testrunnerswitcher.h\"\n\nBEGIN_TEST_SUITE(%s)\n\n", suite_name);
+        (void)fprintf(file, "TEST_SUITE_INITIALIZE(suite_init)\n{\n}\n\nTEST_FUNCTION_INITIALIZE(test_init)\n{\n}\n\n");
+
+        for (test = 0; test < tests; test++)
+        {
+            if (cases == 0)
+            {
+                (void)fprintf(file, "TEST_FUNCTION(test_%d)\n{\n    ASSERT_ARE_EQUAL(int, %d, %d);\n}\n\n", test, test, test);
+            }
+            else
+            {
+                (void)fprintf(file, "PARAMETERIZED_TEST_FUNCTION(test_%d,\n    ARGS(", test);
+                for (argument = 0; argument < arguments; argument++)
+                {
+                    (void)fprintf(file, "%sint, a%d", (argument == 0) ? "" : ", ", argument);
+                }
+                (void)fprintf(file, ")");
+                for (test_case = 0; test_case < cases; test_case++)
+                {
+                    (void)fprintf(file, ",\n    CASE((");
+                    for (argument = 0; argument < arguments; argument++)
+                    {
+                        (void)fprintf(file, "%s%d", (argument == 0) ? "" : ", ", test_case + argument);
+                    }
+                    (void)fprintf(file, "), case_%d)", test_case);
+                }
+                (void)fprintf(file, ")\n{\n    ASSERT_ARE_EQUAL(int, a0, a0);\n}\n\n");
+            }
+        }
+
+        (void)fprintf(file, "END_TEST_SUITE(%s)\n", suite_name);
+
+        result = (ferror(file) != 0) ? MU_FAILURE : 0;
+        if (fclose(file) != 0)
+        {
+            result = MU_FAILURE;
+        }
+
+        if (result != 0)
+        {
+            LogError("failure writing %s", file_name);
+        }
+    }
+
+    return result;
+}
+
+/*runs command MACRO_COMPILE_PERF_REPETITIONS times and returns the fastest run in *elapsed_ns*/
+static int time_command(const char* command, double* elapsed_ns)
+{
+    int result = 0;
+    int repetition;
+    char quoted_command[MACRO_COMPILE_PERF_MAX_COMMAND + 2];
+
+#ifdef _WIN32
+    /*cmd.exe strips the first and last quote of the line*/
+    (void)snprintf(quoted_command, sizeof(quoted_command), "\"%s\"", command);
+#else
+    (void)snprintf(quoted_command, sizeof(quoted_command), "%s", command);
+#endif
+
+    *elapsed_ns = 0;
+    for (repetition = 0; (repetition < MACRO_COMPILE_PERF_REPETITIONS) && (result == 0); repetition++)
+    {
+        uint64_t start = ctrs_time_monotonic_ns();
+        int exit_code = system(quoted_command);
+        double elapsed = (double)(ctrs_time_monotonic_ns() - start);
+
+        if (exit_code != 0)
+        {
+            LogError("command failed with %d: %s", exit_code, command);
+            result = MU_FAILURE;
+        }
+        else if ((repetition == 0) || (elapsed < *elapsed_ns))
+        {
+            *elapsed_ns = elapsed;
+        }
+        else
+        {
+            /*slower than a previous run*/
+        }
+    }
+
+    return result;
+}
+
+static double file_size(const char* file_name)
+{
+    double result;
+    FILE* file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        LogError("failure in fopen(%s, \"rb\")", file_name);
+        result = -1;
+    }
+    else
+    {
+        result = ((fseek(file, 0, SEEK_END) == 0) ? (double)ftell(file) : -1);
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+static int apply_baseline(const char* configuration, const char* metric, double value)
+{
+    char name[256];
+    (void)snprintf(name, sizeof(name), "%s_%s", configuration, metric);
+    LogInfo("%s = %.0f", name, value);
+    return ctrs_perf_baseline_apply(name, value);
+}
+
+BEGIN_TEST_SUITE(macro_compile_perf)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+}
+
+PARAMETERIZED_TEST_FUNCTION(compile_cost, // no-srs
+    ARGS(int, tests, int, cases, int, arguments),
+    CASE((10, 0, 0), of_10_tests),
+    CASE((100, 0, 0), of_100_tests),
+    CASE((10, 4, 2), of_10_tests_4_cases_2_arguments),
+    CASE((10, 16, 2), of_10_tests_16_cases_2_arguments),
+    CASE((10, 4, 8), of_10_tests_4_cases_8_arguments),
+    CASE((50, 16, 8), of_50_tests_16_cases_8_arguments))
+{
+    ///arrange
+    char configuration[128];
+    char source_file[MACRO_COMPILE_PERF_MAX_PATH];
+    char preprocessed_file[MACRO_COMPILE_PERF_MAX_PATH];
+    char object_file[MACRO_COMPILE_PERF_MAX_PATH];
+    char library_file[MACRO_COMPILE_PERF_MAX_PATH];
+    char command[MACRO_COMPILE_PERF_MAX_COMMAND];
+    double preprocess_ns;
+    double compile_ns;
+    double link_ns;
+
+    (void)snprintf(configuration, sizeof(configuration), "macro_compile_perf_%d_tests_%d_cases_%d_arguments", tests, cases, arguments);
+    (void)snprintf(source_file, sizeof(source_file), "%s/%s.c", MACRO_COMPILE_PERF_WORK_DIR, configuration);
+    (void)snprintf(preprocessed_file, sizeof(preprocessed_file), "%s/%s.i", MACRO_COMPILE_PERF_WORK_DIR, configuration);
+    (void)snprintf(object_file, sizeof(object_file), "%s/%s" OBJECT_EXTENSION, MACRO_COMPILE_PERF_WORK_DIR, configuration);
+    (void)snprintf(library_file, sizeof(library_file), "%s/%s" LIBRARY_EXTENSION, MACRO_COMPILE_PERF_WORK_DIR, configuration);
+
+    ASSERT_ARE_EQUAL(int, 0, generate_suite(source_file, configuration, tests, cases, arguments));
+
+    ///act
+    (void)snprintf(command, sizeof(command), PREPROCESS_COMMAND_FORMAT, MACRO_COMPILE_PERF_COMPILER, MACRO_COMPILE_PERF_FLAGS_FILE, preprocessed_file, source_file);
+    ASSERT_ARE_EQUAL(int, 0, time_command(command, &preprocess_ns), "preprocessing %s", source_file);
+    (void)snprintf(command, sizeof(command), COMPILE_COMMAND_FORMAT, MACRO_COMPILE_PERF_COMPILER, MACRO_COMPILE_PERF_FLAGS_FILE, object_file, source_file);
+    ASSERT_ARE_EQUAL(int, 0, time_command(command, &compile_ns), "compiling %s", source_file);
+    (void)snprintf(command, sizeof(command), LINK_COMMAND_FORMAT, MACRO_COMPILE_PERF_COMPILER, object_file, library_file);
+    ASSERT_ARE_EQUAL(int, 0, time_command(command, &link_ns), "linking %s", object_file);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, apply_baseline(configuration, "preprocess_ns", preprocess_ns));
+    ASSERT_ARE_EQUAL(int, 0, apply_baseline(configuration, "compile_ns", compile_ns));
+    ASSERT_ARE_EQUAL(int, 0, apply_baseline(configuration, "link_ns", link_ns));
+    ASSERT_ARE_EQUAL(int, 0, apply_baseline(configuration, "preprocessed_bytes", file_size(preprocessed_file)));
+    ASSERT_ARE_EQUAL(int, 0, apply_baseline(configuration, "object_bytes", file_size(object_file)));
+
+    ///cleanup
+    (void)remove(source_file);
+    (void)remove(preprocessed_file);
+    (void)remove(object_file);
+    (void)remove(library_file);
+}
+
+END_TEST_SUITE(macro_compile_perf)
@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+#ifndef _WIN32
+#include "ctrs_time.h"
+
+#define HOLD_TIME_MS 200
+
+/*forks a child that acquires tags and exits with 0 if it waited (expect_wait) or did not wait (!expect_wait) for them*/
+static pid_t fork_acquiring_child(const char* const* tags, size_t tag_count, bool expect_wait)
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        /*suite scope, because a test scope acquire would first release the test locks the child inherited the bookkeeping of, the locks go away with the child*/
+        uint64_t start = ctrs_time_monotonic_ns();
+        int acquire_result = ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_SUITE, tags, tag_count);
+        uint64_t waited_ms = (ctrs_time_monotonic_ns() - start) / 1000000;
+        _exit((acquire_result != 0) ? 2 : (((waited_ms >= HOLD_TIME_MS / 2) == expect_wait) ? 0 : 3));
+    }
+    return child;
+}
+
+static int wait_for_child(pid_t child)
+{
+    int status;
+    return ((waitpid(child, &status, 0) == child) && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+}
+#endif
+
+BEGIN_TEST_SUITE(resource_lock_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    SUITE_RESOURCE_LOCK_ACQUIRE("resource_lock_ut_suite");
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    SUITE_RESOURCE_LOCK_RELEASE();
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+}
+
+TEST_FUNCTION(ctrs_resource_lock_acquire_with_NULL_tags_fails) // no-srs
+{
+    ///act
+    int result = ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, NULL, 1);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_resource_lock_acquire_with_0_tags_fails) // no-srs
+{
+    ///arrange
+    static const char* const tags[] = { "resource_lock_ut_a" };
+
+    ///act
+    int result = ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, tags, 0);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_resource_lock_acquire_with_an_empty_tag_fails) // no-srs
+{
+    ///arrange
+    static const char* const tags[] = { "resource_lock_ut_a", "" };
+
+    ///act
+    int result = ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, tags, 2);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(ctrs_resource_lock_acquire_with_several_tags_and_duplicates_succeeds) // no-srs
+{
+    ///arrange
+    static const char* const tags[] = { "resource_lock_ut_b", "resource_lock_ut_a", "resource_lock_ut_b" };
+
+    ///act
+    int result = ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, tags, 3);
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+RESOURCE_LOCKED_TEST_FUNCTION(RESOURCE_LOCKED_TEST_FUNCTION_runs_its_body, "resource_lock_ut_a") // no-srs
+{
+    ///assert
+    ASSERT_IS_TRUE(true);
+}
+
+#ifndef CPP_UNITTEST
+/*cppunittest runs its tests itself, nothing is registered for the stock runner to list*/
+TEST_FUNCTION(RESOURCE_LOCKED_TEST_FUNCTION_registers_its_tags) // no-srs
+{
+    ///act
+    const CTRS_TEST_RESOURCE_LOCKS* test_locks = ctrs_resource_lock_get_test_locks("RESOURCE_LOCKED_TEST_FUNCTION_runs_its_body");
+
+    ///assert
+    ASSERT_IS_NOT_NULL(test_locks);
+    ASSERT_ARE_EQUAL(size_t, 1, test_locks->tag_count);
+    ASSERT_ARE_EQUAL(char_ptr, "resource_lock_ut_a", test_locks->tags[0]);
+}
+
+TEST_FUNCTION(ctrs_resource_lock_get_test_locks_of_a_test_without_tags_returns_NULL) // no-srs
+{
+    ///act
+    const CTRS_TEST_RESOURCE_LOCKS* test_locks = ctrs_resource_lock_get_test_locks("RESOURCE_LOCKED_TEST_FUNCTION_registers_its_tags");
+
+    ///assert
+    ASSERT_IS_NULL(test_locks);
+}
+#endif
+
+#ifndef _WIN32
+TEST_FUNCTION(ctrs_resource_lock_acquire_waits_for_a_process_holding_a_shared_tag) // no-srs
+{
+    ///arrange
+    static const char* const parent_tags[] = { "resource_lock_ut_a" };
+    static const char* const child_tags[] = { "resource_lock_ut_b", "resource_lock_ut_a" };
+    ASSERT_ARE_EQUAL(int, 0, ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, parent_tags, 1));
+
+    ///act
+    pid_t child = fork_acquiring_child(child_tags, 2, true);
+    ASSERT_IS_TRUE(child >= 0);
+    (void)usleep(HOLD_TIME_MS * 1000);
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, wait_for_child(child));
+}
+
+TEST_FUNCTION(ctrs_resource_lock_acquire_does_not_wait_for_a_process_holding_disjoint_tags) // no-srs
+{
+    ///arrange
+    static const char* const parent_tags[] = { "resource_lock_ut_a" };
+    static const char* const child_tags[] = { "resource_lock_ut_b" };
+    ASSERT_ARE_EQUAL(int, 0, ctrs_resource_lock_acquire(CTRS_RESOURCE_LOCK_SCOPE_TEST, parent_tags, 1));
+
+    ///act
+    pid_t child = fork_acquiring_child(child_tags, 1, false);
+    ASSERT_IS_TRUE(child >= 0);
+    int result = wait_for_child(child);
+    ctrs_resource_lock_release(CTRS_RESOURCE_LOCK_SCOPE_TEST);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+#endif
+
+END_TEST_SUITE(resource_lock_ut)
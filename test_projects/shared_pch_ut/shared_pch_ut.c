@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include "testrunnerswitcher.h"
+
+/*the suite takes its name from cmake, while the precompiled header the lib reuses was built without that name*/
+BEGIN_TEST_SUITE(TEST_SUITE_NAME_FROM_CMAKE)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+}
+
+TEST_FUNCTION(the_suite_name_from_cmake_is_the_name_of_the_test_project)
+{
+    ///arrange
+    const char* suite_name;
+
+    ///act
+    suite_name = MU_TOSTRING(TEST_SUITE_NAME_FROM_CMAKE);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "shared_pch_ut", suite_name);
+}
+
+END_TEST_SUITE(TEST_SUITE_NAME_FROM_CMAKE)
@@ -0,0 +1,86 @@
+#Copyright (c) Microsoft. All rights reserved.
+#Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#run by ctest from the directory of the exe as
+#   cmake -D TEST_EXE=<stock_runner_ut exe> -P check_report.cmake
+#it runs the suite with --report and checks the JUnit files it writes: one testcase per test with the failures where they belong, and one
+#file per shard when the shards are given the same file.
+
+#the testcases of report_file: every "name" in out_names, every name of a testcase with a <failure> or <error> in out_failed_names
+function(read_report report_file out_names out_failed_names)
+    if(NOT EXISTS ${report_file})
+        message(FATAL_ERROR "the report ${report_file} was not written")
+    endif()
+    file(READ ${report_file} report)
+    string(REPLACE ";" "," report "${report}")
+    string(REPLACE "</testcase>" ";" testcases "${report}")
+    set(names)
+    set(failed_names)
+    foreach(testcase IN LISTS testcases)
+        if(testcase MATCHES "<testcase classname=\"[^\"]*\" name=\"([^\"]*)\"")
+            set(name ${CMAKE_MATCH_1})
+            list(APPEND names ${name})
+            if((testcase MATCHES "<failure ") OR (testcase MATCHES "<error "))
+                list(APPEND failed_names ${name})
+            endif()
+        endif()
+    endforeach()
+    set(${out_names} ${names} PARENT_SCOPE)
+    set(${out_failed_names} ${failed_names} PARENT_SCOPE)
+endfunction()
+
+function(expect_count what list expected)
+    list(LENGTH list count)
+    if(NOT count EQUAL expected)
+        message(FATAL_ERROR "expected ${expected} ${what}, the report has ${count}: ${list}")
+    endif()
+endfunction()
+
+set(all_test_count 6)
+
+#a passing run: every test, no failure
+file(REMOVE check_report.xml)
+execute_process(COMMAND ${TEST_EXE} --jobs 2 --report check_report.xml RESULT_VARIABLE exit_code)
+if(NOT exit_code EQUAL 0)
+    message(FATAL_ERROR "the run with --report failed (${exit_code})")
+endif()
+read_report(check_report.xml names failed_names)
+expect_count("testcases" "${names}" ${all_test_count})
+expect_count("failed testcases" "${failed_names}" 0)
+file(READ check_report.xml report)
+if(NOT report MATCHES "tests=\"${all_test_count}\" failures=\"0\" errors=\"0\"")
+    message(FATAL_ERROR "the testsuite of check_report.xml does not count ${all_test_count} tests and no failure")
+endif()
+
+#a crashing test is the only failure of its run
+if(NOT CMAKE_HOST_WIN32)
+    file(REMOVE check_report_crash.xml)
+    set(ENV{STOCK_RUNNER_UT_CRASH} 1)
+    execute_process(COMMAND ${TEST_EXE} --fork --report check_report_crash.xml RESULT_VARIABLE exit_code)
+    unset(ENV{STOCK_RUNNER_UT_CRASH})
+    if(exit_code EQUAL 0)
+        message(FATAL_ERROR "the run with a crashing test passed")
+    endif()
+    read_report(check_report_crash.xml names failed_names)
+    expect_count("testcases" "${names}" ${all_test_count})
+    if(NOT failed_names STREQUAL "stock_runner_fork_isolates_a_crashing_test")
+        message(FATAL_ERROR "expected only stock_runner_fork_isolates_a_crashing_test to fail, the report has: ${failed_names}")
+    endif()
+endif()
+
+#the shards given the same file write one file each, together they have every test once
+set(shard_names)
+foreach(shard 0 1)
+    file(REMOVE check_report_shards_shard_${shard}_of_2.xml)
+    execute_process(COMMAND ${TEST_EXE} --shard ${shard}/2 --report check_report_shards.xml RESULT_VARIABLE exit_code)
+    if(NOT exit_code EQUAL 0)
+        message(FATAL_ERROR "shard ${shard} of 2 failed (${exit_code})")
+    endif()
+    read_report(check_report_shards_shard_${shard}_of_2.xml names failed_names)
+    list(APPEND shard_names ${names})
+endforeach()
+expect_count("testcases in the 2 shards" "${shard_names}" ${all_test_count})
+list(REMOVE_DUPLICATES shard_names)
+expect_count("distinct testcases in the 2 shards" "${shard_names}" ${all_test_count})
+
+message(STATUS "the reports of stock_runner_ut are as expected")
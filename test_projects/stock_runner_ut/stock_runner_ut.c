@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+/* These tests are run by the stock main both serially and with the runner options (see CMakeLists.txt), the fixtures check that every test runs between its own function initialize and cleanup */
+static int g_suite_initialized;
+static int g_function_initialized;
+
+BEGIN_TEST_SUITE(stock_runner_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    g_suite_initialized = 1;
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    ASSERT_ARE_EQUAL(int, 0, g_function_initialized);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    ASSERT_ARE_EQUAL(int, 1, g_suite_initialized);
+    ASSERT_ARE_EQUAL(int, 0, g_function_initialized);
+    g_function_initialized = 1;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    g_function_initialized = 0;
+}
+
+TEST_FUNCTION(stock_runner_runs_test_1_with_fixtures) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+}
+
+TEST_FUNCTION(stock_runner_runs_test_2_with_fixtures) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+}
+
+TEST_FUNCTION(stock_runner_runs_test_3_with_fixtures) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+}
+
+TEST_FUNCTION(stock_runner_runs_test_4_with_fixtures) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+}
+
+/*STOCK_RUNNER_UT_CRASH is only set for the run with --fork (see CMakeLists.txt), where the crash fails this test alone*/
+TEST_FUNCTION(stock_runner_fork_isolates_a_crashing_test) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+    if (getenv("STOCK_RUNNER_UT_CRASH") != NULL)
+    {
+        abort();
+    }
+}
+
+/*STOCK_RUNNER_UT_HANG is only set for the runs that check the watchdog (see CMakeLists.txt), which fails this test alone after 2 seconds*/
+TEST_FUNCTION_TIMEOUT(stock_runner_watchdog_stops_a_hanging_test, 2)
+TEST_FUNCTION(stock_runner_watchdog_stops_a_hanging_test) // no-srs // no-aaa
+{
+    ASSERT_ARE_EQUAL(int, 1, g_function_initialized);
+#ifndef _WIN32
+    while (getenv("STOCK_RUNNER_UT_HANG") != NULL)
+    {
+        (void)sleep(1);
+    }
+#endif
+}
+
+END_TEST_SUITE(stock_runner_ut)
@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef CPPUNITTEST_SYMBOL
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void CPPUNITTEST_SYMBOL(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*CPPUNITTEST_SYMBOL*/
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+#ifndef _WIN32
+#include "ctrs_time.h"
+
+#define HOLD_TIME_MS 200
+#endif
+
+BEGIN_TEST_SUITE(testmutex_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+#ifndef _WIN32
+    /*a name of its own, so that this suite does not wait for other suites using the default test mutex*/
+    ASSERT_ARE_EQUAL(int, 0, setenv(TESTMUTEX_NAME_ENV, "testmutex_ut", 1));
+#endif
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+}
+
+TEST_FUNCTION(TEST_MUTEX_can_be_acquired_and_released) // no-srs
+{
+    ///arrange
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(mutex);
+
+    ///act
+    int result = TEST_MUTEX_ACQUIRE(mutex);
+    TEST_MUTEX_RELEASE(mutex);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+TEST_FUNCTION(TEST_MUTEX_can_be_acquired_again_by_the_same_thread) // no-srs
+{
+    ///arrange
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(mutex);
+
+    ///act
+    int result_1 = TEST_MUTEX_ACQUIRE(mutex);
+    int result_2 = TEST_MUTEX_ACQUIRE(mutex);
+    TEST_MUTEX_RELEASE(mutex);
+    TEST_MUTEX_RELEASE(mutex);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+
+    ///cleanup
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+#ifndef _WIN32
+/*forks a child that waits for a byte on pipe_fds, then acquires the test mutex and reports (as exit code) whether it had to wait*/
+static pid_t fork_waiting_child(int pipe_fds[2])
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        char go;
+        uint64_t start;
+        TEST_MUTEX_HANDLE child_mutex;
+        int acquire_result;
+        uint64_t waited_ms;
+
+        (void)close(pipe_fds[1]);
+        if (read(pipe_fds[0], &go, 1) != 1)
+        {
+            _exit(1);
+        }
+
+        start = ctrs_time_monotonic_ns();
+        child_mutex = TEST_MUTEX_CREATE();
+        acquire_result = (child_mutex == NULL) ? 1 : TEST_MUTEX_ACQUIRE(child_mutex);
+        waited_ms = (ctrs_time_monotonic_ns() - start) / 1000000;
+        _exit((acquire_result != 0) ? 2 : ((waited_ms >= HOLD_TIME_MS / 2) ? 0 : 3));
+    }
+    (void)close(pipe_fds[0]);
+    return child;
+}
+
+TEST_FUNCTION(TEST_MUTEX_serializes_processes) // no-srs
+{
+    ///arrange
+    int pipe_fds[2];
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(mutex);
+    ASSERT_ARE_EQUAL(int, 0, pipe(pipe_fds));
+
+    /*forked before the parent acquires the mutex, so that the child does not run on behalf of the holder*/
+    pid_t child = fork_waiting_child(pipe_fds);
+    ASSERT_IS_TRUE(child >= 0);
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, TEST_MUTEX_ACQUIRE(mutex));
+    ASSERT_ARE_EQUAL(int, 1, (int)write(pipe_fds[1], "g", 1));
+    (void)close(pipe_fds[1]);
+
+    (void)usleep(HOLD_TIME_MS * 1000);
+    TEST_MUTEX_RELEASE(mutex);
+
+    int status;
+    ASSERT_ARE_EQUAL(int, (int)child, (int)waitpid(child, &status, 0));
+
+    ///assert
+    ASSERT_IS_TRUE(WIFEXITED(status));
+    ASSERT_ARE_EQUAL(int, 0, WEXITSTATUS(status));
+
+    ///cleanup
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+TEST_FUNCTION(TEST_MUTEX_held_by_the_parent_is_entered_by_a_forked_child_without_waiting) // no-srs
+{
+    ///arrange
+    int pipe_fds[2];
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(mutex);
+    ASSERT_ARE_EQUAL(int, 0, pipe(pipe_fds));
+    pid_t other_process = fork_waiting_child(pipe_fds);
+    ASSERT_IS_TRUE(other_process >= 0);
+    ASSERT_ARE_EQUAL(int, 0, TEST_MUTEX_ACQUIRE(mutex));
+
+    ///act
+    pid_t child = fork();
+    ASSERT_IS_TRUE(child >= 0);
+    if (child == 0)
+    {
+        /*the parent waits for this child while holding the mutex, a child waiting for the mutex would never end (alarm kills it then)*/
+        int acquire_result;
+        int release_result;
+        (void)alarm(10);
+        acquire_result = TEST_MUTEX_ACQUIRE(mutex);
+        release_result = (acquire_result != 0) ? 1 : TEST_MUTEX_RELEASE(mutex);
+        _exit((acquire_result != 0) ? 2 : ((release_result != 0) ? 3 : 0));
+    }
+
+    int status;
+    ASSERT_ARE_EQUAL(int, (int)child, (int)waitpid(child, &status, 0));
+
+    /*the release of the child left the mutex with the parent, the other process still has to wait for it*/
+    int other_status;
+    ASSERT_ARE_EQUAL(int, 1, (int)write(pipe_fds[1], "g", 1));
+    (void)close(pipe_fds[1]);
+    (void)usleep(HOLD_TIME_MS * 1000);
+    TEST_MUTEX_RELEASE(mutex);
+    ASSERT_ARE_EQUAL(int, (int)other_process, (int)waitpid(other_process, &other_status, 0));
+
+    ///assert
+    ASSERT_IS_TRUE(WIFEXITED(status));
+    ASSERT_ARE_EQUAL(int, 0, WEXITSTATUS(status));
+    ASSERT_IS_TRUE(WIFEXITED(other_status));
+    ASSERT_ARE_EQUAL(int, 0, WEXITSTATUS(other_status));
+
+    ///cleanup
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+TEST_FUNCTION(TEST_MUTEX_without_name_does_not_serialize_processes) // no-srs
+{
+    ///arrange
+    ASSERT_ARE_EQUAL(int, 0, unsetenv(TESTMUTEX_NAME_ENV));
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_ARE_EQUAL(int, 0, setenv(TESTMUTEX_NAME_ENV, "testmutex_ut", 1));
+    ASSERT_IS_NOT_NULL(mutex);
+    ASSERT_ARE_EQUAL(int, 0, TEST_MUTEX_ACQUIRE(mutex));
+
+    ///act
+    pid_t child = fork();
+    ASSERT_IS_TRUE(child >= 0);
+    if (child == 0)
+    {
+        /*the child has its own (inherited, released) copy of the mutex and gets it right away*/
+        uint64_t start = ctrs_time_monotonic_ns();
+        int acquire_result = TEST_MUTEX_ACQUIRE(mutex);
+        uint64_t waited_ms = (ctrs_time_monotonic_ns() - start) / 1000000;
+        _exit((acquire_result != 0) ? 2 : ((waited_ms < HOLD_TIME_MS / 2) ? 0 : 3));
+    }
+
+    int status;
+    ASSERT_ARE_EQUAL(int, (int)child, (int)waitpid(child, &status, 0));
+    TEST_MUTEX_RELEASE(mutex);
+
+    ///assert
+    ASSERT_IS_TRUE(WIFEXITED(status));
+    ASSERT_ARE_EQUAL(int, 0, WEXITSTATUS(status));
+
+    ///cleanup
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+TEST_FUNCTION(TEST_MUTEX_is_released_when_the_holding_process_dies) // no-srs
+{
+    ///arrange
+    int pipe_fds[2];
+    char acquired;
+    ASSERT_ARE_EQUAL(int, 0, pipe(pipe_fds));
+
+    pid_t child = fork();
+    ASSERT_IS_TRUE(child >= 0);
+    if (child == 0)
+    {
+        /*the child takes the mutex and dies without releasing it*/
+        TEST_MUTEX_HANDLE child_mutex = TEST_MUTEX_CREATE();
+        if ((child_mutex != NULL) && (TEST_MUTEX_ACQUIRE(child_mutex) == 0))
+        {
+            (void)write(pipe_fds[1], "a", 1);
+        }
+        abort();
+    }
+    (void)close(pipe_fds[1]);
+    ASSERT_ARE_EQUAL(int, 1, (int)read(pipe_fds[0], &acquired, 1));
+    (void)close(pipe_fds[0]);
+
+    int status;
+    ASSERT_ARE_EQUAL(int, (int)child, (int)waitpid(child, &status, 0));
+
+    TEST_MUTEX_HANDLE mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(mutex);
+
+    ///act
+    int result = TEST_MUTEX_ACQUIRE(mutex);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    TEST_MUTEX_RELEASE(mutex);
+    TEST_MUTEX_DESTROY(mutex);
+}
+
+TEST_FUNCTION(testmutex_create_named_with_a_slash_shares_the_mutex_of_the_same_lock_file) // no-srs
+{
+    ///arrange
+    TEST_MUTEX_HANDLE with_slash = testmutex_create_named("testmutex_ut/shared");
+    ASSERT_IS_NOT_NULL(with_slash);
+
+    ///act
+    TEST_MUTEX_HANDLE with_underscore = testmutex_create_named("testmutex_ut_shared");
+
+    ///assert
+    /*one fd per lock file, closing a second one would drop the lock held through the first*/
+    ASSERT_IS_TRUE(with_slash == with_underscore);
+    ASSERT_ARE_EQUAL(int, 0, testmutex_acquire(with_slash));
+    testmutex_destroy(with_underscore);
+    ASSERT_ARE_EQUAL(int, 0, testmutex_release(with_slash));
+
+    ///cleanup
+    testmutex_destroy(with_slash);
+}
+
+static void* release_from_other_thread(void* context)
+{
+    static int result;
+    result = testmutex_release((TEST_MUTEX_HANDLE)context);
+    return &result;
+}
+
+TEST_FUNCTION(testmutex_release_by_a_thread_that_does_not_hold_the_mutex_fails) // no-srs
+{
+    ///arrange
+    pthread_t thread;
+    void* thread_result;
+    TEST_MUTEX_HANDLE mutex = testmutex_create_named("testmutex_ut_not_owner");
+    ASSERT_IS_NOT_NULL(mutex);
+    ASSERT_ARE_EQUAL(int, 0, testmutex_acquire(mutex));
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, pthread_create(&thread, NULL, release_from_other_thread, mutex));
+    ASSERT_ARE_EQUAL(int, 0, pthread_join(thread, &thread_result));
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, *(int*)thread_result);
+    /*the mutex is still held once by this thread*/
+    ASSERT_ARE_EQUAL(int, 0, testmutex_release(mutex));
+    ASSERT_ARE_NOT_EQUAL(int, 0, testmutex_release(mutex));
+
+    ///cleanup
+    testmutex_destroy(mutex);
+}
+#endif
+
+END_TEST_SUITE(testmutex_ut)